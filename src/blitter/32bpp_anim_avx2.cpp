@@ -0,0 +1,262 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_anim_avx2.cpp Implementation of the AVX2 32 bpp blitter with animation support. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../video/video_driver.hpp"
+#include "../table/sprites.h"
+#include "32bpp_anim_avx2.hpp"
+#include "32bpp_avx2_func.hpp"
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2_Anim iFBlitter_32bppAVX2_Anim;
+
+/**
+ * Replace the colours of pixels with an animated palette index by the current colour of that index.
+ * @param[in,out] pixels The pixels; their alpha is kept.
+ * @param mv The map values of the pixels.
+ */
+static inline TARGET_AVX2 void AnimateEightPixels(__m256i &pixels, __m128i mv)
+{
+	const __m128i animated = _mm_cmpgt_epi16(_mm_and_si128(mv, _mm_set1_epi16(0x00FF)), _mm_set1_epi16(PALETTE_ANIM_START - 1));
+	if (_mm_testz_si128(animated, animated)) return;
+
+	ALIGN(32) uint32 colours[AVX2_BLOCK_SIZE];
+	ALIGN(16) uint16 values[AVX2_BLOCK_SIZE];
+	_mm256_store_si256((__m256i *) colours, pixels);
+	_mm_store_si128((__m128i *) values, mv);
+	for (uint i = 0; i < AVX2_BLOCK_SIZE; i++) {
+		const uint m = GB(values[i], 0, 8);
+		if (m < PALETTE_ANIM_START) continue;
+
+		Colour colour = Blitter_32bppBase::AdjustBrightness(Blitter_32bppBase::LookupColourInPalette(m), GB(values[i], 8, 8));
+		colour.a = Colour(colours[i]).a;
+		colours[i] = colour.data;
+	}
+	pixels = _mm256_load_si256((const __m256i *) colours);
+}
+
+/**
+ * Draws a block of up to eight pixels of a line of a sprite, and updates the animation buffer.
+ *
+ * @tparam mode blitter mode
+ * @tparam translucent whether the sprite has pixels which are neither fully transparent nor fully opaque
+ * @tparam animated whether the sprite has pixels with an animated palette index
+ * @tparam tail whether the block has less than #AVX2_BLOCK_SIZE pixels
+ * @param dst first pixel to draw on
+ * @param anim first value of the animation buffer to update
+ * @param src first pixel of the sprite
+ * @param src_mv map value of the first pixel of the sprite
+ * @param n number of pixels in the block
+ * @param remap the remap table
+ */
+template <BlitterMode mode, bool translucent, bool animated, bool tail>
+static inline TARGET_AVX2 void DrawBlockAVX2Anim(Colour *dst, uint16 *anim, const Colour *src, const Blitter_32bppSSE_Base::MapValue *src_mv, uint n, const byte *remap)
+{
+	const __m256i mask = tail ? AVX2TailMask(n) : _mm256_setzero_si256();
+	__m256i srcV = AVX2LoadPixels<tail>(src, mask);
+
+	/* Nothing to do for a block without any visible pixel; this includes the parts of the line the margin did not cover. */
+	const __m256i alpha = _mm256_and_si256(srcV, AVX2_ALPHA_MASK);
+	if (_mm256_testz_si256(alpha, alpha)) return;
+
+	const __m256i dstV = AVX2LoadPixels<tail>(dst, mask);
+	const __m256i transparent = _mm256_cmpeq_epi32(alpha, _mm256_setzero_si256());
+
+	/* Animation buffer values are kept for transparent pixels, reset for partially transparent ones and set for opaque ones. */
+	const __m128i alpha16 = AVX2GetAlpha16(srcV);
+	const __m128i keep_anim = _mm_cmpeq_epi16(alpha16, _mm_setzero_si128());
+	const __m128i set_anim = _mm_cmpeq_epi16(alpha16, _mm_set1_epi16(255));
+	const __m128i old_anim = AVX2LoadUint16<tail>(anim, n);
+	__m128i new_anim = _mm_setzero_si128();
+
+	switch (mode) {
+		default: {
+			if (animated) {
+				const __m128i mv = AVX2LoadUint16<tail>(src_mv, n);
+				AnimateEightPixels(srcV, mv);
+				new_anim = _mm_and_si128(mv, set_anim);
+			}
+			AVX2StoreUint16<tail>(anim, n, _mm_blendv_epi8(new_anim, old_anim, keep_anim));
+			if (!translucent) {
+				AVX2StorePixels<tail>(dst, mask, _mm256_blendv_epi8(srcV, dstV, transparent));
+				break;
+			}
+			AVX2StorePixels<tail>(dst, mask, DrawEightPixels(srcV, dstV));
+			break;
+		}
+
+		case BM_COLOUR_REMAP: {
+			const __m128i mv = AVX2LoadUint16<tail>(src_mv, n);
+			if (animated) {
+				RemapEightPixels<true>(srcV, mv, remap, &new_anim);
+				new_anim = _mm_and_si128(new_anim, set_anim);
+			} else {
+				RemapEightPixels<false>(srcV, mv, remap);
+			}
+			AVX2StoreUint16<tail>(anim, n, _mm_blendv_epi8(new_anim, old_anim, keep_anim));
+			AVX2StorePixels<tail>(dst, mask, DrawEightPixels(srcV, dstV));
+			break;
+		}
+
+		case BM_TRANSPARENT:
+			/* Make the current colour a bit more black, so it looks like this image is transparent. */
+			AVX2StoreUint16<tail>(anim, n, _mm_and_si128(old_anim, keep_anim));
+			AVX2StorePixels<tail>(dst, mask, DarkenEightPixels(srcV, dstV));
+			break;
+
+		case BM_CRASH_REMAP: {
+			const __m128i mv = AVX2LoadUint16<tail>(src_mv, n);
+			if (_mm_testz_si128(mv, _mm_set1_epi16(0x00FF))) {
+				AVX2StoreUint16<tail>(anim, n, _mm_and_si128(old_anim, keep_anim));
+				AVX2StorePixels<tail>(dst, mask, DrawEightPixels(MakeDarkEightPixels(srcV), dstV));
+				break;
+			}
+
+			/* Remapped pixels are rare, so just do those blocks pixel by pixel. */
+			for (uint i = 0; i < n; i++) {
+				if (src_mv[i].m == 0) {
+					if (src[i].a != 0) {
+						uint8 g = Blitter_32bppBase::MakeDark(src[i].r, src[i].g, src[i].b);
+						dst[i] = Blitter_32bppBase::ComposeColourRGBA(g, g, g, src[i].a, dst[i]);
+						anim[i] = 0;
+					}
+				} else {
+					uint r = remap[src_mv[i].m];
+					if (r != 0) dst[i] = Blitter_32bppBase::ComposeColourPANoCheck(Blitter_32bppBase::AdjustBrightness(Blitter_32bppBase::LookupColourInPalette(r), src_mv[i].v), src[i].a, dst[i]);
+				}
+			}
+			break;
+		}
+
+		case BM_BLACK_REMAP:
+			AVX2StoreUint16<tail>(anim, n, _mm_and_si128(old_anim, keep_anim));
+			AVX2StorePixels<tail>(dst, mask, _mm256_blendv_epi8(AVX2_ALPHA_MASK, dstV, transparent));
+			break;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. It is templated to allow faster operation.
+ *
+ * @tparam mode blitter mode
+ * @tparam read_mode how to skip the transparent pixels at the start and end of the lines
+ * @tparam translucent whether the sprite has pixels which are neither fully transparent nor fully opaque
+ * @tparam animated whether the sprite has pixels with an animated palette index
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent, bool animated>
+inline TARGET_AVX2 void Blitter_32bppAVX2_Anim::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	const byte * const remap = bp->remap;
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	uint16 *anim_line = this->anim_buf + this->ScreenToAnimOffset((uint32 *)bp->dst) + bp->top * this->anim_buf_pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const Blitter_32bppSSE_Base::SpriteData * const sd = (const Blitter_32bppSSE_Base::SpriteData *) bp->sprite;
+	const SpriteInfo * const si = &sd->infos[zoom];
+	const MapValue *src_mv_line = (const MapValue *) &sd->data[si->mv_offset] + bp->skip_top * si->sprite_width;
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+
+	if (read_mode != RM_WITH_MARGIN) {
+		src_rgba_line += bp->skip_left;
+		src_mv_line += bp->skip_left;
+	}
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+		const MapValue *src_mv = src_mv_line;
+		uint16 *anim = anim_line;
+
+		if (read_mode == RM_WITH_MARGIN) {
+			anim += src_rgba_line[0].data;
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			src_mv += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+		}
+
+		int x = effective_width;
+		for (; x >= (int) AVX2_BLOCK_SIZE; x -= AVX2_BLOCK_SIZE) {
+			DrawBlockAVX2Anim<mode, translucent, animated, false>(dst, anim, src, src_mv, AVX2_BLOCK_SIZE, remap);
+			src += AVX2_BLOCK_SIZE;
+			src_mv += AVX2_BLOCK_SIZE;
+			dst += AVX2_BLOCK_SIZE;
+			anim += AVX2_BLOCK_SIZE;
+		}
+		if (x > 0) DrawBlockAVX2Anim<mode, translucent, animated, true>(dst, anim, src, src_mv, x, remap);
+
+		src_mv_line += si->sprite_width;
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+		anim_line += this->anim_buf_pitch;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2_Anim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	const BlitterSpriteFlags sprite_flags = ((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags;
+	switch (mode) {
+		default: {
+bm_normal:
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_SKIP, true, false>(bp, zoom);
+					else                           Draw<BM_NORMAL, RM_WITH_SKIP, true, true>(bp, zoom);
+				} else {
+					if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_SKIP, false, false>(bp, zoom);
+					else                           Draw<BM_NORMAL, RM_WITH_SKIP, false, true>(bp, zoom);
+				}
+			} else {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_MARGIN, true, false>(bp, zoom);
+					else                           Draw<BM_NORMAL, RM_WITH_MARGIN, true, true>(bp, zoom);
+				} else {
+					if (sprite_flags & SF_NO_ANIM) Draw<BM_NORMAL, RM_WITH_MARGIN, false, false>(bp, zoom);
+					else                           Draw<BM_NORMAL, RM_WITH_MARGIN, false, true>(bp, zoom);
+				}
+			}
+			break;
+		}
+		case BM_COLOUR_REMAP:
+			if (sprite_flags & SF_NO_REMAP) goto bm_normal;
+			if (bp->skip_left != 0 || bp->width <= MARGIN_REMAP_THRESHOLD) {
+				if (sprite_flags & SF_NO_ANIM) Draw<BM_COLOUR_REMAP, RM_WITH_SKIP, true, false>(bp, zoom);
+				else                           Draw<BM_COLOUR_REMAP, RM_WITH_SKIP, true, true>(bp, zoom);
+			} else {
+				if (sprite_flags & SF_NO_ANIM) Draw<BM_COLOUR_REMAP, RM_WITH_MARGIN, true, false>(bp, zoom);
+				else                           Draw<BM_COLOUR_REMAP, RM_WITH_MARGIN, true, true>(bp, zoom);
+			}
+			break;
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT, RM_NONE, true, true>(bp, zoom); return;
+		case BM_CRASH_REMAP:  Draw<BM_CRASH_REMAP, RM_NONE, true, true>(bp, zoom); return;
+		case BM_BLACK_REMAP:  Draw<BM_BLACK_REMAP, RM_NONE, true, true>(bp, zoom); return;
+	}
+}
+
+#endif /* WITH_SSE */
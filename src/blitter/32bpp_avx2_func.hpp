@@ -0,0 +1,239 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2_func.hpp Functions related to AVX2 32 bpp blitter. */
+
+#ifndef BLITTER_32BPP_AVX2_FUNC_HPP
+#define BLITTER_32BPP_AVX2_FUNC_HPP
+
+#ifdef WITH_SSE
+
+#include "../cpu.h"
+#include <immintrin.h>
+
+/** Number of pixels handled in a single step. */
+static const uint AVX2_BLOCK_SIZE = 8;
+
+#define AVX2_ALPHA_CONTROL_MASK _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1, 6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1)
+#define AVX2_ALPHA_MASK         _mm256_set1_epi32(0xFF000000)
+#define AVX2_LOW_BYTE_MASK      _mm256_set1_epi16(0x00FF)
+
+/**
+ * Get the mask for the first \a n pixels of a block.
+ * @param n Number of pixels, less than #AVX2_BLOCK_SIZE.
+ * @return Mask with all bits set for the first \a n pixels.
+ */
+static inline TARGET_AVX2 __m256i AVX2TailMask(uint n)
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * Load a block of pixels.
+ * @tparam tail Whether the block is not complete, in which case only the pixels in \a mask are read.
+ * @param p First pixel.
+ * @param mask Pixels to read, see #AVX2TailMask.
+ * @return The pixels, zero beyond the end of the block.
+ */
+template <bool tail>
+static inline TARGET_AVX2 __m256i AVX2LoadPixels(const Colour *p, const __m256i &mask)
+{
+	return tail ? _mm256_maskload_epi32((const int *) p, mask) : _mm256_loadu_si256((const __m256i *) p);
+}
+
+/**
+ * Store a block of pixels.
+ * @tparam tail Whether the block is not complete, in which case only the pixels in \a mask are written.
+ * @param p First pixel.
+ * @param mask Pixels to write, see #AVX2TailMask.
+ * @param pixels The pixels.
+ */
+template <bool tail>
+static inline TARGET_AVX2 void AVX2StorePixels(Colour *p, const __m256i &mask, __m256i pixels)
+{
+	if (tail) {
+		_mm256_maskstore_epi32((int *) p, mask, pixels);
+	} else {
+		_mm256_storeu_si256((__m256i *) p, pixels);
+	}
+}
+
+/**
+ * Load the 16 bits values of a block, like map values or the animation buffer.
+ * @tparam tail Whether the block is not complete.
+ * @param p First value.
+ * @param n Number of values in the block.
+ * @return The values, zero beyond the end of the block.
+ */
+template <bool tail>
+static inline TARGET_AVX2 __m128i AVX2LoadUint16(const void *p, uint n)
+{
+	if (!tail) return _mm_loadu_si128((const __m128i *) p);
+
+	um128i values;
+	values.m128i = _mm_setzero_si128();
+	memcpy(values.m128i_u16, p, n * sizeof(uint16));
+	return values.m128i;
+}
+
+/**
+ * Store the 16 bits values of a block, like the animation buffer.
+ * @tparam tail Whether the block is not complete.
+ * @param p First value.
+ * @param n Number of values in the block.
+ * @param values The values.
+ */
+template <bool tail>
+static inline TARGET_AVX2 void AVX2StoreUint16(void *p, uint n, __m128i values)
+{
+	if (!tail) {
+		_mm_storeu_si128((__m128i *) p, values);
+		return;
+	}
+
+	um128i v;
+	v.m128i = values;
+	memcpy(p, v.m128i_u16, n * sizeof(uint16));
+}
+
+/**
+ * Get the alpha of each pixel of a block as 16 bits values, in the same order as the animation buffer.
+ * @param pixels The pixels.
+ * @return The alpha values.
+ */
+static inline TARGET_AVX2 __m128i AVX2GetAlpha16(__m256i pixels)
+{
+	const __m256i alpha = _mm256_srli_epi32(pixels, 24);
+	return _mm_packus_epi32(_mm256_castsi256_si128(alpha), _mm256_extracti128_si256(alpha, 1));
+}
+
+/**
+ * Alpha blend eight pixels: a*(r - Cr)/256 + Cr for every channel, the alpha of the destination is kept.
+ * The calculation is done modulo 256, which gives the right result as the blended value always fits in a byte.
+ * @param src Pixels to draw.
+ * @param dst Pixels to draw on.
+ * @return The blended pixels.
+ */
+static inline TARGET_AVX2 __m256i AlphaBlendEightPixels(__m256i src, __m256i dst)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha_cm = AVX2_ALPHA_CONTROL_MASK;
+	const __m256i low_byte = AVX2_LOW_BYTE_MASK;
+
+	__m256i src_lo = _mm256_unpacklo_epi8(src, zero);
+	__m256i src_hi = _mm256_unpackhi_epi8(src, zero);
+	const __m256i dst_lo = _mm256_unpacklo_epi8(dst, zero);
+	const __m256i dst_hi = _mm256_unpackhi_epi8(dst, zero);
+
+	/* if (alpha > 0) a++; */
+	const __m256i alpha_lo = _mm256_shuffle_epi8(_mm256_sub_epi16(src_lo, _mm256_cmpgt_epi16(src_lo, zero)), alpha_cm);
+	const __m256i alpha_hi = _mm256_shuffle_epi8(_mm256_sub_epi16(src_hi, _mm256_cmpgt_epi16(src_hi, zero)), alpha_cm);
+
+	src_lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(src_lo, dst_lo), alpha_lo), 8), dst_lo);
+	src_hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(src_hi, dst_hi), alpha_hi), 8), dst_hi);
+	return _mm256_packus_epi16(_mm256_and_si256(src_lo, low_byte), _mm256_and_si256(src_hi, low_byte));
+}
+
+/**
+ * Draw eight pixels, skipping the work for blocks which are fully transparent or fully opaque.
+ * @param src Pixels to draw.
+ * @param dst Pixels to draw on.
+ * @return The resulting pixels.
+ */
+static inline TARGET_AVX2 __m256i DrawEightPixels(__m256i src, __m256i dst)
+{
+	const __m256i alpha = _mm256_and_si256(src, AVX2_ALPHA_MASK);
+	if (_mm256_testz_si256(alpha, alpha)) return dst;
+	if (_mm256_testc_si256(alpha, AVX2_ALPHA_MASK)) return src;
+	return AlphaBlendEightPixels(src, dst);
+}
+
+/**
+ * Darken eight pixels: rgb = rgb * ((256/4) * 4 - (alpha/4)) / ((256/4) * 4).
+ * @param src Pixels of which the alpha determines the darkening.
+ * @param dst Pixels to darken.
+ * @return The darkened pixels.
+ */
+static inline TARGET_AVX2 __m256i DarkenEightPixels(__m256i src, __m256i dst)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha_cm = AVX2_ALPHA_CONTROL_MASK;
+	const __m256i nom_base = _mm256_set1_epi16(256);
+
+	const __m256i alpha_lo = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpacklo_epi8(src, zero), alpha_cm), 2);
+	const __m256i alpha_hi = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpackhi_epi8(src, zero), alpha_cm), 2);
+	__m256i dst_lo = _mm256_unpacklo_epi8(dst, zero);
+	__m256i dst_hi = _mm256_unpackhi_epi8(dst, zero);
+	dst_lo = _mm256_srli_epi16(_mm256_mullo_epi16(dst_lo, _mm256_sub_epi16(nom_base, alpha_lo)), 8);
+	dst_hi = _mm256_srli_epi16(_mm256_mullo_epi16(dst_hi, _mm256_sub_epi16(nom_base, alpha_hi)), 8);
+	return _mm256_packus_epi16(dst_lo, dst_hi);
+}
+
+/**
+ * Make eight pixels dark grey, like Blitter_32bppBase::MakeDark, keeping their alpha.
+ * @param src The pixels.
+ * @return The grey pixels.
+ */
+static inline TARGET_AVX2 __m256i MakeDarkEightPixels(__m256i src)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	const __m256i b = _mm256_and_si256(src, byte_mask);
+	const __m256i g = _mm256_and_si256(_mm256_srli_epi32(src, 8), byte_mask);
+	const __m256i r = _mm256_and_si256(_mm256_srli_epi32(src, 16), byte_mask);
+	__m256i grey = _mm256_mullo_epi32(r, _mm256_set1_epi32(13063));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(g, _mm256_set1_epi32(25647)));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(b, _mm256_set1_epi32(4981)));
+	grey = _mm256_srli_epi32(grey, 16);
+	grey = _mm256_mullo_epi32(grey, _mm256_set1_epi32(0x010101));
+	return _mm256_or_si256(grey, _mm256_and_si256(src, AVX2_ALPHA_MASK));
+}
+
+/**
+ * Apply a colour remap to the pixels of a block with a non-zero m channel.
+ * Pixels remapped to colour 0 become fully transparent.
+ * @tparam anim Whether to determine the animation buffer values of the pixels.
+ * @param[in,out] pixels The pixels to remap.
+ * @param mv The map values of the pixels.
+ * @param remap The remap table.
+ * @param[out] anim_values The remapped colour index and brightness of each pixel, 0 for pixels which are not remapped.
+ */
+template <bool anim>
+static inline TARGET_AVX2 void RemapEightPixels(__m256i &pixels, __m128i mv, const byte *remap, __m128i *anim_values = NULL)
+{
+	if (_mm_testz_si128(mv, _mm_set1_epi16(0x00FF))) {
+		if (anim) *anim_values = _mm_setzero_si128();
+		return;
+	}
+
+	ALIGN(32) uint32 colours[AVX2_BLOCK_SIZE];
+	ALIGN(16) uint16 values[AVX2_BLOCK_SIZE];
+	ALIGN(16) uint16 anim_buf[AVX2_BLOCK_SIZE];
+	_mm256_store_si256((__m256i *) colours, pixels);
+	_mm_store_si128((__m128i *) values, mv);
+	for (uint i = 0; i < AVX2_BLOCK_SIZE; i++) {
+		const uint m = GB(values[i], 0, 8);
+		if (anim) anim_buf[i] = 0;
+		if (m == 0) continue;
+
+		const uint r = remap[m];
+		if (anim) anim_buf[i] = r | (values[i] & 0xFF00);
+		if (r == 0) {
+			colours[i] = 0;
+			continue;
+		}
+		Colour colour = Blitter_32bppBase::AdjustBrightness(Blitter_32bppBase::LookupColourInPalette(r), GB(values[i], 8, 8));
+		colour.a = Colour(colours[i]).a;
+		colours[i] = colour.data;
+	}
+	pixels = _mm256_load_si256((const __m256i *) colours);
+	if (anim) *anim_values = _mm_load_si128((const __m128i *) anim_buf);
+}
+
+#endif /* WITH_SSE */
+#endif /* BLITTER_32BPP_AVX2_FUNC_HPP */
@@ -402,6 +402,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 	assert(cp != NULL);
 	assert(action == MTA_LOAD ||
 			(action == MTA_KEEP && this->action_counts[MTA_LOAD] == 0));
+	this->ApplyPendingAge();
 	this->AddToMeta(cp, action);
 
 	if (this->count == cp->count) {
@@ -506,8 +507,10 @@ void VehicleCargoList::PopCargo(Taction action)
  */
 void VehicleCargoList::RemoveFromCache(const CargoPacket *cp, uint count)
 {
-	this->feeder_share -= cp->FeederShare(count);
-	this->Parent::RemoveFromCache(cp, count);
+	assert(count <= cp->count);
+	this->feeder_share          -= cp->FeederShare(count);
+	this->count                 -= count;
+	this->cargo_days_in_transit -= this->GetDaysInTransit(cp) * count;
 }
 
 /**
@@ -517,8 +520,10 @@ void VehicleCargoList::RemoveFromCache(const CargoPacket *cp, uint count)
  */
 void VehicleCargoList::AddToCache(const CargoPacket *cp)
 {
-	this->feeder_share += cp->feeder_share;
-	this->Parent::AddToCache(cp);
+	this->feeder_share          += cp->feeder_share;
+	this->count                 += cp->count;
+	this->cargo_days_in_transit += this->GetDaysInTransit(cp) * cp->count;
+	this->max_days_in_transit    = max(this->max_days_in_transit, cp->days_in_transit);
 }
 
 /**
@@ -550,18 +555,43 @@ void VehicleCargoList::AddToMeta(const CargoPacket *cp, MoveToAction action)
 }
 
 /**
- * Ages the all cargo in this list.
+ * Ages the all cargo in this list. As long as none of the packets can reach
+ * the maximum age only the cache is updated and the ageing of the packets
+ * themselves is postponed until they are needed, see #ApplyPendingAge.
  */
 void VehicleCargoList::AgeCargo()
 {
+	if (this->max_days_in_transit + this->pending_age < 0xFF) {
+		this->pending_age++;
+		this->cargo_days_in_transit += this->count;
+		return;
+	}
+
+	this->ApplyPendingAge();
+	byte max_days = 0;
 	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
 		CargoPacket *cp = *it;
 		/* If we're at the maximum, then we can't increase no more. */
-		if (cp->days_in_transit == 0xFF) continue;
+		if (cp->days_in_transit != 0xFF) {
+			cp->days_in_transit++;
+			this->cargo_days_in_transit += cp->count;
+		}
+		max_days = max(max_days, cp->days_in_transit);
+	}
+	this->max_days_in_transit = max_days;
+}
 
-		cp->days_in_transit++;
-		this->cargo_days_in_transit += cp->count;
+/**
+ * Add the postponed ageing to the days in transit of all packets.
+ */
+void VehicleCargoList::ApplyPendingAgeToPackets()
+{
+	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
+		CargoPacket *cp = *it;
+		cp->days_in_transit = this->GetDaysInTransit(cp);
 	}
+	this->max_days_in_transit = min<uint>(this->max_days_in_transit + this->pending_age, 0xFF);
+	this->pending_age = 0;
 }
 
 /**
@@ -621,6 +651,7 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 {
 	this->AssertCountConsistency();
 	assert(this->action_counts[MTA_LOAD] == 0);
+	this->ApplyPendingAge();
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
 	Iterator it = this->packets.begin();
 	uint sum = 0;
@@ -785,6 +816,7 @@ uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList:
 uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID next)
 {
 	max_move = min(this->action_counts[MTA_LOAD], max_move);
+	this->ApplyPendingAge();
 	this->PopCargo(CargoReturn(this, dest, max_move, next));
 	return max_move;
 }
@@ -798,6 +830,7 @@ uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID n
 uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
 {
 	max_move = min(this->count, max_move);
+	this->ApplyPendingAge();
 	this->PopCargo(CargoShift(this, dest, max_move));
 	return max_move;
 }
@@ -813,6 +846,7 @@ uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
 uint VehicleCargoList::Unload(uint max_move, StationCargoList *dest, CargoPayment *payment)
 {
 	uint moved = 0;
+	this->ApplyPendingAge();
 	if (this->action_counts[MTA_TRANSFER] > 0) {
 		uint move = min(this->action_counts[MTA_TRANSFER], max_move);
 		this->ShiftCargo(CargoTransfer(this, dest, move));
@@ -836,6 +870,7 @@ uint VehicleCargoList::Truncate(uint max_move)
 {
 	max_move = min(this->count, max_move);
 	if (max_move > this->ActionCount(MTA_KEEP)) this->KeepAll();
+	this->ApplyPendingAge();
 	this->PopCargo(CargoRemoval<VehicleCargoList>(this, max_move));
 	return max_move;
 }
@@ -851,6 +886,8 @@ uint VehicleCargoList::Truncate(uint max_move)
 uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID avoid, StationID avoid2, const GoodsEntry *ge)
 {
 	max_move = min(this->action_counts[MTA_TRANSFER], max_move);
+	this->ApplyPendingAge();
+	dest->ApplyPendingAge();
 	this->ShiftCargoWithFrontInsert(VehicleCargoReroute(this, dest, max_move, avoid, avoid2, ge));
 	return max_move;
 }
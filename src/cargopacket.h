@@ -299,6 +299,8 @@ protected:
 
 	Money feeder_share;                     ///< Cache for the feeder share.
 	uint action_counts[NUM_MOVE_TO_ACTION]; ///< Counts of cargo to be transfered, delivered, kept and loaded.
+	uint8 pending_age;                      ///< Number of times the cargo has been aged without updating the packets.
+	uint8 max_days_in_transit;              ///< Upper bound of the days in transit of the packets, excluding #pending_age.
 
 	template<class Taction>
 	void ShiftCargo(Taction action);
@@ -309,6 +311,19 @@ protected:
 	template<class Taction>
 	void PopCargo(Taction action);
 
+	void ApplyPendingAgeToPackets();
+
+	/**
+	 * Get the days in transit of a packet in this list, including the ageing
+	 * that has not been applied to the packet yet.
+	 * @param cp Packet in this list.
+	 * @return The days in transit of the packet.
+	 */
+	inline uint GetDaysInTransit(const CargoPacket *cp) const
+	{
+		return min<uint>(cp->days_in_transit + this->pending_age, 0xFF);
+	}
+
 	inline uint RecalculateCargoTotal() const
 	{
 		uint total = 0;
@@ -443,6 +458,16 @@ public:
 
 	void AgeCargo();
 
+	/**
+	 * Update the days in transit of all packets for the ageing that has been
+	 * postponed. This has to be done before the packets are looked at or leave
+	 * the list.
+	 */
+	inline void ApplyPendingAge()
+	{
+		if (this->pending_age != 0) this->ApplyPendingAgeToPackets();
+	}
+
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
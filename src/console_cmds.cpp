@@ -43,6 +43,8 @@
 #include "airport.h"
 #include "station_base.h"
 #include "economy_func.h"
+#include "framerate_type.h"
+#include "newgrf_profiling.h"
 
 #include "safeguards.h"
 
@@ -1414,6 +1416,25 @@ DEF_CONSOLE_CMD(ConMinimap)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConExportMapTiles)
+{
+	if (argc == 0) {
+		IConsoleHelp("Export the map coloured by owner as a pyramid of image tiles for zoomable web maps. Usage: 'export_map_tiles [<directory>]'");
+		IConsoleHelp("Images are written to <directory>/<level>/<column>_<row> in the screenshot directory. Only images of changed areas are written again.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	int written = ExportMapTiles(argc > 1 ? argv[1] : "maptiles");
+	if (written < 0) {
+		IConsoleError("Failed to write the map tile images.");
+	} else {
+		IConsolePrintF(CC_DEFAULT, "Wrote %d map tile images.", written);
+	}
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConInfoCmd)
 {
 	if (argc == 0) {
@@ -1988,6 +2009,40 @@ DEF_CONSOLE_CMD(ConDumpCpdpStats)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConLinkGraphJobStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the predicted and actual run times of the last link graph jobs, and the time they had until they were joined.");
+		return true;
+	}
+
+	extern void DumpLinkGraphJobStats(char *buffer, const char *last);
+	char buffer[32768];
+	DumpLinkGraphJobStats(buffer, lastof(buffer));
+	PrintLineByLine(buffer);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConSpriteCacheStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the hit rate, evictions and memory use per GRF of the sprite cache. Usage: 'sprite_cache_stats [reset]'");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		extern void ResetSpriteCacheStats();
+		ResetSpriteCacheStats();
+		return true;
+	}
+
+	extern void DumpSpriteCacheStats(char *buffer, const char *last);
+	char buffer[32768];
+	DumpSpriteCacheStats(buffer, lastof(buffer));
+	PrintLineByLine(buffer);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConCheckCaches)
 {
 	if (argc == 0) {
@@ -2008,6 +2063,21 @@ DEF_CONSOLE_CMD(ConCheckCaches)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConCheckSpriteSorters)
+{
+	if (argc == 0) {
+		IConsoleHelp("Debug: Check that the viewport sprite sorters sort fixed sets of sprites in the same order as the original sorter, and show how long they take");
+		return true;
+	}
+
+	extern bool CheckViewportSpriteSorters(char *buffer, const char *last);
+	char buffer[32768];
+	bool same_order = CheckViewportSpriteSorters(buffer, lastof(buffer));
+	PrintLineByLine(buffer);
+	if (!same_order) IConsoleError("A sprite sorter sorts differently than the original sorter.");
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConDoDisaster)
 {
 	if (argc == 0) {
@@ -2065,6 +2135,83 @@ DEF_CONSOLE_CMD(ConFramerateWindow)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConProfile)
+{
+	extern void ConPrintPerformanceZones(); // framerate_gui.cpp
+
+	if (argc == 0) {
+		IConsoleHelp("Measure parts of the game loop in more detail. Usage: 'profile [on | off | trace start | trace stop <file>]'");
+		IConsoleHelp("  Without arguments the current profiling zone measurements are shown.");
+		IConsoleHelp("  'trace stop' writes all measurements taken since 'trace start' in the Chrome trace event format.");
+		return true;
+	}
+
+	if (argc == 1) {
+		ConPrintPerformanceZones();
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "on") == 0) {
+		SetPerformanceZonesEnabled(true);
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "off") == 0) {
+		SetPerformanceZonesEnabled(false);
+		return true;
+	}
+
+	if (argc == 3 && strcasecmp(argv[1], "trace") == 0 && strcasecmp(argv[2], "start") == 0) {
+		StartPerformanceTrace();
+		IConsolePrint(CC_DEFAULT, "Trace started");
+		return true;
+	}
+
+	if (argc == 4 && strcasecmp(argv[1], "trace") == 0 && strcasecmp(argv[2], "stop") == 0) {
+		StopPerformanceTrace();
+		if (!WritePerformanceTrace(argv[3])) {
+			IConsolePrintF(CC_ERROR, "Failed to write trace to '%s'", argv[3]);
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Trace written to '%s'", argv[3]);
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConNewGRFProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Profile the resolution of NewGRF callbacks and sprites. Usage: 'newgrf_profile start | stop | [grf | feature | callback | all] [<count>]'");
+		IConsoleHelp("  Shows the <count> NewGRFs, features, callbacks or combinations thereof which took the most time, 20 by default.");
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "start") == 0) {
+		StartNewGRFProfiling();
+		IConsolePrint(CC_DEFAULT, "NewGRF profiling started");
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "stop") == 0) {
+		StopNewGRFProfiling();
+		IConsolePrint(CC_DEFAULT, "NewGRF profiling stopped");
+		return true;
+	}
+
+	if (argc > 3) return false;
+
+	uint count = 20;
+	if (argc == 3 && !GetArgumentInteger(&count, argv[2])) {
+		IConsolePrintF(CC_ERROR, "'%s' is not a valid number", argv[2]);
+		return true;
+	}
+
+	ConPrintNewGRFProfile(argc >= 2 ? argv[1] : "all", count);
+	return true;
+}
+
 /*******************************
  * console command registration
  *******************************/
@@ -2091,6 +2238,7 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("return",       ConReturn);
 	IConsoleCmdRegister("screenshot",   ConScreenShot);
 	IConsoleCmdRegister("minimap",      ConMinimap);
+	IConsoleCmdRegister("export_map_tiles", ConExportMapTiles);
 	IConsoleCmdRegister("script",       ConScript);
 	IConsoleCmdRegister("scrollto",     ConScrollToTile);
 	IConsoleCmdRegister("alias",        ConAlias);
@@ -2198,11 +2346,16 @@ void IConsoleStdLibRegister()
 #endif
 	IConsoleCmdRegister("fps",     ConFramerate);
 	IConsoleCmdRegister("fps_wnd", ConFramerateWindow);
+	IConsoleCmdRegister("profile", ConProfile);
+	IConsoleCmdRegister("newgrf_profile", ConNewGRFProfile);
+	IConsoleCmdRegister("sprite_cache_stats", ConSpriteCacheStats);
+	IConsoleCmdRegister("linkgraph_job_stats", ConLinkGraphJobStats);
 
 	IConsoleCmdRegister("dump_command_log", ConDumpCommandLog, nullptr, true);
 	IConsoleCmdRegister("dump_inflation", ConDumpInflation, nullptr, true);
 	IConsoleCmdRegister("dump_cpdp_stats", ConDumpCpdpStats, nullptr, true);
 	IConsoleCmdRegister("check_caches", ConCheckCaches, nullptr, true);
+	IConsoleCmdRegister("check_sprite_sorters", ConCheckSpriteSorters, nullptr, true);
 
 	/* NewGRF development stuff */
 	IConsoleCmdRegister("reload_newgrfs",  ConNewGRFReload, ConHookNewGRFDeveloperTool);
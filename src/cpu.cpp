@@ -90,7 +90,7 @@ uint64 ottd_rdtsc() {return 0;}
 #if defined(_MSC_VER)
 void ottd_cpuid(int info[4], int type)
 {
-	__cpuid(info, type);
+	__cpuidex(info, type, 0);
 }
 #elif defined(__x86_64__) || defined(__i386)
 void ottd_cpuid(int info[4], int type)
@@ -110,13 +110,13 @@ void ottd_cpuid(int info[4], int type)
 			/* It is safe to write "=r" for (info[1]) as in case that PIC is enabled for i386,
 			 * the compiler will not choose EBX as target register (but something else).
 			 */
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #else
 	__asm__ __volatile__ (
 			"cpuid           \n\t"
 			: "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #endif /* i386 PIC */
 }
@@ -137,3 +137,28 @@ bool HasCPUIDFlag(uint type, uint index, uint bit)
 	ottd_cpuid(cpu_info, type);
 	return HasBit(cpu_info[index], bit);
 }
+
+/**
+ * Get the state components the operating system saves on context switches (XCR0).
+ * @return The enabled state components, or 0 when this can't be determined.
+ */
+static uint64 ottd_xgetbv()
+{
+#if defined(_MSC_VER) && _MSC_VER >= 1600
+	return _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386)
+	uint32 low, high;
+	__asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a" (low), "=d" (high) : "c" (0));
+	return ((uint64)high << 32) | low;
+#else
+	return 0;
+#endif
+}
+
+bool HasAVX2Support()
+{
+	/* Besides the CPU, the OS has to support AVX by saving the SSE and AVX registers (XCR0 bits 1 and 2). */
+	if (!HasCPUIDFlag(1, 2, 27) || !HasCPUIDFlag(1, 2, 28)) return false;
+	if ((ottd_xgetbv() & 6) != 6) return false;
+	return HasCPUIDFlag(7, 1, 5);
+}
@@ -21,7 +21,7 @@ uint64 ottd_rdtsc();
 /**
  * Get the CPUID information from the CPU.
  * @param info The retrieved info. All zeros on architectures without CPUID.
- * @param type The information this instruction should retrieve.
+ * @param type The information this instruction should retrieve; the sub-leaf is always 0.
  */
 void ottd_cpuid(int info[4], int type);
 
@@ -34,4 +34,21 @@ void ottd_cpuid(int info[4], int type);
  */
 bool HasCPUIDFlag(uint type, uint index, uint bit);
 
+/**
+ * Check whether AVX2 instructions can be used, i.e. whether both the CPU and the operating system support them.
+ * @return True when AVX2 is supported.
+ */
+bool HasAVX2Support();
+
+/**
+ * Compile a function for CPUs with AVX2 without requiring AVX2 for the rest of its file.
+ * Everything else in such a file, like inline functions of headers, must run on any CPU.
+ * MSVC does not need this, it always accepts AVX2 intrinsics.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#	define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#	define TARGET_AVX2
+#endif
+
 #endif /* CPU_H */
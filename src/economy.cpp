@@ -54,10 +54,13 @@
 #include "tracerestrict.h"
 #include "tbtr_template_vehicle.h"
 #include "scope_info.h"
+#include "framerate_type.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
 
+#include <map>
+
 #include "safeguards.h"
 
 
@@ -1550,7 +1553,7 @@ struct FinalizeRefitAction
  * @param next_station Possible next stations the vehicle can travel to.
  * @param new_cid Target cargo for refit.
  */
-static void HandleStationRefit(Vehicle *v, CargoArray &consist_capleft, Station *st, CargoStationIDStackSet next_station, CargoID new_cid)
+static void HandleStationRefit(Vehicle *v, CargoArray &consist_capleft, Station *st, const CargoStationIDStackSet &next_station, CargoID new_cid)
 {
 	Vehicle *v_start = v->GetFirstEnginePart();
 	if (!IterateVehicleParts(v_start, IsEmptyAction())) return;
@@ -1701,11 +1704,36 @@ static void UpdateLoadUnloadTicks(Vehicle *front, const Station *st, int ticks,
 	front->load_unload_ticks = max(1, ticks);
 }
 
+/**
+ * Next stopping stations of the vehicles loading at a station during a single call of #LoadUnloadStation.
+ * They only depend on the order list and the current order of a vehicle, so vehicles sharing their
+ * orders and waiting at the same order only need them to be determined once.
+ */
+class NextStoppingStationCache {
+	typedef std::pair<const OrderList *, VehicleOrderID> Key; ///< Order list and current implicit order index of a vehicle.
+	std::map<Key, CargoStationIDStackSet> cache;              ///< The next stopping stations per order list and order.
+
+public:
+	/**
+	 * Get the next stopping stations of a vehicle loading at the station.
+	 * @param front The vehicle.
+	 * @return The stations, see Vehicle::GetNextStoppingStation.
+	 */
+	const CargoStationIDStackSet &Get(const Vehicle *front)
+	{
+		Key key(front->orders.list, front->orders.list != NULL ? front->cur_implicit_order_index : 0);
+		auto it = this->cache.find(key);
+		if (it == this->cache.end()) it = this->cache.insert(std::make_pair(key, front->GetNextStoppingStation())).first;
+		return it->second;
+	}
+};
+
 /**
  * Loads/unload the vehicle if possible.
  * @param front the vehicle to be (un)loaded
+ * @param next_stations Next stopping stations of the vehicles loading at the station.
  */
-static void LoadUnloadVehicle(Vehicle *front)
+static void LoadUnloadVehicle(Vehicle *front, NextStoppingStationCache &next_stations)
 {
 	assert(front->current_order.IsType(OT_LOADING));
 
@@ -1747,7 +1775,7 @@ static void LoadUnloadVehicle(Vehicle *front)
 		platform_length_left = st->GetPlatformLength(station_tile) * TILE_SIZE - front->GetGroundVehicleCache()->cached_total_length;
 	}
 
-	CargoStationIDStackSet next_station = front->GetNextStoppingStation();
+	const CargoStationIDStackSet &next_station = next_stations.Get(front);
 
 	bool use_autorefit = front->current_order.IsRefit() && front->current_order.GetRefitCargo() == CT_AUTO_REFIT;
 	CargoArray consist_capleft;
@@ -2125,6 +2153,8 @@ void LoadUnloadStation(Station *st)
 	/* No vehicle is here... */
 	if (st->loading_vehicles.empty()) return;
 
+	PerformanceZoneMeasurer zone(PFZ_LOAD_UNLOAD);
+
 	Vehicle *last_loading = NULL;
 
 	/* Check if anything will be loaded at all. Otherwise we don't need to reserve either. */
@@ -2144,8 +2174,9 @@ void LoadUnloadStation(Station *st)
 	 */
 	if (last_loading == NULL) return;
 
+	NextStoppingStationCache next_stations;
 	for (Vehicle *v : st->loading_vehicles) {
-		if (!(v->vehstatus & (VS_STOPPED | VS_CRASHED)) && !v->current_order.IsType(OT_LOADING_ADVANCE)) LoadUnloadVehicle(v);
+		if (!(v->vehstatus & (VS_STOPPED | VS_CRASHED)) && !v->current_order.IsType(OT_LOADING_ADVANCE)) LoadUnloadVehicle(v, next_stations);
 		if (v == last_loading) break;
 	}
 
@@ -28,6 +28,17 @@
 #include <sys/stat.h>
 #include <algorithm>
 
+#if defined(WIN32) || (defined(UNIX) && !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(__DJGPP__) && !defined(LIMITED_FDS))
+/** Slotted files are mapped into memory. */
+#	define WITH_FIO_MMAP
+#	if defined(WIN32)
+#		include <io.h>
+#	else
+#		include <sys/mman.h>
+#		include <unistd.h>
+#	endif
+#endif
+
 #ifdef WITH_XDG_BASEDIR
 #include "basedir.h"
 #endif
@@ -47,13 +58,26 @@ struct Fio {
 	byte buffer_start[FIO_BUFFER_SIZE];    ///< local buffer when read from file
 	const char *filenames[MAX_FILE_SLOTS]; ///< array of filenames we (should) have open
 	char *shortnames[MAX_FILE_SLOTS];      ///< array of short names for spriteloader's use
+	Subdirectory subdirs[MAX_FILE_SLOTS];  ///< array of sub directories the files were opened from
 #if defined(LIMITED_FDS)
 	uint open_handles;                     ///< current amount of open handles
 	uint usage_count[MAX_FILE_SLOTS];      ///< count how many times this file has been opened
 #endif /* LIMITED_FDS */
 };
 
-static Fio _fio; ///< #Fio instance.
+static Fio _fio_main;                        ///< #Fio instance of the main thread.
+static thread_local Fio *_fio = &_fio_main;  ///< #Fio instance of the current thread.
+
+/** Memory mapping of a slotted file of the main thread, shared by all threads. */
+struct FioMapping {
+	void *base;        ///< Start of the mapping.
+	size_t length;     ///< Length of the mapping.
+	const byte *data;  ///< Start of the file in the mapping, NULL if the file is not mapped.
+	size_t start;      ///< Position of the start of the file in its handle, non-zero for files in a tar.
+	size_t size;       ///< Size of the file.
+};
+
+static FioMapping _fio_mappings[MAX_FILE_SLOTS]; ///< Mappings of the slotted files.
 
 /** Whether the working directory should be scanned. */
 static bool _do_scan_working_directory = true;
@@ -67,7 +91,7 @@ extern char *_highscore_file;
  */
 size_t FioGetPos()
 {
-	return _fio.pos + (_fio.buffer - _fio.buffer_end);
+	return _fio->pos + (_fio->buffer - _fio->buffer_end);
 }
 
 /**
@@ -77,7 +101,8 @@ size_t FioGetPos()
  */
 const char *FioGetFilename(uint slot)
 {
-	return _fio.shortnames[slot];
+	/* Other threads do not necessarily open all files themselves. */
+	return _fio_main.shortnames[slot];
 }
 
 /**
@@ -88,10 +113,10 @@ const char *FioGetFilename(uint slot)
 void FioSeekTo(size_t pos, int mode)
 {
 	if (mode == SEEK_CUR) pos += FioGetPos();
-	_fio.buffer = _fio.buffer_end = _fio.buffer_start + FIO_BUFFER_SIZE;
-	_fio.pos = pos;
-	if (fseek(_fio.cur_fh, _fio.pos, SEEK_SET) < 0) {
-		DEBUG(misc, 0, "Seeking in %s failed", _fio.filename);
+	_fio->buffer = _fio->buffer_end = _fio->buffer_start + FIO_BUFFER_SIZE;
+	_fio->pos = pos;
+	if (fseek(_fio->cur_fh, _fio->pos, SEEK_SET) < 0) {
+		DEBUG(misc, 0, "Seeking in %s failed", _fio->filename);
 	}
 }
 
@@ -99,11 +124,11 @@ void FioSeekTo(size_t pos, int mode)
 static void FioRestoreFile(int slot)
 {
 	/* Do we still have the file open, or should we reopen it? */
-	if (_fio.handles[slot] == NULL) {
-		DEBUG(misc, 6, "Restoring file '%s' in slot '%d' from disk", _fio.filenames[slot], slot);
-		FioOpenFile(slot, _fio.filenames[slot]);
+	if (_fio->handles[slot] == NULL) {
+		DEBUG(misc, 6, "Restoring file '%s' in slot '%d' from disk", _fio->filenames[slot], slot);
+		FioOpenFile(slot, _fio->filenames[slot], _fio->subdirs[slot]);
 	}
-	_fio.usage_count[slot]++;
+	_fio->usage_count[slot]++;
 }
 #endif /* LIMITED_FDS */
 
@@ -115,14 +140,16 @@ static void FioRestoreFile(int slot)
 void FioSeekToFile(uint slot, size_t pos)
 {
 	FILE *f;
+	/* Other threads open the files of the main thread on first use. */
+	if (_fio != &_fio_main && _fio->handles[slot] == NULL) FioOpenFile(slot, _fio_main.filenames[slot], _fio_main.subdirs[slot]);
 #if defined(LIMITED_FDS)
 	/* Make sure we have this file open */
 	FioRestoreFile(slot);
 #endif /* LIMITED_FDS */
-	f = _fio.handles[slot];
+	f = _fio->handles[slot];
 	assert(f != NULL);
-	_fio.cur_fh = f;
-	_fio.filename = _fio.filenames[slot];
+	_fio->cur_fh = f;
+	_fio->filename = _fio->filenames[slot];
 	FioSeekTo(pos, SEEK_SET);
 }
 
@@ -132,15 +159,15 @@ void FioSeekToFile(uint slot, size_t pos)
  */
 byte FioReadByte()
 {
-	if (_fio.buffer == _fio.buffer_end) {
-		_fio.buffer = _fio.buffer_start;
-		size_t size = fread(_fio.buffer, 1, FIO_BUFFER_SIZE, _fio.cur_fh);
-		_fio.pos += size;
-		_fio.buffer_end = _fio.buffer_start + size;
+	if (_fio->buffer == _fio->buffer_end) {
+		_fio->buffer = _fio->buffer_start;
+		size_t size = fread(_fio->buffer, 1, FIO_BUFFER_SIZE, _fio->cur_fh);
+		_fio->pos += size;
+		_fio->buffer_end = _fio->buffer_start + size;
 
 		if (size == 0) return 0;
 	}
-	return *_fio.buffer++;
+	return *_fio->buffer++;
 }
 
 /**
@@ -150,8 +177,8 @@ byte FioReadByte()
 void FioSkipBytes(int n)
 {
 	for (;;) {
-		int m = min(_fio.buffer_end - _fio.buffer, n);
-		_fio.buffer += m;
+		int m = min(_fio->buffer_end - _fio->buffer, n);
+		_fio->buffer += m;
 		n -= m;
 		if (n == 0) break;
 		FioReadByte();
@@ -187,7 +214,131 @@ uint32 FioReadDword()
 void FioReadBlock(void *ptr, size_t size)
 {
 	FioSeekTo(FioGetPos(), SEEK_SET);
-	_fio.pos += fread(ptr, 1, size, _fio.cur_fh);
+	_fio->pos += fread(ptr, 1, size, _fio->cur_fh);
+}
+
+/**
+ * Map a slotted file of the main thread into memory, so it can be read by #FioReader.
+ * When mapping is not possible the file is read via the buffered functions.
+ * @param slot Slot of the file.
+ * @param f Handle of the file.
+ * @param pos Position of the start of the file in the handle, non-zero for files in a tar.
+ * @param size Size of the file.
+ */
+static void FioMapFile(uint slot, FILE *f, size_t pos, size_t size)
+{
+	FioMapping &m = _fio_mappings[slot];
+	assert(m.data == NULL);
+	if (size == 0) return;
+
+#if defined(WITH_FIO_MMAP)
+#	if defined(WIN32)
+	/* The offset of a view must be a multiple of the allocation granularity. */
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	size_t offset = pos - pos % si.dwAllocationGranularity;
+	size_t length = pos - offset + size;
+
+	HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(f)), NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) return;
+	void *base = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)((uint64)offset >> 32), (DWORD)offset, length);
+	/* The view keeps the mapping alive. */
+	CloseHandle(mapping);
+	if (base == NULL) return;
+#	else
+	/* The offset of a mapping must be a multiple of the page size. */
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t offset = pos - pos % page_size;
+	size_t length = pos - offset + size;
+
+	void *base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(f), offset);
+	if (base == MAP_FAILED) return;
+#	endif
+
+	m.base = base;
+	m.length = length;
+	m.data = (const byte *)base + (pos - offset);
+	m.start = pos;
+	m.size = size;
+#endif /* WITH_FIO_MMAP */
+}
+
+/**
+ * Remove the memory mapping of a slotted file of the main thread, if any.
+ * @param slot Slot of the file.
+ */
+static void FioUnmapFile(uint slot)
+{
+	FioMapping &m = _fio_mappings[slot];
+	if (m.data == NULL) return;
+
+#if defined(WITH_FIO_MMAP)
+#	if defined(WIN32)
+	UnmapViewOfFile(m.base);
+#	else
+	munmap(m.base, m.length);
+#	endif
+#endif /* WITH_FIO_MMAP */
+
+	m.base = NULL;
+	m.length = 0;
+	m.data = NULL;
+	m.start = 0;
+	m.size = 0;
+}
+
+/**
+ * Start reading a slotted file.
+ * @param slot Slot of the file.
+ * @param pos Position in the file handle to start reading at, like returned by #FioGetPos.
+ *            For files in a tar this includes the position of the file in the tar.
+ */
+FioReader::FioReader(uint slot, size_t pos)
+{
+	const FioMapping &m = _fio_mappings[slot];
+	if (m.data != NULL) {
+		assert(pos >= m.start && pos <= m.start + m.size);
+		this->start = m.start;
+		this->begin = m.data;
+		this->end = m.data + m.size;
+		this->pos = m.data + (pos - m.start);
+	} else {
+		this->start = 0;
+		this->begin = this->end = this->pos = NULL;
+		FioSeekToFile(slot, pos);
+	}
+}
+
+/**
+ * Read a block of data.
+ * @param ptr Destination of the data.
+ * @param size Number of bytes to read; bytes beyond the end of the file are read as 0.
+ */
+void FioReader::ReadBlock(byte *ptr, size_t size)
+{
+	if (this->pos == NULL) {
+		for (; size > 0; size--) *ptr++ = FioReadByte();
+		return;
+	}
+
+	size_t avail = min<size_t>(size, this->end - this->pos);
+	memcpy(ptr, this->pos, avail);
+	if (avail < size) memset(ptr + avail, 0, size - avail);
+	this->pos += avail;
+}
+
+/**
+ * Skip bytes.
+ * @param n Number of bytes to skip.
+ */
+void FioReader::SkipBytes(size_t n)
+{
+	if (this->pos == NULL) {
+		FioSkipBytes((int)n);
+		return;
+	}
+
+	this->pos += min<size_t>(n, this->end - this->pos);
 }
 
 /**
@@ -196,15 +347,17 @@ void FioReadBlock(void *ptr, size_t size)
  */
 static inline void FioCloseFile(int slot)
 {
-	if (_fio.handles[slot] != NULL) {
-		fclose(_fio.handles[slot]);
+	if (_fio == &_fio_main) FioUnmapFile(slot);
+
+	if (_fio->handles[slot] != NULL) {
+		fclose(_fio->handles[slot]);
 
-		free(_fio.shortnames[slot]);
-		_fio.shortnames[slot] = NULL;
+		free(_fio->shortnames[slot]);
+		_fio->shortnames[slot] = NULL;
 
-		_fio.handles[slot] = NULL;
+		_fio->handles[slot] = NULL;
 #if defined(LIMITED_FDS)
-		_fio.open_handles--;
+		_fio->open_handles--;
 #endif /* LIMITED_FDS */
 	}
 }
@@ -212,30 +365,51 @@ static inline void FioCloseFile(int slot)
 /** Close all slotted open files. */
 void FioCloseAll()
 {
-	for (int i = 0; i != lengthof(_fio.handles); i++) {
+	for (int i = 0; i != lengthof(_fio->handles); i++) {
 		FioCloseFile(i);
 	}
 }
 
+/**
+ * Give the current thread its own set of slotted files, so it can read
+ * from the files opened by the main thread without disturbing it.
+ * The files are opened on first use by #FioSeekToFile.
+ * @note Only call this from threads other than the main thread.
+ */
+void FioCreateThreadFiles()
+{
+	assert(_fio == &_fio_main);
+	_fio = CallocT<Fio>(1);
+}
+
+/** Close the slotted files of the current thread, see #FioCreateThreadFiles. */
+void FioCloseThreadFiles()
+{
+	assert(_fio != &_fio_main);
+	FioCloseAll();
+	free(_fio);
+	_fio = &_fio_main;
+}
+
 #if defined(LIMITED_FDS)
 static void FioFreeHandle()
 {
 	/* If we are about to open a file that will exceed the limit, close a file */
-	if (_fio.open_handles + 1 == LIMITED_FDS) {
+	if (_fio->open_handles + 1 == LIMITED_FDS) {
 		uint i, count;
 		int slot;
 
 		count = UINT_MAX;
 		slot = -1;
 		/* Find the file that is used the least */
-		for (i = 0; i < lengthof(_fio.handles); i++) {
-			if (_fio.handles[i] != NULL && _fio.usage_count[i] < count) {
-				count = _fio.usage_count[i];
+		for (i = 0; i < lengthof(_fio->handles); i++) {
+			if (_fio->handles[i] != NULL && _fio->usage_count[i] < count) {
+				count = _fio->usage_count[i];
 				slot  = i;
 			}
 		}
 		assert(slot != -1);
-		DEBUG(misc, 6, "Closing filehandler '%s' in slot '%d' because of fd-limit", _fio.filenames[slot], slot);
+		DEBUG(misc, 6, "Closing filehandler '%s' in slot '%d' because of fd-limit", _fio->filenames[slot], slot);
 		FioCloseFile(slot);
 	}
 }
@@ -254,25 +428,28 @@ void FioOpenFile(uint slot, const char *filename, Subdirectory subdir)
 #if defined(LIMITED_FDS)
 	FioFreeHandle();
 #endif /* LIMITED_FDS */
-	f = FioFOpenFile(filename, "rb", subdir);
+	size_t size;
+	f = FioFOpenFile(filename, "rb", subdir, &size);
 	if (f == NULL) usererror("Cannot open file '%s'", filename);
 	long pos = ftell(f);
 	if (pos < 0) usererror("Cannot read file '%s'", filename);
 
 	FioCloseFile(slot); // if file was opened before, close it
-	_fio.handles[slot] = f;
-	_fio.filenames[slot] = filename;
+	_fio->handles[slot] = f;
+	if (_fio == &_fio_main) FioMapFile(slot, f, pos, size);
+	_fio->filenames[slot] = filename;
+	_fio->subdirs[slot] = subdir;
 
 	/* Store the filename without path and extension */
 	const char *t = strrchr(filename, PATHSEPCHAR);
-	_fio.shortnames[slot] = stredup(t == NULL ? filename : t);
-	char *t2 = strrchr(_fio.shortnames[slot], '.');
+	_fio->shortnames[slot] = stredup(t == NULL ? filename : t);
+	char *t2 = strrchr(_fio->shortnames[slot], '.');
 	if (t2 != NULL) *t2 = '\0';
-	strtolower(_fio.shortnames[slot]);
+	strtolower(_fio->shortnames[slot]);
 
 #if defined(LIMITED_FDS)
-	_fio.usage_count[slot] = 0;
-	_fio.open_handles++;
+	_fio->usage_count[slot] = 0;
+	_fio->open_handles++;
 #endif /* LIMITED_FDS */
 	FioSeekToFile(slot, (uint32)pos);
 }
@@ -23,10 +23,70 @@ byte FioReadByte();
 uint16 FioReadWord();
 uint32 FioReadDword();
 void FioCloseAll();
+void FioCreateThreadFiles();
+void FioCloseThreadFiles();
 void FioOpenFile(uint slot, const char *filename, Subdirectory subdir);
 void FioReadBlock(void *ptr, size_t size);
 void FioSkipBytes(int n);
 
+/**
+ * Reader of the data of a slotted file.
+ * Files which are mapped into memory are read directly from the mapping without touching any
+ * shared state, so several threads can read at the same time. Other files are read with the
+ * buffered functions of the current thread, see #FioSeekToFile.
+ */
+class FioReader {
+	const byte *begin; ///< Start of the mapped file.
+	const byte *end;   ///< End of the mapped file.
+	const byte *pos;   ///< Current position in the mapped file, NULL when the file is not mapped.
+	size_t start;      ///< Position of the start of the mapped file in its handle, non-zero for files in a tar.
+
+public:
+	FioReader(uint slot, size_t pos);
+
+	/**
+	 * Read a byte.
+	 * @return The byte, 0 beyond the end of the file.
+	 */
+	inline byte ReadByte()
+	{
+		if (this->pos == NULL) return FioReadByte();
+		return this->pos != this->end ? *this->pos++ : 0;
+	}
+
+	/**
+	 * Read a word (16 bits, little endian).
+	 * @return The word.
+	 */
+	inline uint16 ReadWord()
+	{
+		byte b = this->ReadByte();
+		return (this->ReadByte() << 8) | b;
+	}
+
+	/**
+	 * Read a double word (32 bits, little endian).
+	 * @return The double word.
+	 */
+	inline uint32 ReadDword()
+	{
+		uint b = this->ReadWord();
+		return (this->ReadWord() << 16) | b;
+	}
+
+	/**
+	 * Get the position in the file handle, like #FioGetPos.
+	 * @return The position.
+	 */
+	inline size_t GetPos() const
+	{
+		return this->pos == NULL ? FioGetPos() : this->start + (this->pos - this->begin);
+	}
+
+	void ReadBlock(byte *ptr, size_t size);
+	void SkipBytes(size_t n);
+};
+
 /**
  * The search paths OpenTTD could search through.
  * At least one of the slots has to be filled with a path.
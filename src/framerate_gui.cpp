@@ -11,6 +11,8 @@
 
 #include "framerate_type.h"
 #include <chrono>
+#include <algorithm>
+#include <vector>
 #include "gfx_func.h"
 #include "window_gui.h"
 #include "table/sprites.h"
@@ -18,6 +20,7 @@
 #include "debug.h"
 #include "console_func.h"
 #include "console_type.h"
+#include "fileio_func.h"
 
 #include "widgets/framerate_widget.h"
 
@@ -32,6 +35,18 @@ namespace {
 	/** %Units a second is divided into in performance measurements */
 	const TimingMeasurement TIMESTAMP_PRECISION = 1000000;
 
+	/** Whether all measurements are currently being recorded, see #StartPerformanceRecording */
+	bool _pf_recording_active = false;
+	/** Start time of the current recording */
+	TimingMeasurement _pf_recording_start;
+	/** End time of the last recording */
+	TimingMeasurement _pf_recording_end;
+	/** All measurements of each element taken while recording */
+	std::vector<TimingMeasurement> _pf_recording[PFE_MAX];
+
+	struct PerformanceData;
+	extern PerformanceData _pf_data[PFE_MAX];
+
 	struct PerformanceData {
 		/** Duration value indicating the value is not valid should be considered a gap in measurements */
 		static const TimingMeasurement INVALID_DURATION = UINT64_MAX;
@@ -65,6 +80,9 @@ namespace {
 		/** Collect a complete measurement, given start and ending times for a processing block */
 		void Add(TimingMeasurement start_time, TimingMeasurement end_time)
 		{
+			/* Sound is measured on the mixer thread, while recordings are only handled by the main thread. */
+			if (_pf_recording_active && this != &_pf_data[PFE_SOUND]) _pf_recording[this - _pf_data].push_back(end_time - start_time);
+
 			this->durations[this->next_index] = end_time - start_time;
 			this->timestamps[this->next_index] = start_time;
 			this->prev_index = this->next_index;
@@ -76,6 +94,11 @@ namespace {
 		/** Begin an accumulation of multiple measurements into a single value, from a given start time */
 		void BeginAccumulate(TimingMeasurement start_time)
 		{
+			/* Only record cycles which started after the recording did. */
+			if (_pf_recording_active && this->acc_timestamp >= _pf_recording_start) {
+				_pf_recording[this - _pf_data].push_back(this->acc_duration);
+			}
+
 			this->timestamps[this->next_index] = this->acc_timestamp;
 			this->durations[this->next_index] = this->acc_duration;
 			this->prev_index = this->next_index;
@@ -185,8 +208,85 @@ namespace {
 		PerformanceData(1000.0 * 8192 / 44100), // PFE_SOUND
 	};
 
+	/** Number of game ticks to keep in buffer for each profiling zone */
+	const int NUM_ZONE_POINTS = 64;
+
+	/** Measurements of a profiling zone, summed per game tick */
+	struct PerformanceZoneData {
+		/** Total time spent in the zone in each tick, circular buffer */
+		TimingMeasurement total[NUM_ZONE_POINTS];
+		/** Time spent in the zone outside nested zones in each tick, circular buffer */
+		TimingMeasurement self[NUM_ZONE_POINTS];
+		/** Number of times the zone was entered in each tick, circular buffer */
+		uint32 calls[NUM_ZONE_POINTS];
+
+		/** Total time of the current tick */
+		TimingMeasurement acc_total;
+		/** Time outside nested zones of the current tick */
+		TimingMeasurement acc_self;
+		/** Number of calls in the current tick */
+		uint32 acc_calls;
+
+		/** Get the average of a circular buffer over the valid data points */
+		template <typename T>
+		static double GetAverage(const T *values, int num_valid)
+		{
+			if (num_valid == 0) return 0;
+			double sum = 0;
+			for (int i = 0; i < num_valid; i++) sum += values[i];
+			return sum / num_valid;
+		}
+	};
+
+	/** Storage for all profiling zone measurements */
+	PerformanceZoneData _pf_zone_data[PFZ_MAX];
+	/** Next index to write to in the #PerformanceZoneData buffers */
+	int _pf_zone_next_index;
+	/** Number of ticks recorded in the #PerformanceZoneData buffers, clamped to \c NUM_ZONE_POINTS */
+	int _pf_zone_num_valid;
+	/** Innermost zone currently being measured */
+	PerformanceZoneMeasurer *_pf_zone_current;
+
+	/** Whether zones were enabled by #SetPerformanceZonesEnabled */
+	bool _pf_zones_enabled = false;
+	/** Whether the profiling zones window is open */
+	bool _pf_zones_window_open = false;
+	/** Whether a trace is being recorded, see #StartPerformanceTrace */
+	bool _pf_trace_active = false;
+	/** Start time of the current trace */
+	TimingMeasurement _pf_trace_start;
+
+	/** Maximum number of events kept in a trace, later events are dropped */
+	const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+	/** One measured block of a trace */
+	struct PerformanceTraceEvent {
+		TimingMeasurement start;    ///< Start time of the block
+		TimingMeasurement duration; ///< Duration of the block
+		uint id;                    ///< #PerformanceElement of the block, or \c PFE_MAX plus its #PerformanceZone
+	};
+
+	/** Events of the current or last trace */
+	std::vector<PerformanceTraceEvent> _pf_trace;
+	/** Number of events dropped from the current or last trace */
+	size_t _pf_trace_dropped;
+
+	/** Add an event to the trace */
+	inline void AddTraceEvent(uint id, TimingMeasurement start_time, TimingMeasurement end_time)
+	{
+		if (start_time < _pf_trace_start) return;
+		if (_pf_trace.size() >= MAX_TRACE_EVENTS) {
+			_pf_trace_dropped++;
+			return;
+		}
+		PerformanceTraceEvent ev = { start_time, end_time - start_time, id };
+		_pf_trace.push_back(ev);
+	}
+
 }
 
+bool _pf_zones_active = false;
+
 
 /**
  * Return a timestamp with \c TIMESTAMP_PRECISION ticks per second precision.
@@ -215,7 +315,10 @@ PerformanceMeasurer::PerformanceMeasurer(PerformanceElement elem)
 /** Finish a cycle of a measured element and store the measurement taken. */
 PerformanceMeasurer::~PerformanceMeasurer()
 {
-	_pf_data[this->elem].Add(this->start_time, GetPerformanceTimer());
+	TimingMeasurement end_time = GetPerformanceTimer();
+	_pf_data[this->elem].Add(this->start_time, end_time);
+	/* Sound is measured on the mixer thread, while the trace is only handled by the main thread. */
+	if (_pf_trace_active && this->elem != PFE_SOUND) AddTraceEvent(this->elem, this->start_time, end_time);
 }
 
 /** Set the rate of expected cycles per second of a performance element. */
@@ -249,7 +352,9 @@ PerformanceAccumulator::PerformanceAccumulator(PerformanceElement elem)
 /** Finish and add one block of the accumulating value. */
 PerformanceAccumulator::~PerformanceAccumulator()
 {
-	_pf_data[this->elem].AddAccumulate(GetPerformanceTimer() - this->start_time);
+	TimingMeasurement end_time = GetPerformanceTimer();
+	_pf_data[this->elem].AddAccumulate(end_time - this->start_time);
+	if (_pf_trace_active) AddTraceEvent(this->elem, this->start_time, end_time);
 }
 
 /**
@@ -263,7 +368,118 @@ void PerformanceAccumulator::Reset(PerformanceElement elem)
 }
 
 
+/** Begin measuring a profiling zone. */
+void PerformanceZoneMeasurer::Begin()
+{
+	assert(this->zone < PFZ_MAX);
+
+	this->child_time = 0;
+	this->parent = _pf_zone_current;
+	_pf_zone_current = this;
+	this->start_time = GetPerformanceTimer();
+}
+
+/** Finish measuring a profiling zone and add the time taken to it and its enclosing zone. */
+void PerformanceZoneMeasurer::End()
+{
+	TimingMeasurement end_time = GetPerformanceTimer();
+	TimingMeasurement duration = end_time - this->start_time;
+
+	PerformanceZoneData &data = _pf_zone_data[this->zone];
+	data.acc_total += duration;
+	data.acc_self += duration - min(duration, this->child_time);
+	data.acc_calls++;
+
+	if (this->parent != NULL) this->parent->child_time += duration;
+	_pf_zone_current = this->parent;
+
+	if (_pf_trace_active) AddTraceEvent(PFE_MAX + this->zone, this->start_time, end_time);
+}
+
+/**
+ * Store the measurements of all profiling zones for the past game tick.
+ * @note This function must be called once per game tick, otherwise measurements are not collected.
+ */
+void PerformanceZoneMeasurer::Tick()
+{
+	if (!_pf_zones_active) return;
+
+	for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+		PerformanceZoneData &data = _pf_zone_data[z];
+		data.total[_pf_zone_next_index] = data.acc_total;
+		data.self[_pf_zone_next_index] = data.acc_self;
+		data.calls[_pf_zone_next_index] = data.acc_calls;
+		data.acc_total = 0;
+		data.acc_self = 0;
+		data.acc_calls = 0;
+	}
+	_pf_zone_next_index = (_pf_zone_next_index + 1) % NUM_ZONE_POINTS;
+	_pf_zone_num_valid = min(NUM_ZONE_POINTS, _pf_zone_num_valid + 1);
+}
+
+/** Update whether zones need to be measured, and discard old measurements when starting. */
+static void UpdatePerformanceZonesActive()
+{
+	bool active = _pf_zones_enabled || _pf_trace_active || _pf_zones_window_open;
+	if (active == _pf_zones_active) return;
+
+	if (active) {
+		MemSetT(_pf_zone_data, 0, PFZ_MAX);
+		_pf_zone_next_index = 0;
+		_pf_zone_num_valid = 0;
+	}
+	_pf_zones_active = active;
+}
+
+/**
+ * Enable or disable the measurement of profiling zones.
+ * Zones are also measured while a trace is recorded or the zones window is open.
+ * @param enabled Whether to measure zones.
+ */
+void SetPerformanceZonesEnabled(bool enabled)
+{
+	_pf_zones_enabled = enabled;
+	UpdatePerformanceZonesActive();
+}
+
+/**
+ * Get the name of a profiling zone, as used in the console and in traces.
+ * @param zone The zone.
+ * @return Name of the zone.
+ */
+const char *GetPerformanceZoneName(PerformanceZone zone)
+{
+	static const char * const ZONE_NAMES[PFZ_MAX] = {
+		"Train movement",
+		"Train pathfinding",
+		"Road vehicle pathfinding",
+		"Ship pathfinding",
+		"Signal updates",
+		"Loading and unloading",
+		"NewGRF callbacks",
+		"Tile loop: clear",
+		"Tile loop: railway",
+		"Tile loop: road",
+		"Tile loop: house",
+		"Tile loop: trees",
+		"Tile loop: station",
+		"Tile loop: water",
+		"Tile loop: void",
+		"Tile loop: industry",
+		"Tile loop: tunnel/bridge",
+		"Tile loop: object",
+		"AI scripts",
+		"Game script",
+		"Link graph join",
+		"Station ratings",
+	};
+	assert(zone < PFZ_MAX);
+	return ZONE_NAMES[zone];
+}
+
+
 void ShowFrametimeGraphWindow(PerformanceElement elem);
+void ShowFrameZonesWindow();
 
 
 /** @hideinitializer */
@@ -291,6 +507,7 @@ static const NWidgetPart _framerate_window_widgets[] = {
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_INFO_DATA_POINTS), SetDataTip(STR_FRAMERATE_DATA_POINTS, 0x0),
 		EndContainer(),
 	EndContainer(),
+	NWidget(WWT_PUSHTXTBTN, COLOUR_GREY, WID_FRW_ZONES), SetFill(1, 0), SetDataTip(STR_FRAMERATE_ZONES, STR_FRAMERATE_ZONES_TOOLTIP),
 };
 
 struct FramerateWindow : Window {
@@ -498,6 +715,10 @@ struct FramerateWindow : Window {
 				}
 				break;
 			}
+
+			case WID_FRW_ZONES:
+				ShowFrameZonesWindow();
+				break;
 		}
 	}
 };
@@ -790,6 +1011,166 @@ static WindowDesc _frametime_graph_window_desc(
 );
 
 
+/** @hideinitializer */
+static const NWidgetPart _frame_zones_window_widgets[] = {
+	NWidget(NWID_HORIZONTAL),
+		NWidget(WWT_CLOSEBOX, COLOUR_GREY),
+		NWidget(WWT_CAPTION, COLOUR_GREY), SetDataTip(STR_FRAMEZONES_CAPTION, STR_TOOLTIP_WINDOW_TITLE_DRAG_THIS),
+		NWidget(WWT_SHADEBOX, COLOUR_GREY),
+		NWidget(WWT_STICKYBOX, COLOUR_GREY),
+	EndContainer(),
+	NWidget(WWT_PANEL, COLOUR_GREY),
+		NWidget(NWID_VERTICAL), SetPadding(6), SetPIP(0, 3, 0),
+			NWidget(NWID_HORIZONTAL), SetPIP(0, 6, 0),
+				NWidget(WWT_EMPTY, COLOUR_GREY, WID_FZW_NAMES),
+				NWidget(WWT_EMPTY, COLOUR_GREY, WID_FZW_CALLS),
+				NWidget(WWT_EMPTY, COLOUR_GREY, WID_FZW_TOTAL),
+				NWidget(WWT_EMPTY, COLOUR_GREY, WID_FZW_SELF),
+			EndContainer(),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FZW_INFO_DATA_POINTS), SetDataTip(STR_FRAMEZONES_DATA_POINTS, 0x0),
+		EndContainer(),
+	EndContainer(),
+};
+
+struct FrameZonesWindow : Window {
+	typedef FramerateWindow::CachedDecimal CachedDecimal;
+
+	uint32 next_update;
+
+	uint32 calls[PFZ_MAX];          ///< cached average calls per tick, times 10
+	CachedDecimal times_total[PFZ_MAX]; ///< cached average total times per tick
+	CachedDecimal times_self[PFZ_MAX];  ///< cached average times outside nested zones per tick
+
+	static const int VSPACING = 3; ///< space between column heading and values
+
+	FrameZonesWindow(WindowDesc *desc, WindowNumber number) : Window(desc)
+	{
+		_pf_zones_window_open = true;
+		UpdatePerformanceZonesActive();
+		this->next_update = 0;
+		this->InitNested(number);
+		this->UpdateData();
+	}
+
+	~FrameZonesWindow()
+	{
+		_pf_zones_window_open = false;
+		UpdatePerformanceZonesActive();
+	}
+
+	virtual void OnTick()
+	{
+		if (_realtime_tick >= this->next_update) {
+			this->UpdateData();
+			this->SetDirty();
+			this->next_update = _realtime_tick + 100;
+		}
+	}
+
+	void UpdateData()
+	{
+		for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+			const PerformanceZoneData &data = _pf_zone_data[z];
+			const double to_ms = 1000.0 / TIMESTAMP_PRECISION;
+			this->calls[z] = (uint32)(PerformanceZoneData::GetAverage(data.calls, _pf_zone_num_valid) * 10);
+			this->times_total[z].SetTime(PerformanceZoneData::GetAverage(data.total, _pf_zone_num_valid) * to_ms, MILLISECONDS_PER_TICK);
+			this->times_self[z].SetTime(PerformanceZoneData::GetAverage(data.self, _pf_zone_num_valid) * to_ms, MILLISECONDS_PER_TICK);
+		}
+	}
+
+	virtual void SetStringParameters(int widget) const
+	{
+		if (widget == WID_FZW_INFO_DATA_POINTS) SetDParam(0, _pf_zone_num_valid);
+	}
+
+	virtual void UpdateWidgetSize(int widget, Dimension *size, const Dimension &padding, Dimension *fill, Dimension *resize)
+	{
+		switch (widget) {
+			case WID_FZW_NAMES:
+				size->width = 0;
+				size->height = FONT_HEIGHT_NORMAL * (PFZ_MAX + 1) + VSPACING;
+				for (int line = 0; line < PFZ_MAX; line++) {
+					Dimension line_size = GetStringBoundingBox(STR_FRAMEZONES_TRAIN_CONTROLLER + line);
+					size->width = max(size->width, line_size.width);
+				}
+				break;
+
+			case WID_FZW_CALLS:
+			case WID_FZW_TOTAL:
+			case WID_FZW_SELF: {
+				*size = GetStringBoundingBox(STR_FRAMEZONES_CALLS + (widget - WID_FZW_CALLS));
+				SetDParam(0, 999999);
+				SetDParam(1, widget == WID_FZW_CALLS ? 1 : 2);
+				Dimension item_size = GetStringBoundingBox(widget == WID_FZW_CALLS ? STR_FRAMEZONES_CALLS_VALUE : STR_FRAMERATE_MS_GOOD);
+				size->width = max(size->width, item_size.width);
+				size->height += FONT_HEIGHT_NORMAL * PFZ_MAX + VSPACING;
+				break;
+			}
+
+			case WID_FZW_INFO_DATA_POINTS:
+				SetDParam(0, NUM_ZONE_POINTS);
+				*size = GetStringBoundingBox(STR_FRAMEZONES_DATA_POINTS);
+				break;
+		}
+	}
+
+	/** Render a column of formatted average durations */
+	void DrawZoneTimesColumn(const Rect &r, StringID heading_str, const CachedDecimal *values) const
+	{
+		int y = r.top;
+		DrawString(r.left, r.right, y, heading_str, TC_FROMSTRING, SA_CENTER, true);
+		y += FONT_HEIGHT_NORMAL + VSPACING;
+
+		for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+			values[z].InsertDParams(0);
+			DrawString(r.left, r.right, y, values[z].strid, TC_FROMSTRING, SA_RIGHT);
+			y += FONT_HEIGHT_NORMAL;
+		}
+	}
+
+	virtual void DrawWidget(const Rect &r, int widget) const
+	{
+		switch (widget) {
+			case WID_FZW_NAMES: {
+				int y = r.top + FONT_HEIGHT_NORMAL + VSPACING; // first line contains headings in the value columns
+				for (int i = 0; i < PFZ_MAX; i++) {
+					DrawString(r.left, r.right, y, STR_FRAMEZONES_TRAIN_CONTROLLER + i, TC_FROMSTRING, SA_LEFT);
+					y += FONT_HEIGHT_NORMAL;
+				}
+				break;
+			}
+
+			case WID_FZW_CALLS: {
+				int y = r.top;
+				DrawString(r.left, r.right, y, STR_FRAMEZONES_CALLS, TC_FROMSTRING, SA_CENTER, true);
+				y += FONT_HEIGHT_NORMAL + VSPACING;
+				for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+					SetDParam(0, this->calls[z]);
+					SetDParam(1, 1);
+					DrawString(r.left, r.right, y, STR_FRAMEZONES_CALLS_VALUE, TC_FROMSTRING, SA_RIGHT);
+					y += FONT_HEIGHT_NORMAL;
+				}
+				break;
+			}
+
+			case WID_FZW_TOTAL:
+				DrawZoneTimesColumn(r, STR_FRAMEZONES_TOTAL, this->times_total);
+				break;
+			case WID_FZW_SELF:
+				DrawZoneTimesColumn(r, STR_FRAMEZONES_SELF, this->times_self);
+				break;
+		}
+	}
+};
+
+static WindowDesc _frame_zones_window_desc(
+	WDP_AUTO, "frame_zones", 0, 0,
+	WC_FRAME_ZONES, WC_NONE,
+	0,
+	_frame_zones_window_widgets, lengthof(_frame_zones_window_widgets)
+);
+
+
 
 /** Open the general framerate window */
 void ShowFramerateWindow()
@@ -804,6 +1185,12 @@ void ShowFrametimeGraphWindow(PerformanceElement elem)
 	AllocateWindowDescFront<FrametimeGraphWindow>(&_frametime_graph_window_desc, elem, true);
 }
 
+/** Open the profiling zones window, which also enables measuring the zones while it is open */
+void ShowFrameZonesWindow()
+{
+	AllocateWindowDescFront<FrameZonesWindow>(&_frame_zones_window_desc, 0);
+}
+
 /** Print performance statistics to game console */
 void ConPrintFramerate()
 {
@@ -857,3 +1244,163 @@ void ConPrintFramerate()
 		IConsoleWarning("No performance measurements have been taken yet");
 	}
 }
+
+
+/**
+ * Get the name of a performance element as used in reports and traces.
+ * @param elem The element.
+ * @return Name of the element.
+ */
+static const char *GetPerformanceElementReportName(PerformanceElement elem)
+{
+	/** Names of the elements in reports, in #PerformanceElement order. */
+	static const char * const REPORT_NAMES[PFE_MAX] = {
+		"gameloop",
+		"gl_economy",
+		"gl_trains",
+		"gl_roadvehs",
+		"gl_ships",
+		"gl_aircraft",
+		"gl_landscape",
+		"gl_linkgraph",
+		"drawing",
+		"drawworld",
+		"video",
+		"sound",
+	};
+	assert(elem < PFE_MAX);
+	return REPORT_NAMES[elem];
+}
+
+/**
+ * Start recording every measurement of all performance elements, in addition
+ * to the usual limited history. Any previous recording is discarded.
+ * Sound is not recorded, as it is measured on the mixer thread.
+ */
+void StartPerformanceRecording()
+{
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) _pf_recording[e].clear();
+	_pf_recording_start = GetPerformanceTimer();
+	_pf_recording_active = true;
+}
+
+/** Stop recording measurements, see #StartPerformanceRecording. */
+void StopPerformanceRecording()
+{
+	_pf_recording_end = GetPerformanceTimer();
+	_pf_recording_active = false;
+}
+
+/**
+ * Write a report of the last performance recording in JSON format.
+ * For each performance element with measurements the number of measurements
+ * and the minimum, average, 99th percentile and maximum duration are written.
+ * @param filename File to write the report to.
+ * @param ticks Number of game ticks run during the recording.
+ * @return True if the report was written.
+ */
+bool WritePerformanceReport(const char *filename, uint ticks)
+{
+	FILE *f = FioFOpenFile(filename, "w", NO_DIRECTORY);
+	if (f == NULL) return false;
+
+	const double elapsed = (double)(_pf_recording_end - _pf_recording_start) / TIMESTAMP_PRECISION;
+	fprintf(f, "{\n");
+	fprintf(f, "  \"ticks\": %u,\n", ticks);
+	fprintf(f, "  \"elapsed_seconds\": %.6f,\n", elapsed);
+	fprintf(f, "  \"ticks_per_second\": %.3f,\n", elapsed > 0 ? ticks / elapsed : 0.0);
+	fprintf(f, "  \"peak_rss_bytes\": " OTTD_PRINTF64U ",\n", (uint64)GetPeakMemoryUsage());
+	fprintf(f, "  \"elements\": {");
+
+	bool first = true;
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		std::vector<TimingMeasurement> &durations = _pf_recording[e];
+		if (durations.empty()) continue;
+
+		std::sort(durations.begin(), durations.end());
+		TimingMeasurement sum = 0;
+		for (TimingMeasurement d : durations) sum += d;
+		const size_t p99 = min<size_t>(durations.size() - 1, (durations.size() * 99 + 99) / 100 - 1);
+		const double to_ms = 1000.0 / TIMESTAMP_PRECISION;
+
+		fprintf(f, "%s\n    \"%s\": { \"count\": " PRINTF_SIZE ", \"min_ms\": %.3f, \"avg_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f }",
+				first ? "" : ",", GetPerformanceElementReportName(e), durations.size(),
+				durations.front() * to_ms, (double)sum / durations.size() * to_ms, durations[p99] * to_ms, durations.back() * to_ms);
+		first = false;
+	}
+
+	fprintf(f, "\n  }\n}\n");
+	FioFCloseFile(f);
+	return true;
+}
+
+
+/** Print the measurements of the profiling zones to the game console */
+void ConPrintPerformanceZones()
+{
+	if (_pf_zone_num_valid == 0) {
+		IConsoleWarning(_pf_zones_active ? "No profiling zone measurements have been taken yet" : "Profiling zones are not enabled, use 'profile on' first");
+		return;
+	}
+
+	IConsolePrintF(TC_SILVER, "Averages per tick over %d ticks: calls, total time, time outside nested zones", _pf_zone_num_valid);
+
+	const double to_ms = 1000.0 / TIMESTAMP_PRECISION;
+	for (PerformanceZone z = PFZ_FIRST; z < PFZ_MAX; z++) {
+		const PerformanceZoneData &data = _pf_zone_data[z];
+		double calls = PerformanceZoneData::GetAverage(data.calls, _pf_zone_num_valid);
+		if (calls == 0) continue;
+		IConsolePrintF(TC_LIGHT_BLUE, "%s: %.1f  %.3fms  %.3fms",
+			GetPerformanceZoneName(z),
+			calls,
+			PerformanceZoneData::GetAverage(data.total, _pf_zone_num_valid) * to_ms,
+			PerformanceZoneData::GetAverage(data.self, _pf_zone_num_valid) * to_ms);
+	}
+}
+
+/**
+ * Start recording a trace of all measured performance elements and profiling zones.
+ * Any previous trace is discarded. Sound is not traced, as it is measured on the mixer thread.
+ */
+void StartPerformanceTrace()
+{
+	_pf_trace.clear();
+	_pf_trace_dropped = 0;
+	_pf_trace_start = GetPerformanceTimer();
+	_pf_trace_active = true;
+	UpdatePerformanceZonesActive();
+}
+
+/** Stop recording a trace, see #StartPerformanceTrace. */
+void StopPerformanceTrace()
+{
+	_pf_trace_active = false;
+	UpdatePerformanceZonesActive();
+}
+
+/**
+ * Write the last recorded trace in the Chrome trace event format.
+ * The file can be viewed with chrome://tracing or compatible tools.
+ * @param filename File to write the trace to.
+ * @return True if the trace was written.
+ */
+bool WritePerformanceTrace(const char *filename)
+{
+	FILE *f = FioFOpenFile(filename, "w", NO_DIRECTORY);
+	if (f == NULL) return false;
+
+	fprintf(f, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": " PRINTF_SIZE "}, \"traceEvents\": [", _pf_trace_dropped);
+	bool first = true;
+	for (const PerformanceTraceEvent &ev : _pf_trace) {
+		const bool is_zone = ev.id >= PFE_MAX;
+		fprintf(f, "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": " OTTD_PRINTF64U ", \"dur\": " OTTD_PRINTF64U ", \"pid\": 1, \"tid\": 1}",
+				first ? "" : ",",
+				is_zone ? GetPerformanceZoneName((PerformanceZone)(ev.id - PFE_MAX)) : GetPerformanceElementReportName((PerformanceElement)ev.id),
+				is_zone ? "zone" : "element",
+				ev.start - _pf_trace_start, ev.duration);
+		first = false;
+	}
+	fprintf(f, "\n]}\n");
+	FioFCloseFile(f);
+	return true;
+}
@@ -20,7 +20,8 @@
  * Second is adding a member to the \link anonymous_namespace{framerate_gui.cpp}::_pf_data _pf_data \endlink array, in the same position as the new #PerformanceElement member.
  *
  * @par
- * Third is adding strings for the new element. There is an array in #ConPrintFramerate with strings used for the console command.
+ * Third is adding strings for the new element. There is an array in #ConPrintFramerate with strings used for the console command,
+ * and an array in #GetPerformanceElementReportName with the names used in benchmark reports and traces.
  * Additionally, there are two sets of strings in \c english.txt for two GUI uses, also in the #PerformanceElement order.
  * Search for \c STR_FRAMERATE_GAMELOOP and \c STR_FRAMETIME_CAPTION_GAMELOOP in \c english.txt to find those.
  *
@@ -31,6 +32,12 @@
  * Either class is used by instantiating an object of it at the beginning of the block to be measured, so it auto-destructs at the end of the block.
  * For PerformanceAccumulator, make sure to also call PerformanceAccumulator::Reset once at the beginning of a new frame. Usually the StateGameLoop function is appropriate for this.
  *
+ * @par Adding new profiling zones
+ * Profiling zones break the game loop elements down further, see #PerformanceZone.
+ * Add a new member to the #PerformanceZone enum before \c PFZ_MAX, a name to the array in #GetPerformanceZoneName,
+ * and a \c STR_FRAMEZONES_ string in \c english.txt in the #PerformanceZone order.
+ * Then instantiate a PerformanceZoneMeasurer at the beginning of the block to be measured.
+ *
  * @see framerate_gui.cpp for implementation
  */
 
@@ -39,6 +46,7 @@
 
 #include "stdafx.h"
 #include "core/enum_type.hpp"
+#include "tile_type.h"
 
 /**
  * Elements of game performance that can be measured.
@@ -64,6 +72,33 @@ enum PerformanceElement {
 };
 DECLARE_POSTFIX_INCREMENT(PerformanceElement)
 
+/**
+ * Zones of game loop processing that can be profiled in more detail than the #PerformanceElement.
+ * Zones may be nested, e.g. pathfinding happens while a train is being moved. For each zone
+ * both the total time and the time spent outside of any nested zones are recorded.
+ *
+ * @note When adding new zones here, make sure to also update all other locations depending on the length and order of this enum.
+ * See <em>Adding new profiling zones</em> above.
+ */
+enum PerformanceZone {
+	PFZ_FIRST = 0,
+	PFZ_TRAIN_CONTROLLER = 0, ///< Moving trains along their track
+	PFZ_TRAIN_PATHFINDER,     ///< Finding paths for trains
+	PFZ_ROADVEH_PATHFINDER,   ///< Finding paths for road vehicles
+	PFZ_SHIP_PATHFINDER,      ///< Finding paths for ships
+	PFZ_SIGNALS,              ///< Updating signal blocks
+	PFZ_LOAD_UNLOAD,          ///< Loading and unloading vehicles at stations
+	PFZ_NEWGRF_CALLBACKS,     ///< Resolving NewGRF callbacks
+	PFZ_TILELOOP_FIRST,       ///< Tile loop of the first #TileType, followed by the other tile types
+	PFZ_TILELOOP_LAST = PFZ_TILELOOP_FIRST + MP_OBJECT, ///< Tile loop of the last #TileType
+	PFZ_AI,                   ///< Running AI scripts
+	PFZ_GAMESCRIPT,           ///< Running the game script
+	PFZ_LINKGRAPH_JOIN,       ///< Merging link graph job results
+	PFZ_STATION_RATINGS,      ///< Updating station ratings and removing cargo from bad stations
+	PFZ_MAX,                  ///< End of enum, must be last.
+};
+DECLARE_POSTFIX_INCREMENT(PerformanceZone)
+
 /** Type used to hold a performance timing measurement */
 typedef uint64 TimingMeasurement;
 
@@ -104,6 +139,55 @@ public:
 	static void Reset(PerformanceElement elem);
 };
 
+/** Whether profiling zones are currently being measured, see #SetPerformanceZonesEnabled */
+extern bool _pf_zones_active;
+
+/**
+ * RAII class for measuring a profiling zone.
+ * Construct an object with the appropriate zone parameter when processing begins,
+ * time is automatically taken when the object goes out of scope again.
+ * Nothing is measured unless profiling zones are enabled.
+ * Zones may only be measured on the main thread, as the stack of zones being
+ * measured and the trace they are added to are not synchronised.
+ *
+ * Call Tick once per game tick to complete the measurements of the tick.
+ */
+class PerformanceZoneMeasurer {
+	PerformanceZone zone;
+	bool active;
+	TimingMeasurement start_time;
+	TimingMeasurement child_time;
+	PerformanceZoneMeasurer *parent;
+
+	void Begin();
+	void End();
+public:
+	inline PerformanceZoneMeasurer(PerformanceZone zone) : zone(zone), active(_pf_zones_active)
+	{
+		if (this->active) this->Begin();
+	}
+
+	inline ~PerformanceZoneMeasurer()
+	{
+		if (this->active) this->End();
+	}
+
+	static void Tick();
+};
+
 void ShowFramerateWindow();
 
+void SetPerformanceZonesEnabled(bool enabled);
+const char *GetPerformanceZoneName(PerformanceZone zone);
+void StartPerformanceTrace();
+void StopPerformanceTrace();
+bool WritePerformanceTrace(const char *filename);
+
+void StartPerformanceRecording();
+void StopPerformanceRecording();
+bool WritePerformanceReport(const char *filename, uint ticks);
+
+/* Implemented in the OS specific files. */
+size_t GetPeakMemoryUsage();
+
 #endif /* FRAMERATE_TYPE_H */
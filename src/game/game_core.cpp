@@ -15,6 +15,7 @@
 #include "../company_func.h"
 #include "../network/network.h"
 #include "../window_func.h"
+#include "../framerate_type.h"
 #include "game.hpp"
 #include "game_scanner.hpp"
 #include "game_config.hpp"
@@ -36,6 +37,7 @@
 
 	Game::frame_counter++;
 
+	PerformanceZoneMeasurer zone(PFZ_GAMESCRIPT);
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	cur_company.Change(OWNER_DEITY);
 	Game::instance->GameLoop();
@@ -307,21 +307,31 @@ void DrawBox(int x, int y, int dx1, int dy1, int dx2, int dy2, int dx3, int dy3)
 }
 
 /**
- * Set the colour remap to be for the given colour.
- * @param colour the new colour of the remap.
+ * Fill a recolour map for drawing with the given colour.
+ * @param colour The colour, not #TC_INVALID.
+ * @param remap The recolour map to fill.
  */
-static void SetColourRemap(TextColour colour)
+static void FillColourRemap(TextColour colour, byte *remap)
 {
-	if (colour == TC_INVALID) return;
-
 	/* Black strings have no shading ever; the shading is black, so it
 	 * would be invisible at best, but it actually makes it illegible. */
 	bool no_shade   = (colour & TC_NO_SHADE) != 0 || colour == TC_BLACK;
 	bool raw_colour = (colour & TC_IS_PALETTE_COLOUR) != 0;
 	colour &= ~(TC_NO_SHADE | TC_IS_PALETTE_COLOUR);
 
-	_string_colourremap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
-	_string_colourremap[2] = no_shade ? 0 : 1;
+	remap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
+	remap[2] = no_shade ? 0 : 1;
+}
+
+/**
+ * Set the colour remap to be for the given colour.
+ * @param colour the new colour of the remap.
+ */
+static void SetColourRemap(TextColour colour)
+{
+	if (colour == TC_INVALID) return;
+
+	FillColourRemap(colour, _string_colourremap);
 	_colour_remap_ptr = _string_colourremap;
 }
 
@@ -821,6 +831,46 @@ void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSpri
 	}
 }
 
+/**
+ * Look up everything needed to draw a sprite in a viewport.
+ * The sprite can then be drawn by #DrawResolvedSpriteViewport from any thread,
+ * as long as the sprite cache is not changed in the meantime.
+ * @param rs   The resolved sprite to fill.
+ * @param img  Image number to draw
+ * @param pal  Palette to use.
+ * @param x    Left coordinate of image in viewport, scaled by zoom
+ * @param y    Top coordinate of image in viewport, scaled by zoom
+ * @param sub  If available, draw only specified part of the sprite
+ */
+void ResolveSpriteViewport(ResolvedViewportSprite *rs, SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub)
+{
+	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
+	rs->sprite = GetSprite(real_sprite, ST_NORMAL);
+	rs->remap = NULL;
+	rs->sub = sub;
+	rs->x = x;
+	rs->y = y;
+	rs->text_remap[0] = 0;
+	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
+		rs->remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		rs->mode = BM_TRANSPARENT;
+	} else if (pal != PAL_NONE) {
+		if (HasBit(pal, PALETTE_TEXT_RECOLOUR)) {
+			TextColour colour = (TextColour)GB(pal, 0, PALETTE_WIDTH);
+			if (colour == TC_INVALID) {
+				rs->mode = BM_NORMAL;
+				return;
+			}
+			FillColourRemap(colour, rs->text_remap);
+		} else {
+			rs->remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		}
+		rs->mode = GetBlitterMode(pal);
+	} else {
+		rs->mode = BM_NORMAL;
+	}
+}
+
 /**
  * Draw a sprite, not in a viewport
  * @param img  Image number to draw
@@ -856,13 +906,14 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
  * @param mode   The settings for the blitter to pass.
  * @param sub    Whether to only draw a sub set of the sprite.
  * @param zoom   The zoom level at which to draw the sprites.
+ * @param dpi    The area to draw in.
+ * @param remap  The recolour map to use, if the mode needs one.
  * @tparam ZOOM_BASE The factor required to get the sub sprite information into the right size.
  * @tparam SCALED_XY Whether the X and Y are scaled or unscaled.
  */
 template <int ZOOM_BASE, bool SCALED_XY>
-static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom)
+static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom, const DrawPixelInfo *dpi, const byte *remap)
 {
-	const DrawPixelInfo *dpi = _cur_dpi;
 	Blitter::BlitterParams bp;
 
 	if (SCALED_XY) {
@@ -909,7 +960,7 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 	bp.dst = dpi->dst_ptr;
 	bp.pitch = dpi->pitch;
-	bp.remap = _colour_remap_ptr;
+	bp.remap = remap;
 
 	assert(sprite->width > 0);
 	assert(sprite->height > 0);
@@ -979,12 +1030,25 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id)
 {
-	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom);
+	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom, _cur_dpi, _colour_remap_ptr);
 }
 
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id, ZoomLevel zoom)
 {
-	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom);
+	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom, _cur_dpi, _colour_remap_ptr);
+}
+
+/**
+ * Draw a sprite resolved by #ResolveSpriteViewport.
+ * Unlike the other drawing functions this does not use any global drawing state, so it can be used by any thread.
+ * @param dpi The area to draw in.
+ * @param rs  The sprite to draw.
+ * @note The sprite picker is not supported, the caller has to draw on the main thread when it is active.
+ */
+void DrawResolvedSpriteViewport(const DrawPixelInfo *dpi, const ResolvedViewportSprite *rs)
+{
+	const byte *remap = rs->remap != NULL ? rs->remap : rs->text_remap;
+	GfxBlitter<ZOOM_LVL_BASE, false>(rs->sprite, rs->x, rs->y, (BlitterMode)rs->mode, rs->sub, SPR_CURSOR_MOUSE, dpi->zoom, dpi, remap);
 }
 
 void DoPaletteAnimations();
@@ -1192,9 +1256,6 @@ void ScreenSizeChanged()
 	_dirty_bytes_per_line = CeilDiv(_screen.width, DIRTY_BLOCK_WIDTH);
 	_dirty_blocks = ReallocT<byte>(_dirty_blocks, _dirty_bytes_per_line * CeilDiv(_screen.height, DIRTY_BLOCK_HEIGHT));
 
-	extern uint32 *_vp_map_line;
-	_vp_map_line = ReallocT<uint32>(_vp_map_line, _screen.width);
-
 	/* check the dirty rect */
 	if (_invalid_rect.right >= _screen.width) _invalid_rect.right = _screen.width;
 	if (_invalid_rect.bottom >= _screen.height) _invalid_rect.bottom = _screen.height;
@@ -93,6 +93,22 @@ Dimension GetSpriteSize(SpriteID sprid, Point *offset = NULL, ZoomLevel zoom = Z
 void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = NULL);
 void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = NULL, ZoomLevel zoom = ZOOM_LVL_GUI);
 
+struct Sprite;
+
+/** A viewport sprite of which the sprite data and recolouring have been looked up, so it can be drawn by any thread. */
+struct ResolvedViewportSprite {
+	const Sprite *sprite; ///< Sprite data.
+	const byte *remap;    ///< Recolour map, or NULL to use #text_remap.
+	const SubSprite *sub; ///< Part of the sprite to draw, NULL for all of it.
+	int x;                ///< Left coordinate of the sprite in the viewport, scaled by zoom.
+	int y;                ///< Top coordinate of the sprite in the viewport, scaled by zoom.
+	byte mode;            ///< BlitterMode to draw the sprite with.
+	byte text_remap[3];   ///< Recolour map for sprites recoloured with a text colour.
+};
+
+void ResolveSpriteViewport(ResolvedViewportSprite *rs, SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = NULL);
+void DrawResolvedSpriteViewport(const DrawPixelInfo *dpi, const ResolvedViewportSprite *rs);
+
 /** How to align the to-be drawn text. */
 enum StringAlignment {
 	SA_LEFT        = 0 << 0, ///< Left align the text.
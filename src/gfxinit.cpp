@@ -349,6 +349,7 @@ static bool SwitchNewGRFBlitter()
 		if (BlitterFactory::GetBlitterFactory(repl_blitter) == NULL) continue;
 
 		DEBUG(misc, 1, "Switching blitter from '%s' to '%s'... ", cur_blitter, repl_blitter);
+		StopSpritePrefetch();
 		Blitter *new_blitter = BlitterFactory::SelectBlitter(repl_blitter);
 		if (new_blitter == NULL) NOT_REACHED();
 		DEBUG(misc, 1, "Successfully switched to %s.", repl_blitter);
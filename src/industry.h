@@ -18,6 +18,8 @@
 #include "industry_map.h"
 #include "industrytype.h"
 #include "tilearea_type.h"
+#include "tile_grid_index.h"
+#include "station_type.h"
 
 
 typedef Pool<Industry, IndustryID, 64, 64000> IndustryPool;
@@ -72,10 +74,14 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	PersistentStorage *psa;             ///< Persistent storage for NewGRF industries.
 
-	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0) {}
+	StationList stations_near;          ///< NOSAVE: Cached list of stations getting the produced cargo, see #GetStationsNear
+	uint32 stations_near_version;       ///< NOSAVE: Version of the station catchment index #stations_near was made with
+
+	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0), stations_near_version(0) {}
 	~Industry();
 
 	void RecomputeProductionMultipliers();
+	const StationList *GetStationsNear();
 
 	/**
 	 * Check if a given tile belongs to this industry.
@@ -166,6 +172,9 @@ void ReleaseDisastersTargetingIndustry(IndustryID);
 
 bool IsTileForestIndustry(TileIndex tile);
 
+extern TileGridIndex<IndustryID> _industry_grid;
+void RebuildIndustryGridIndex();
+
 #define FOR_ALL_INDUSTRIES_FROM(var, start) FOR_ALL_ITEMS_FROM(Industry, industry_index, var, start)
 #define FOR_ALL_INDUSTRIES(var) FOR_ALL_INDUSTRIES_FROM(var, 0)
 
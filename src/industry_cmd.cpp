@@ -13,6 +13,7 @@
 #include "clear_map.h"
 #include "industry.h"
 #include "station_base.h"
+#include "station_func.h"
 #include "landscape.h"
 #include "viewport_func.h"
 #include "command_func.h"
@@ -63,6 +64,7 @@ uint16 Industry::counts[NUM_INDUSTRYTYPES];
 IndustrySpec _industry_specs[NUM_INDUSTRYTYPES];
 IndustryTileSpec _industry_tile_specs[NUM_INDUSTRYTILES];
 IndustryBuildData _industry_builder; ///< In-game manager of industries.
+TileGridIndex<IndustryID> _industry_grid(4); ///< Spatial index of the areas of all industries.
 
 /**
  * This function initialize the spec arrays of both
@@ -143,6 +145,8 @@ Industry::~Industry()
 	 * Also we must not decrement industry counts in that case. */
 	if (this->location.w == 0) return;
 
+	_industry_grid.Remove(this->location, this->index);
+
 	TILE_AREA_LOOP(tile_cur, this->location) {
 		if (IsTileType(tile_cur, MP_INDUSTRY)) {
 			if (GetIndustryIndex(tile_cur) == this->index) {
@@ -195,6 +199,17 @@ void Industry::PostDestructor(size_t index)
 	Station::RecomputeIndustriesNearForAll();
 }
 
+/** Rebuild the spatial index of the industries, after loading a game or starting a new one. */
+void RebuildIndustryGridIndex()
+{
+	_industry_grid.Reset();
+
+	const Industry *i;
+	FOR_ALL_INDUSTRIES(i) {
+		if (i->location.w != 0) _industry_grid.Insert(i->location, i->index);
+	}
+}
+
 
 /**
  * Return a random valid industry.
@@ -517,8 +532,6 @@ static bool TransportIndustryGoods(TileIndex tile)
 	const IndustrySpec *indspec = GetIndustrySpec(i->type);
 	bool moved_cargo = false;
 
-	StationFinder stations(i->location);
-
 	for (uint j = 0; j < lengthof(i->produced_cargo_waiting); j++) {
 		uint cw = min(i->produced_cargo_waiting[j], 255);
 		if (cw > indspec->minimal_cargo && i->produced_cargo[j] != CT_INVALID) {
@@ -529,7 +542,7 @@ static bool TransportIndustryGoods(TileIndex tile)
 
 			i->this_month_production[j] += cw;
 
-			uint am = MoveGoodsToStation(i->produced_cargo[j], cw, ST_INDUSTRY, i->index, stations.GetStations());
+			uint am = MoveGoodsToStation(i->produced_cargo[j], cw, ST_INDUSTRY, i->index, i->GetStationsNear());
 			i->this_month_transported[j] += am;
 
 			moved_cargo |= (am != 0);
@@ -1595,41 +1608,18 @@ static bool CheckIfCanLevelIndustryPlatform(TileIndex tile, DoCommandFlag flags,
 static CommandCost CheckIfFarEnoughFromConflictingIndustry(TileIndex tile, int type)
 {
 	const IndustrySpec *indspec = GetIndustrySpec(type);
-	const Industry *i = NULL;
-
-	/* On a large map with many industries, it may be faster to check an area. */
-	static const int dmax = 14;
-	if (Industry::GetNumItems() > (size_t) (dmax * dmax * 2)) {
-		const int tx = TileX(tile);
-		const int ty = TileY(tile);
-		TileArea tile_area = TileArea(TileXY(max(0, tx - dmax), max(0, ty - dmax)), TileXY(min(MapMaxX(), tx + dmax), min(MapMaxY(), ty + dmax)));
-		TILE_AREA_LOOP(atile, tile_area) {
-			if (GetTileType(atile) == MP_INDUSTRY) {
-				const Industry *i2 = Industry::GetByTile(atile);
-				if (i == i2) continue;
-				i = i2;
-				if (DistanceMax(tile, i->location.tile) > (uint)dmax) continue;
-				if (i->type == indspec->conflicting[0] ||
-						i->type == indspec->conflicting[1] ||
-						i->type == indspec->conflicting[2]) {
-					return_cmd_error(STR_ERROR_INDUSTRY_TOO_CLOSE);
-				}
-			}
-		}
-		return CommandCost();
-	}
 
-	FOR_ALL_INDUSTRIES(i) {
-		/* Within 14 tiles from another industry is considered close */
-		if (DistanceMax(tile, i->location.tile) > 14) continue;
+	/* Within 14 tiles from another industry is considered close */
+	bool too_close = _industry_grid.FindAround(tile, 14, [tile, indspec](IndustryID id) {
+		const Industry *i = Industry::Get(id);
+		if (DistanceMax(tile, i->location.tile) > 14) return false;
 
 		/* check if there are any conflicting industry types around */
-		if (i->type == indspec->conflicting[0] ||
+		return i->type == indspec->conflicting[0] ||
 				i->type == indspec->conflicting[1] ||
-				i->type == indspec->conflicting[2]) {
-			return_cmd_error(STR_ERROR_INDUSTRY_TOO_CLOSE);
-		}
-	}
+				i->type == indspec->conflicting[2];
+	});
+	if (too_close) return_cmd_error(STR_ERROR_INDUSTRY_TOO_CLOSE);
 	return CommandCost();
 }
 
@@ -1820,6 +1810,8 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 		}
 	} while ((++it)->ti.x != -0x80);
 
+	_industry_grid.Insert(i->location, i->index);
+
 	if (GetIndustrySpec(i->type)->behaviour & INDUSTRYBEH_PLANT_ON_BUILT) {
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
@@ -2226,6 +2218,21 @@ static void UpdateIndustryStatistics(Industry *i)
 	}
 }
 
+/**
+ * Get the stations around the industry which get its produced cargo.
+ * The list is kept until the station catchment index changes.
+ * @return The stations, sorted by station index.
+ */
+const StationList *Industry::GetStationsNear()
+{
+	if (this->stations_near_version != _station_catchment_index_version) {
+		this->stations_near.Clear();
+		FindStationsAroundTiles(this->location, &this->stations_near);
+		this->stations_near_version = _station_catchment_index_version;
+	}
+	return &this->stations_near;
+}
+
 /**
  * Recompute #production_rate for current #prod_level.
  * This function is only valid when not using smooth economy.
@@ -2431,8 +2438,7 @@ static void CanCargoServiceIndustry(CargoID cargo, Industry *ind, bool *c_accept
 static int WhoCanServiceIndustry(Industry *ind)
 {
 	/* Find all stations within reach of the industry */
-	StationList stations;
-	FindStationsAroundTiles(ind->location, &stations);
+	const StationList &stations = *ind->GetStationsNear();
 
 	if (stations.Length() == 0) return 0; // No stations found at all => nobody services
 
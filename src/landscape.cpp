@@ -724,6 +724,8 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 TileIndex _cur_tileloop_tile;
 
+void FlushHouseCargoBatches();
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -755,18 +757,24 @@ void RunTileLoop()
 
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
+		PerformanceZoneMeasurer zone((PerformanceZone)(PFZ_TILELOOP_FIRST + GetTileType(0)));
 		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
 		count--;
 	}
 
 	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		{
+			PerformanceZoneMeasurer zone((PerformanceZone)(PFZ_TILELOOP_FIRST + GetTileType(tile)));
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		}
 
 		/* Get the next tile in sequence using a Galois LFSR. */
 		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
 	}
 
 	_cur_tileloop_tile = tile;
+
+	FlushHouseCargoBatches();
 }
 
 void InitializeLandscape()
@@ -14,12 +14,14 @@
 
 #include "../core/pool_type.hpp"
 #include "../core/smallmap_type.hpp"
-#include "../core/smallmatrix_type.hpp"
 #include "../core/bitmath_func.hpp"
 #include "../station_base.h"
 #include "../cargotype.h"
 #include "../date_func.h"
 #include "linkgraph_type.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 struct SaveLoad;
 class LinkGraph;
@@ -56,20 +58,28 @@ public:
 	};
 
 	/**
-	 * An edge in the link graph. Corresponds to a link between two stations or at
-	 * least the distance between them. Edges from one node to itself contain the
-	 * ID of the opposite Node of the first active edge (i.e. not just distance) in
-	 * the column as next_edge.
+	 * An edge in the link graph. Corresponds to a link between two stations.
+	 * Only edges with capacity are stored, in a list per source node.
 	 */
 	struct BaseEdge {
 		uint capacity;                 ///< Capacity of the link.
 		uint usage;                    ///< Usage of the link.
 		Date last_unrestricted_update; ///< When the unrestricted part of the link was last updated.
 		Date last_restricted_update;   ///< When the restricted part of the link was last updated.
-		NodeID next_edge;              ///< Destination of next valid edge starting at the same source node.
-		void Init();
+		NodeID dest_node;              ///< Destination of the edge.
+		void Init(NodeID dest_node = INVALID_NODE);
 	};
 
+	/** Outgoing edges of a node, sorted by destination. */
+	typedef std::vector<BaseEdge> EdgeVector;
+
+	/**
+	 * Shared pointer to the outgoing edges of a node. The edges are shared
+	 * between copies of a link graph and only copied when one of them is
+	 * modified, see #LinkGraph::Unshare.
+	 */
+	typedef std::shared_ptr<EdgeVector> EdgeVectorPtr;
+
 	/**
 	 * Wrapper for an edge (const or not) allowing retrieval, but no modification.
 	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
@@ -120,15 +130,15 @@ public:
 
 	/**
 	 * Wrapper for a node (const or not) allowing retrieval, but no modification.
-	 * @tparam Tedge Actual node class, may be "const BaseNode" or just "BaseNode".
-	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
+	 * @tparam Tnode Actual node class, may be "const BaseNode" or just "BaseNode".
+	 * @tparam Tedge_vector_ptr Actual edge list pointer class, may be "const EdgeVectorPtr" or just "EdgeVectorPtr".
 	 */
-	template<typename Tnode, typename Tedge>
+	template<typename Tnode, typename Tedge_vector_ptr>
 	class NodeWrapper {
 	protected:
-		Tnode &node;  ///< Node being wrapped.
-		Tedge *edges; ///< Outgoing edges for wrapped node.
-		NodeID index; ///< ID of wrapped node.
+		Tnode &node;             ///< Node being wrapped.
+		Tedge_vector_ptr &edges; ///< Outgoing edges for wrapped node.
+		NodeID index;            ///< ID of wrapped node.
 
 	public:
 
@@ -138,7 +148,7 @@ public:
 		 * @param edges Outgoing edges for node to be wrapped.
 		 * @param index ID of node to be wrapped.
 		 */
-		NodeWrapper(Tnode &node, Tedge *edges, NodeID index) : node(node),
+		NodeWrapper(Tnode &node, Tedge_vector_ptr &edges, NodeID index) : node(node),
 			edges(edges), index(index) {}
 
 		/**
@@ -173,17 +183,15 @@ public:
 	};
 
 	/**
-	 * Base class for iterating across outgoing edges of a node. Only the real
-	 * edges (those with capacity) are iterated. The ones with only distance
-	 * information are skipped.
+	 * Base class for iterating across outgoing edges of a node, in the order of
+	 * their destinations.
 	 * @tparam Tedge Actual edge class. May be "BaseEdge" or "const BaseEdge".
 	 * @tparam Titer Actual iterator class.
 	 */
 	template <class Tedge, class Tedge_wrapper, class Titer>
 	class BaseEdgeIterator {
 	protected:
-		Tedge *base;    ///< Array of edges being iterated.
-		NodeID current; ///< Current offset in edges array.
+		Tedge *current; ///< Current edge in the edges array.
 
 		/**
 		 * A "fake" pointer to enable operator-> on temporaries. As the objects
@@ -210,13 +218,9 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param current ID of current node (to locate the first edge).
+		 * @param current Edge to start at.
 		 */
-		BaseEdgeIterator (Tedge *base, NodeID current) :
-			base(base),
-			current(current == INVALID_NODE ? current : base[current].next_edge)
-		{}
+		BaseEdgeIterator (Tedge *current) : current(current) {}
 
 		/**
 		 * Prefix-increment.
@@ -224,7 +228,7 @@ public:
 		 */
 		Titer &operator++()
 		{
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return static_cast<Titer &>(*this);
 		}
 
@@ -235,7 +239,7 @@ public:
 		Titer operator++(int)
 		{
 			Titer ret(static_cast<Titer &>(*this));
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return ret;
 		}
 
@@ -244,12 +248,12 @@ public:
 		 * child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If the iterators have the same edge array and current node.
+		 * @return If the iterators point to the same edge.
 		 */
 		template<class Tother>
 		bool operator==(const Tother &other)
 		{
-			return this->base == other.base && this->current == other.current;
+			return this->current == other.current;
 		}
 
 		/**
@@ -257,12 +261,12 @@ public:
 		 * may be of a child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If either the edge arrays or the current nodes differ.
+		 * @return If the iterators point to different edges.
 		 */
 		template<class Tother>
 		bool operator!=(const Tother &other)
 		{
-			return this->base != other.base || this->current != other.current;
+			return this->current != other.current;
 		}
 
 		/**
@@ -271,7 +275,7 @@ public:
 		 */
 		SmallPair<NodeID, Tedge_wrapper> operator*() const
 		{
-			return SmallPair<NodeID, Tedge_wrapper>(this->current, Tedge_wrapper(this->base[this->current]));
+			return SmallPair<NodeID, Tedge_wrapper>(this->current->dest_node, Tedge_wrapper(*this->current));
 		}
 
 		/**
@@ -311,11 +315,10 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param current Edge to start at.
 		 */
-		ConstEdgeIterator(const BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(edges, current) {}
+		ConstEdgeIterator(const BaseEdge *current) :
+			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(current) {}
 	};
 
 	/**
@@ -326,18 +329,17 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param current Edge to start at.
 		 */
-		EdgeIterator(BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<BaseEdge, Edge, EdgeIterator>(edges, current) {}
+		EdgeIterator(BaseEdge *current) :
+			BaseEdgeIterator<BaseEdge, Edge, EdgeIterator>(current) {}
 	};
 
 	/**
 	 * Constant node class. Only retrieval operations are allowed on both the
 	 * node itself and its edges.
 	 */
-	class ConstNode : public NodeWrapper<const BaseNode, const BaseEdge> {
+	class ConstNode : public NodeWrapper<const BaseNode, const EdgeVectorPtr> {
 	public:
 		/**
 		 * Constructor.
@@ -345,34 +347,37 @@ public:
 		 * @param node ID of the node.
 		 */
 		ConstNode(const LinkGraph *lg, NodeID node) :
-			NodeWrapper<const BaseNode, const BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<const BaseNode, const EdgeVectorPtr>(lg->nodes[node], lg->edges[node], node)
 		{}
 
 		/**
 		 * Get a ConstEdge. This is not a reference as the wrapper objects are
-		 * not actually persistent.
+		 * not actually persistent. If there is no edge to the given node an
+		 * empty edge without capacity and updates is returned.
 		 * @param to ID of end node of edge.
 		 * @return Constant edge wrapper.
 		 */
-		ConstEdge operator[](NodeID to) const { return ConstEdge(this->edges[to]); }
+		ConstEdge operator[](NodeID to) const { return ConstEdge(LinkGraph::GetEdge(*this->edges, to)); }
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges, this->index); }
+		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges->data()); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges, INVALID_NODE); }
+		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges->data() + this->edges->size()); }
 	};
 
 	/**
 	 * Updatable node class. The node itself as well as its edges can be modified.
+	 * Getting modifiable edges copies them if they are shared with another link
+	 * graph, so use a ConstNode to only read them.
 	 */
-	class Node : public NodeWrapper<BaseNode, BaseEdge> {
+	class Node : public NodeWrapper<BaseNode, EdgeVectorPtr> {
 	public:
 		/**
 		 * Constructor.
@@ -380,28 +385,40 @@ public:
 		 * @param node ID of the node.
 		 */
 		Node(LinkGraph *lg, NodeID node) :
-			NodeWrapper<BaseNode, BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<BaseNode, EdgeVectorPtr>(lg->nodes[node], lg->edges[node], node)
 		{}
 
 		/**
 		 * Get an Edge. This is not a reference as the wrapper objects are not
-		 * actually persistent.
-		 * @param to ID of end node of edge.
+		 * actually persistent. The wrapper is invalidated when edges are added
+		 * to or removed from the node.
+		 * @param to ID of end node of edge, which has to exist.
 		 * @return Edge wrapper.
 		 */
-		Edge operator[](NodeID to) { return Edge(this->edges[to]); }
+		Edge operator[](NodeID to)
+		{
+			BaseEdge *edge = LinkGraph::FindEdge(this->MutableEdges(), to);
+			assert(edge != NULL);
+			return Edge(*edge);
+		}
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Edge iterator.
 		 */
-		EdgeIterator Begin() { return EdgeIterator(this->edges, this->index); }
+		EdgeIterator Begin() { return EdgeIterator(this->MutableEdges().data()); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		EdgeIterator End() { return EdgeIterator(this->edges, INVALID_NODE); }
+		EdgeIterator End() { return EdgeIterator(this->MutableEdges().data() + this->edges->size()); }
+
+		/**
+		 * Get the outgoing edges for modification.
+		 * @return Edges of the node, not shared with any other link graph.
+		 */
+		EdgeVector &MutableEdges() { return LinkGraph::Unshare(this->edges); }
 
 		/**
 		 * Update the node's supply and set last_update to the current date.
@@ -437,7 +454,7 @@ public:
 	};
 
 	typedef SmallVector<BaseNode, 16> NodeVector;
-	typedef SmallMatrix<BaseEdge> EdgeMatrix;
+	typedef std::vector<EdgeVectorPtr> EdgeMatrix;
 
 	/** Minimum effective distance for timeout calculation. */
 	static const uint MIN_TIMEOUT_DISTANCE = 32;
@@ -445,6 +462,50 @@ public:
 	/** Minimum number of days between subsequent compressions of a LG. */
 	static const uint COMPRESSION_INTERVAL = 256;
 
+	/** Edge returned for nodes which aren't connected. */
+	static const BaseEdge EMPTY_EDGE;
+
+	/**
+	 * Find the edge to a node in a list of outgoing edges.
+	 * @param edges Outgoing edges of a node, sorted by destination.
+	 * @param to ID of end node of edge.
+	 * @return The edge or NULL if there is none.
+	 */
+	template <typename Tedge_vector>
+	inline static auto FindEdge(Tedge_vector &edges, NodeID to) -> decltype(edges.data())
+	{
+		auto it = std::lower_bound(edges.begin(), edges.end(), to, [](const BaseEdge &edge, NodeID dest) {
+			return edge.dest_node < dest;
+		});
+		return (it != edges.end() && it->dest_node == to) ? &*it : NULL;
+	}
+
+	/**
+	 * Make sure a list of edges isn't shared with any other link graph, like the
+	 * copy of a link graph job, so that it can be modified. Only the main thread
+	 * copies link graphs, so if it doesn't find other references no other thread
+	 * can get one in the meantime.
+	 * @param edges Pointer to the edges, replaced by one to a copy if they are shared.
+	 * @return Edges which can be modified.
+	 */
+	inline static EdgeVector &Unshare(EdgeVectorPtr &edges)
+	{
+		if (edges.use_count() > 1) edges = std::make_shared<EdgeVector>(*edges);
+		return *edges;
+	}
+
+	/**
+	 * Get the edge to a node from a list of outgoing edges.
+	 * @param edges Outgoing edges of a node, sorted by destination.
+	 * @param to ID of end node of edge.
+	 * @return The edge or #EMPTY_EDGE if there is none.
+	 */
+	inline static const BaseEdge &GetEdge(const EdgeVector &edges, NodeID to)
+	{
+		const BaseEdge *edge = FindEdge(edges, to);
+		return edge != NULL ? *edge : EMPTY_EDGE;
+	}
+
 	/**
 	 * Scale a value from a link graph of age orig_age for usage in one of age
 	 * target_age. Make sure that the value stays > 0 if it was > 0 before.
@@ -534,7 +595,8 @@ protected:
 	friend class LinkGraph::Node;
 	friend const SaveLoad *GetLinkGraphDesc();
 	friend const SaveLoad *GetLinkGraphJobDesc();
-	friend void SaveLoad_LinkGraph(LinkGraph &lg);
+	friend void Save_LinkGraph(LinkGraph &lg);
+	friend void Load_LinkGraph(LinkGraph &lg);
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
@@ -40,7 +40,8 @@ static DateTicks GetLinkGraphJobJoinDateTicks(uint duration_multiplier)
 /**
  * Create a link graph job from a link graph. The link graph will be copied so
  * that the calculations don't interfer with the normal operations on the
- * original. The job is immediately started.
+ * original. The copy shares the edges with the original, until either of them
+ * is modified. The job is immediately started.
  * @param orig Original LinkGraph to be copied.
  */
 LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
@@ -51,7 +52,11 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
 		join_date_ticks(GetLinkGraphJobJoinDateTicks(duration_multiplier)),
 		start_date_ticks((_date * DAY_TICKS) + _date_fract),
 		job_completed(false),
-		abort_job(false)
+		abort_job(false),
+		spawn_time(0),
+		predicted_run_time(0),
+		run_start_time(0),
+		run_time(0)
 {
 }
 
@@ -119,7 +124,7 @@ void LinkGraphJob::FinaliseJob()
 			continue;
 		}
 
-		LinkGraph *lg = LinkGraph::Get(ge.link_graph);
+		const LinkGraph *lg = LinkGraph::Get(ge.link_graph);
 		FlowStatMap &flows = from.Flows();
 
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
@@ -144,10 +149,13 @@ void LinkGraphJob::FinaliseJob()
 		/* Swap shares and invalidate ones that are completely deleted. Don't
 		 * really delete them as we could then end up with unroutable cargo
 		 * somewhere. Do delete them and also reroute relevant cargo if
-		 * automatic distribution has been turned off for that cargo. */
+		 * automatic distribution has been turned off for that cargo. Shares
+		 * which haven't changed are left alone. */
+		bool changed = false;
 		for (FlowStatMap::iterator it(ge.flows.begin()); it != ge.flows.end();) {
 			FlowStatMap::iterator new_it = flows.find(it->first);
 			if (new_it == flows.end()) {
+				changed = true;
 				if (_settings_game.linkgraph.GetDistributionType(this->Cargo()) != DT_MANUAL) {
 					it->second.Invalidate();
 					++it;
@@ -161,13 +169,19 @@ void LinkGraphJob::FinaliseJob()
 					}
 				}
 			} else {
-				it->second.SwapShares(new_it->second);
+				if (!it->second.HasSameShares(new_it->second)) {
+					it->second.SwapShares(new_it->second);
+					changed = true;
+				}
 				flows.erase(new_it);
 				++it;
 			}
 		}
-		ge.flows.insert(flows.begin(), flows.end());
-		InvalidateWindowData(WC_STATION_VIEW, st->index, this->Cargo());
+		if (!flows.empty()) {
+			ge.flows.insert(flows.begin(), flows.end());
+			changed = true;
+		}
+		if (changed) InvalidateWindowData(WC_STATION_VIEW, st->index, this->Cargo());
 	}
 }
 
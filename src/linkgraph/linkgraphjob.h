@@ -14,6 +14,7 @@
 
 #include "../thread/thread.h"
 #include "../core/dyn_arena_alloc.hpp"
+#include "../core/smallmatrix_type.hpp"
 #include "linkgraph.h"
 #include <vector>
 #include <memory>
@@ -71,6 +72,10 @@ protected:
 	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
 	bool job_completed;               ///< Is the job still running. This is accessed by multiple threads and is permitted to be spuriously incorrect.
 	bool abort_job;                   ///< Abort the job at the next available opportunity. This is accessed by multiple threads.
+	uint64 spawn_time;                ///< Real time in microseconds when the job was handed to a thread. Not saved.
+	uint64 predicted_run_time;        ///< Predicted run time in microseconds, 0 if there was no prediction. Not saved.
+	uint64 run_start_time;            ///< Real time in microseconds when the job started running. Not saved.
+	uint64 run_time;                  ///< Measured run time in microseconds, 0 if the job did not run (yet). Not saved.
 
 	void EraseFlows(NodeID from);
 	void JoinThread();
@@ -161,12 +166,11 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param base_anno Array of annotations to be iterated.
-		 * @param current Start offset of iteration.
+		 * @param current Edge to start at.
+		 * @param base_anno Array of annotations of the edges' source node, indexed by destination.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
-				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
+		EdgeIterator(const LinkGraph::BaseEdge *current, EdgeAnnotation *base_anno) :
+				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(current),
 				base_anno(base_anno) {}
 
 		/**
@@ -176,7 +180,7 @@ public:
 		 */
 		SmallPair<NodeID, Edge> operator*() const
 		{
-			return SmallPair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			return SmallPair<NodeID, Edge>(this->current->dest_node, Edge(*this->current, this->base_anno[this->current->dest_node]));
 		}
 
 		/**
@@ -215,21 +219,21 @@ public:
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const { return Edge(LinkGraph::GetEdge(*this->edges, to), this->edge_annos[to]); }
 
 		/**
 		 * Iterator for the "begin" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(this->edges->data(), this->edge_annos); }
 
 		/**
 		 * Iterator for the "end" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(this->edges->data() + this->edges->size(), this->edge_annos); }
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -279,7 +283,8 @@ public:
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
 	LinkGraphJob() : settings(_settings_game.linkgraph),
-			join_date_ticks(INVALID_DATE), start_date_ticks(INVALID_DATE), job_completed(false) {}
+			join_date_ticks(INVALID_DATE), start_date_ticks(INVALID_DATE), job_completed(false),
+			spawn_time(0), predicted_run_time(0), run_start_time(0), run_time(0) {}
 
 	LinkGraphJob(const LinkGraph &orig, uint duration_multiplier);
 	~LinkGraphJob();
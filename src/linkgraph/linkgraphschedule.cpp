@@ -17,10 +17,76 @@
 #include "flowmapper.h"
 #include "../framerate_type.h"
 #include "../command_func.h"
+#include "../string_func.h"
 #include <algorithm>
+#include <chrono>
+#include <deque>
 
 #include "../safeguards.h"
 
+/** Run time of a finished link graph job, for comparing it with the prediction and the time available. */
+struct LinkGraphJobTiming {
+	LinkGraphID graph; ///< Link graph the job ran on.
+	uint nodes;        ///< Number of nodes of the job.
+	uint64 cost;       ///< Cost estimate of the job.
+	uint64 predicted;  ///< Predicted run time in microseconds, 0 if there was no prediction.
+	uint64 actual;     ///< Measured run time in microseconds.
+	uint64 available;  ///< Real time in microseconds between handing the job to a thread and joining it.
+	uint64 late;       ///< Real time in microseconds the job was still running when it was joined.
+};
+
+/**
+ * Model of the run time of link graph jobs, learnt from the run times of the
+ * jobs that finished. This is local to each client, so it may only be used to
+ * decide how to spread jobs over threads; which jobs run and when they are
+ * joined has to be the same everywhere.
+ */
+struct LinkGraphJobRunTimeModel {
+	static const uint HISTORY_SIZE = 32; ///< Number of finished jobs to remember.
+
+	double time_per_cost = 0;            ///< Average run time in microseconds per unit of cost estimate, 0 if not known yet.
+	uint samples = 0;                    ///< Number of jobs the average is based on.
+	std::deque<LinkGraphJobTiming> history; ///< Timings of the last finished jobs, latest first.
+
+	/**
+	 * Predict the run time of a job.
+	 * @param cost Cost estimate of the job.
+	 * @return Run time in microseconds, 0 if there is nothing to base a prediction on.
+	 */
+	uint64 Predict(uint64 cost) const
+	{
+		return (uint64)(this->time_per_cost * cost);
+	}
+
+	/**
+	 * Add the run time of a job which ran to completion.
+	 * @param timing The timing of the job.
+	 */
+	void Learn(const LinkGraphJobTiming &timing)
+	{
+		if (timing.cost > 0) {
+			/* Exponential moving average, so the model follows changes in the load of the machine. */
+			double sample = (double)timing.actual / timing.cost;
+			this->time_per_cost = this->samples == 0 ? sample : this->time_per_cost + (sample - this->time_per_cost) / 8;
+			this->samples++;
+		}
+		this->history.push_front(timing);
+		if (this->history.size() > HISTORY_SIZE) this->history.pop_back();
+	}
+};
+
+static LinkGraphJobRunTimeModel _link_graph_job_run_time_model;
+
+/**
+ * Get the current real time for timing link graph jobs.
+ * @return Time in microseconds.
+ */
+static uint64 GetLinkGraphJobTime()
+{
+	using namespace std::chrono;
+	return (uint64)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 /**
  * Static instance of LinkGraphSchedule.
  * Note: This instance is created on task start.
@@ -130,8 +196,23 @@ void LinkGraphSchedule::JoinNext()
 		std::unique_ptr<LinkGraphJob> next = std::move(this->running.front());
 		this->running.pop_front();
 		LinkGraphID id = next->LinkGraphIndex();
+		uint64 join_time = GetLinkGraphJobTime();
 		next->FinaliseJob(); // joins the thread and finalises the job
 		assert(!next->IsJobAborted());
+		if (next->run_time != 0) {
+			LinkGraphJobTiming timing;
+			timing.graph = id;
+			timing.nodes = next->Size();
+			timing.cost = next->Graph().CalculateCostEstimate();
+			timing.predicted = next->predicted_run_time;
+			timing.actual = next->run_time;
+			timing.available = join_time - next->spawn_time;
+			uint64 finish_time = next->run_start_time + next->run_time;
+			timing.late = finish_time > join_time ? finish_time - join_time : 0;
+			DEBUG(linkgraph, 2, "LinkGraphSchedule::JoinNext(): Joined job: id: %u, nodes: %u, cost: " OTTD_PRINTF64U ", predicted: " OTTD_PRINTF64U " us, actual: " OTTD_PRINTF64U " us, available: " OTTD_PRINTF64U " us, late: " OTTD_PRINTF64U " us",
+					id, timing.nodes, timing.cost, timing.predicted, timing.actual, timing.available, timing.late);
+			_link_graph_job_run_time_model.Learn(timing);
+		}
 		next.reset();
 		if (LinkGraph::IsValidID(id)) {
 			LinkGraph *lg = LinkGraph::Get(id);
@@ -149,10 +230,12 @@ void LinkGraphSchedule::JoinNext()
 /* static */ void LinkGraphSchedule::Run(void *j)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
+	job->run_start_time = GetLinkGraphJobTime();
 	for (uint i = 0; i < lengthof(instance.handlers); ++i) {
 		if (job->IsJobAborted()) return;
 		instance.handlers[i]->Run(*job);
 	}
+	job->run_time = max<uint64>(GetLinkGraphJobTime() - job->run_start_time, 1);
 
 	/*
 	 * Note that this it not guaranteed to be an atomic write and there are no memory barriers or other protections.
@@ -276,18 +359,37 @@ void LinkGraphJobGroup::JoinThread() {
 	}
 }
 
+/**
+ * Start threads for running a set of jobs. Jobs are grouped so that the
+ * threads get about the same amount of work, spreading it over the cores,
+ * but the groups are not made so small that starting threads for them is a
+ * waste. The amount of work is the run time predicted from the jobs that ran
+ * before, or just the cost estimate as long as there is no such prediction.
+ * @param jobs The jobs to run.
+ */
 /* static */ void LinkGraphJobGroup::ExecuteJobSet(std::vector<JobInfo> jobs) {
-	const uint thread_budget = 200000;
+	const uint64 cost_budget = 200000;
+	const uint64 min_time_budget = 10000; // microseconds
+
+	uint64 now = GetLinkGraphJobTime();
+	uint64 total_predicted = 0;
+	for (JobInfo &it : jobs) {
+		it.job->spawn_time = now;
+		it.job->predicted_run_time = _link_graph_job_run_time_model.Predict(it.cost_estimate);
+		total_predicted += it.job->predicted_run_time;
+	}
+	const bool use_prediction = _link_graph_job_run_time_model.samples > 0;
+	const uint64 thread_budget = use_prediction ? max(min_time_budget, CeilDivT<uint64>(total_predicted, max(GetCPUCoreCount(), 1u))) : cost_budget;
 
 	std::sort(jobs.begin(), jobs.end(), [](const JobInfo &a, const JobInfo &b) {
 		return a.cost_estimate < b.cost_estimate;
 	});
 
 	std::vector<LinkGraphJob *> bucket;
-	uint bucket_cost = 0;
+	uint64 bucket_cost = 0;
 	auto flush_bucket = [&]() {
-		if (!bucket_cost) return;
-		DEBUG(linkgraph, 2, "LinkGraphJobGroup::ExecuteJobSet: Creating Job Group: jobs: " PRINTF_SIZE ", cost: %u", bucket.size(), bucket_cost);
+		if (bucket.empty()) return;
+		DEBUG(linkgraph, 2, "LinkGraphJobGroup::ExecuteJobSet: Creating Job Group: jobs: " PRINTF_SIZE ", %s: " OTTD_PRINTF64U, bucket.size(), use_prediction ? "predicted us" : "cost", bucket_cost);
 		auto group = std::make_shared<LinkGraphJobGroup>(constructor_token(), std::move(bucket));
 		group->SpawnThread();
 		bucket_cost = 0;
@@ -295,9 +397,10 @@ void LinkGraphJobGroup::JoinThread() {
 	};
 
 	for (JobInfo &it : jobs) {
-		if (bucket_cost && (bucket_cost + it.cost_estimate > thread_budget)) flush_bucket();
+		uint64 cost = use_prediction ? it.job->predicted_run_time : it.cost_estimate;
+		if (bucket_cost && (bucket_cost + cost > thread_budget)) flush_bucket();
 		bucket.push_back(it.job);
-		bucket_cost += it.cost_estimate;
+		bucket_cost += cost;
 	}
 	flush_bucket();
 }
@@ -305,6 +408,23 @@ void LinkGraphJobGroup::JoinThread() {
 LinkGraphJobGroup::JobInfo::JobInfo(LinkGraphJob *job) :
 		job(job), cost_estimate(job->Graph().CalculateCostEstimate()) { }
 
+/**
+ * Write the run time model of link graph jobs and the timings of the last
+ * finished jobs to a buffer.
+ * @param buffer Buffer to write to.
+ * @param last End of the buffer.
+ */
+void DumpLinkGraphJobStats(char *buffer, const char *last)
+{
+	const LinkGraphJobRunTimeModel &model = _link_graph_job_run_time_model;
+	buffer += seprintf(buffer, last, "Run time per unit of cost: %.4f us, from %u jobs\n", model.time_per_cost, model.samples);
+	buffer += seprintf(buffer, last, "Last finished jobs, latest first; times in ms:\n");
+	for (const LinkGraphJobTiming &t : model.history) {
+		buffer += seprintf(buffer, last, "  graph %5u: %5u nodes, cost " OTTD_PRINTF64U ", predicted " OTTD_PRINTF64U ", actual " OTTD_PRINTF64U ", available " OTTD_PRINTF64U ", late " OTTD_PRINTF64U "\n",
+				t.graph, t.nodes, t.cost, t.predicted / 1000, t.actual / 1000, t.available / 1000, t.late / 1000);
+	}
+}
+
 /**
  * Pause the game if on the next _date_fract tick, we would do a join with the next
  * link graph job, but it is still running.
@@ -354,6 +474,7 @@ void OnTick_LinkGraph()
 		LinkGraphSchedule::instance.SpawnNext();
 	} else if (offset == interval / 2) {
 		PerformanceMeasurer framerate(PFE_GL_LINKGRAPH);
+		PerformanceZoneMeasurer zone(PFZ_LINKGRAPH_JOIN);
 		LinkGraphSchedule::instance.JoinNext();
 	}
 }
@@ -57,6 +57,10 @@ void InitializeCompanies();
 void InitializeCheats();
 void InitializeNPF();
 void InitializeOldNames();
+void ClearSmallMapCache();
+void ClearMapTileExport();
+void RebuildTownGridIndex();
+void RebuildIndustryGridIndex();
 
 void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settings)
 {
@@ -67,6 +71,10 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	AllocateMap(size_x, size_y);
 
 	ViewportMapClearTunnelCache();
+	ViewportMapClearCache();
+	ClearSmallMapCache();
+	ClearMapTileExport();
+	ClearStationCatchmentIndex();
 	ClearCommandLog();
 
 	_pause_mode = PM_UNPAUSED;
@@ -89,6 +97,8 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	ClearBridgeSimulatedSignalMapping();
 	ClearCargoPacketDeferredPayments();
 	PoolBase::Clean(PT_NORMAL);
+	RebuildTownGridIndex();
+	RebuildIndustryGridIndex();
 
 	FreeSignalPrograms();
 	FreeSignalDependencies();
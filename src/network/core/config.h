@@ -38,6 +38,7 @@ static const byte NETWORK_GAME_ADMIN_VERSION      =    1;         ///< What vers
 static const byte NETWORK_GAME_INFO_VERSION       =    4;         ///< What version of game-info do we use?
 static const byte NETWORK_COMPANY_INFO_VERSION    =    6;         ///< What version of company info is this?
 static const byte NETWORK_MASTER_SERVER_VERSION   =    2;         ///< What version of master-server-protocol do we use?
+static const byte NETWORK_COMMAND_BATCH_VERSION   =    1;         ///< What version of the batched server command packet do we use?
 
 static const uint NETWORK_NAME_LENGTH             =   80;         ///< The maximum length of the server name and map name, in bytes including '\0'
 static const uint NETWORK_COMPANY_NAME_LENGTH     =  128;         ///< The maximum length of the company name, in bytes including '\0'
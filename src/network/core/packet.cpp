@@ -150,6 +150,24 @@ void Packet::Send_uint64(uint64 data)
 	this->buffer[this->size++] = GB(data, 56, 8);
 }
 
+/**
+ * Package a variable length unsigned integer in the packet.
+ * The value is sent in groups of 7 bits, least significant group first,
+ * with the top bit of each byte set when more bytes follow.
+ * Values below 128 therefore take a single byte.
+ * @param data The data to send.
+ */
+void Packet::Send_varuint(uint64 data)
+{
+	do {
+		assert(this->size < SHRT_MAX - 1);
+		byte b = GB(data, 0, 7);
+		data >>= 7;
+		if (data != 0) b |= 0x80;
+		this->buffer[this->size++] = b;
+	} while (data != 0);
+}
+
 /**
  * Sends a string over the network. It sends out
  * the string + '\0'. No size-byte or something.
@@ -300,6 +318,26 @@ uint64 Packet::Recv_uint64()
 	return n;
 }
 
+/**
+ * Read a variable length unsigned integer from the packet.
+ * @return The read data.
+ * @see Packet::Send_varuint
+ */
+uint64 Packet::Recv_varuint()
+{
+	uint64 n = 0;
+	for (uint shift = 0; shift < 64; shift += 7) {
+		if (!this->CanReadFromPacket(1)) return 0;
+		byte b = this->buffer[this->pos++];
+		n |= (uint64)GB(b, 0, 7) << shift;
+		if (!HasBit(b, 7)) return n;
+	}
+
+	/* Too many continuation bytes, this is not a valid value. */
+	this->cs->NetworkSocketHandler::CloseConnection();
+	return 0;
+}
+
 /**
  * Reads a string till it finds a '\0' in the stream.
  * @param buffer The buffer to put the data into.
@@ -75,6 +75,7 @@ public:
 	void Send_uint16(uint16 data);
 	void Send_uint32(uint32 data);
 	void Send_uint64(uint64 data);
+	void Send_varuint(uint64 data);
 	void Send_string(const char *data);
 	void Send_binary(const char *data, const size_t size);
 
@@ -88,6 +89,7 @@ public:
 	uint16 Recv_uint16();
 	uint32 Recv_uint32();
 	uint64 Recv_uint64();
+	uint64 Recv_varuint();
 	void   Recv_string(char *buffer, size_t size, StringValidationSettings settings = SVS_REPLACE_WITH_QUESTION_MARK);
 	void   Recv_string(std::string &buffer, StringValidationSettings settings = SVS_REPLACE_WITH_QUESTION_MARK);
 	void   Recv_binary(char *buffer, size_t size);
@@ -91,10 +91,12 @@ enum PacketGameType {
 	PACKET_SERVER_FRAME,                 ///< Server tells the client what frame it is in, and thus to where the client may progress.
 	PACKET_CLIENT_ACK,                   ///< The client tells the server which frame it has executed.
 	PACKET_SERVER_SYNC,                  ///< Server tells the client what the random state should be.
+	PACKET_CLIENT_DESYNC_REPORT,         ///< The client tells the server which parts of the game state diverged.
 
 	/* Sending commands around. */
 	PACKET_CLIENT_COMMAND,               ///< Client executed a command and sends it to the server.
 	PACKET_SERVER_COMMAND,               ///< Server distributes a command to (all) the clients.
+	PACKET_SERVER_COMMAND_BATCH,         ///< Server distributes a batch of commands to a client which supports them.
 
 	/* Human communication! */
 	PACKET_CLIENT_CHAT,                  ///< Client said something that should be distributed.
@@ -342,10 +344,23 @@ protected:
 	 * uint32  Frame counter.
 	 * uint32  General seed 1.
 	 * uint32  General seed 2 (dependent on compile settings, not default).
+	 * Optionally followed by the state hashes (see network_state_hash.h):
+	 * uint16  State hash interval in frames, 0 when disabled.
+	 * uint32  Frame of the last completed state hash pass, 0 if none.
+	 * uint8   Number of subsystem hashes that follow.
+	 * uint32  Hash of each subsystem.
 	 * @param p The packet that was just received.
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
 
+	/**
+	 * Tell the server that the state hashes of the client do not match:
+	 * uint32  Frame of the mismatching state hash pass.
+	 * uint32  Bitmask of the mismatching subsystems.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_CLIENT_DESYNC_REPORT(Packet *p);
+
 	/**
 	 * Tell the server we are done with this frame:
 	 * uint32  Current frame counter of the client.
@@ -381,6 +396,25 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
 
+	/**
+	 * Sends a batch of DoCommands to the client, only used when the client
+	 * announced support for #NETWORK_COMMAND_BATCH_VERSION when joining:
+	 * uint32  Frame of execution of the first command.
+	 * For each command until the end of the packet:
+	 * uint8   ID of the company (0..MAX_COMPANIES-1).
+	 * varuint ID of the command (see command.h).
+	 * varuint P1 (free variable used in DoCommand).
+	 * varuint P2.
+	 * varuint Tile where this is taking place.
+	 * varuint Length of the binary data, or 0 for a string.
+	 * string  Text, or the binary data.
+	 * uint8   ID of the callback.
+	 * varuint Frame of execution, relative to the previous command.
+	 * bool    Whether the command originated from the receiving client.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_COMMAND_BATCH(Packet *p);
+
 	/**
 	 * Sends a chat-packet to the server:
 	 * uint8   ID of the action (see NetworkAction).
@@ -560,6 +594,9 @@ public:
 
 	const char *ReceiveCommand(Packet *p, CommandPacket *cp);
 	void SendCommand(Packet *p, const CommandPacket *cp);
+
+	const char *ReceiveCommandBatchItem(Packet *p, CommandPacket *cp, uint32 prev_frame);
+	void SendCommandBatchItem(Packet *p, const CommandPacket *cp, uint32 prev_frame);
 };
 
 #endif /* ENABLE_NETWORK */
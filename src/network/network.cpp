@@ -19,6 +19,7 @@
 #include "network_admin.h"
 #include "network_client.h"
 #include "network_server.h"
+#include "network_state_hash.h"
 #include "network_content.h"
 #include "network_udp.h"
 #include "network_gamelist.h"
@@ -764,6 +765,7 @@ bool NetworkServerStart()
 	_frame_counter_server = 0;
 	_frame_counter_max = 0;
 	_last_sync_frame = 0;
+	NetworkStateHashReset();
 	_network_own_client_id = CLIENT_ID_SERVER;
 
 	_network_clients_connected = 0;
@@ -1029,6 +1031,9 @@ void NetworkGameLoop()
 		_sync_seed_2 = _random.state[1];
 #endif
 
+		NetworkStateHashSetInterval(_settings_client.network.state_hash_interval);
+		NetworkStateHashTick();
+
 		NetworkServer_Tick(send_frame);
 	} else {
 		/* Client */
@@ -31,6 +31,7 @@
 #include "network.h"
 #include "network_base.h"
 #include "network_client.h"
+#include "network_state_hash.h"
 #include "../core/backup_type.hpp"
 
 #include "table/strings.h"
@@ -247,6 +248,9 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	my_client->CheckConnection();
 }
 
+/** State hashes received from the server which have not been checked yet. */
+static NetworkStateHashes _network_server_state_hashes;
+
 /**
  * Actual game loop for the client.
  * @return Whether everything went okay, or not.
@@ -260,6 +264,8 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	extern void StateGameLoop();
 	StateGameLoop();
 
+	NetworkStateHashTick();
+
 	/* Check if we are in sync! */
 	if (_sync_frame != 0) {
 		if (_sync_frame == _frame_counter) {
@@ -293,6 +299,34 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 		}
 	}
 
+	/* Check the state hashes, once we have completed the same pass as the server. */
+	if (_network_server_state_hashes.frame != 0) {
+		if (_network_server_state_hashes.frame == _network_state_hashes.frame) {
+			uint32 mismatch = NetworkStateHashCompare(_network_server_state_hashes, _network_state_hashes);
+			if (mismatch != 0) {
+				for (uint i = 0; i < NSHS_END; i++) {
+					if (!HasBit(mismatch, i)) continue;
+					DEBUG(desync, 0, "state hash mismatch: frame %u, subsystem: %s", _network_state_hashes.frame, GetNetworkStateHashSubsystemName(i));
+					IConsolePrintF(CC_ERROR, "State hash mismatch at frame %u in subsystem: %s", _network_state_hashes.frame, GetNetworkStateHashSubsystemName(i));
+				}
+				NetworkError(STR_NETWORK_ERROR_DESYNC);
+				DEBUG(desync, 1, "sync_err: date{%08x; %02x; %02x}", _date, _date_fract, _tick_skip_counter);
+				DEBUG(net, 0, "State hash mismatch detected!");
+				my_client->SendDesyncReport(_network_state_hashes.frame, mismatch);
+				my_client->ClientError(NETWORK_RECV_STATUS_DESYNC);
+
+				extern void CheckCaches(bool force_check);
+				CheckCaches(true);
+				return false;
+			}
+			_network_server_state_hashes.frame = 0;
+		} else if (_network_server_state_hashes.frame < _frame_counter) {
+			/* We did not complete this pass ourselves, e.g. because we joined halfway. */
+			DEBUG(net, 5, "Skipped state hash check for frame %u", _network_server_state_hashes.frame);
+			_network_server_state_hashes.frame = 0;
+		}
+	}
+
 	return true;
 }
 
@@ -354,6 +388,21 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendJoin()
 	p->Send_string(_settings_client.network.client_name); // Client name
 	p->Send_uint8 (_network_join_as);     // PlayAs
 	p->Send_uint8 (NETLANG_ANY);          // Language
+	p->Send_uint8 (NETWORK_COMMAND_BATCH_VERSION); // Supported batched command version
+	my_client->SendPacket(p);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * Tell the server which parts of the game state did not match its state hashes.
+ * @param frame The frame of the state hash pass.
+ * @param mismatch Bitmask of the mismatching #NetworkStateHashSubsystem.
+ */
+NetworkRecvStatus ClientNetworkGameSocketHandler::SendDesyncReport(uint32 frame, uint32 mismatch)
+{
+	Packet *p = new Packet(PACKET_CLIENT_DESYNC_REPORT);
+	p->Send_uint32(frame);
+	p->Send_uint32(mismatch);
 	my_client->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -803,6 +852,9 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_BEGIN(Packe
 	this->savegame = new PacketReader();
 
 	_frame_counter = _frame_counter_server = _frame_counter_max = p->Recv_uint32();
+	NetworkStateHashSetInterval(0);
+	NetworkStateHashReset();
+	_network_server_state_hashes.frame = 0;
 
 	_network_join_bytes = 0;
 	_network_join_bytes_total = 0;
@@ -938,6 +990,23 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_SYNC(Packet *p)
 	_sync_seed_2 = p->Recv_uint32();
 #endif
 
+	/* Servers with state hashing append the interval and the last completed hashes. */
+	if (p->pos < p->size) {
+		NetworkStateHashSetInterval(p->Recv_uint16());
+		uint32 frame = p->Recv_uint32();
+		if (frame != 0) {
+			uint count = p->Recv_uint8();
+			NetworkStateHashes hashes;
+			MemSetT(&hashes, 0);
+			hashes.frame = frame;
+			for (uint i = 0; i < count; i++) {
+				uint32 hash = p->Recv_uint32();
+				if (i < NSHS_END) hashes.hash[i] = hash;
+			}
+			if (count == NSHS_END) _network_server_state_hashes = hashes;
+		}
+	}
+
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
@@ -960,6 +1029,28 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND_BATCH(Packet *p)
+{
+	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+	uint32 frame = p->Recv_uint32();
+	while (p->pos < p->size) {
+		CommandPacket cp;
+		const char *err = this->ReceiveCommandBatchItem(p, &cp, frame);
+
+		if (err != NULL) {
+			IConsolePrintF(CC_ERROR, "WARNING: %s from server, dropping...", err);
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+		if (this->HasClientQuit()) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+		frame = cp.frame;
+		this->incoming_queue.Append(std::move(cp));
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CHAT(Packet *p)
 {
 	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
@@ -61,6 +61,7 @@ protected:
 	virtual NetworkRecvStatus Receive_SERVER_FRAME(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
+	virtual NetworkRecvStatus Receive_SERVER_COMMAND_BATCH(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_QUIT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_ERROR_QUIT(Packet *p);
@@ -90,6 +91,7 @@ public:
 	static NetworkRecvStatus SendError(NetworkErrorCode errorno);
 	static NetworkRecvStatus SendQuit();
 	static NetworkRecvStatus SendAck();
+	static NetworkRecvStatus SendDesyncReport(uint32 frame, uint32 mismatch);
 
 	static NetworkRecvStatus SendGamePassword(const char *password);
 	static NetworkRecvStatus SendCompanyPassword(const char *password);
@@ -310,23 +310,15 @@ void NetworkDistributeCommands()
 }
 
 /**
- * Receives a command from the network.
+ * Receives the text and callback of a command from the network.
  * @param p the packet to read from.
  * @param cp the struct to write the data to.
+ * @param binary_length the already read length of the binary data, or 0 for a string.
  * @return an error message. When NULL there has been no error.
  */
-const char *NetworkGameSocketHandler::ReceiveCommand(Packet *p, CommandPacket *cp)
+static const char *ReceiveCommandTextAndCallback(Packet *p, CommandPacket *cp, uint32 binary_length)
 {
-	cp->company = (CompanyID)p->Recv_uint8();
-	cp->cmd     = p->Recv_uint32();
-	if (!IsValidCommand(cp->cmd))               return "invalid command";
-	if (GetCommandFlags(cp->cmd) & CMD_OFFLINE) return "offline only command";
-	if ((cp->cmd & CMD_FLAGS_MASK) != 0)        return "invalid command flag";
-
-	cp->p1      = p->Recv_uint32();
-	cp->p2      = p->Recv_uint32();
-	cp->tile    = p->Recv_uint32();
-	cp->binary_length = p->Recv_uint32();
+	cp->binary_length = binary_length;
 	if (cp->binary_length == 0) {
 		p->Recv_string(cp->text, (!_network_server && GetCommandFlags(cp->cmd) & CMD_STR_CTRL) != 0 ? SVS_ALLOW_CONTROL_CODE | SVS_REPLACE_WITH_QUESTION_MARK : SVS_REPLACE_WITH_QUESTION_MARK);
 	} else {
@@ -343,18 +335,13 @@ const char *NetworkGameSocketHandler::ReceiveCommand(Packet *p, CommandPacket *c
 }
 
 /**
- * Sends a command over the network.
+ * Sends the text and callback of a command over the network.
+ * The length of the binary data must already have been sent.
  * @param p the packet to send it in.
  * @param cp the packet to actually send.
  */
-void NetworkGameSocketHandler::SendCommand(Packet *p, const CommandPacket *cp)
+static void SendCommandTextAndCallback(Packet *p, const CommandPacket *cp)
 {
-	p->Send_uint8 (cp->company);
-	p->Send_uint32(cp->cmd);
-	p->Send_uint32(cp->p1);
-	p->Send_uint32(cp->p2);
-	p->Send_uint32(cp->tile);
-	p->Send_uint32(cp->binary_length);
 	if (cp->binary_length == 0) {
 		p->Send_string(cp->text.c_str());
 	} else {
@@ -374,4 +361,100 @@ void NetworkGameSocketHandler::SendCommand(Packet *p, const CommandPacket *cp)
 	p->Send_uint8 (callback);
 }
 
+/**
+ * Check whether a received command ID is acceptable.
+ * @param cmd the command ID.
+ * @return an error message. When NULL there has been no error.
+ */
+static const char *CheckReceivedCommandID(uint32 cmd)
+{
+	if (!IsValidCommand(cmd))               return "invalid command";
+	if (GetCommandFlags(cmd) & CMD_OFFLINE) return "offline only command";
+	if ((cmd & CMD_FLAGS_MASK) != 0)        return "invalid command flag";
+	return NULL;
+}
+
+/**
+ * Receives a command from the network.
+ * @param p the packet to read from.
+ * @param cp the struct to write the data to.
+ * @return an error message. When NULL there has been no error.
+ */
+const char *NetworkGameSocketHandler::ReceiveCommand(Packet *p, CommandPacket *cp)
+{
+	cp->company = (CompanyID)p->Recv_uint8();
+	cp->cmd     = p->Recv_uint32();
+	const char *err = CheckReceivedCommandID(cp->cmd);
+	if (err != NULL) return err;
+
+	cp->p1      = p->Recv_uint32();
+	cp->p2      = p->Recv_uint32();
+	cp->tile    = p->Recv_uint32();
+	return ReceiveCommandTextAndCallback(p, cp, p->Recv_uint32());
+}
+
+/**
+ * Sends a command over the network.
+ * @param p the packet to send it in.
+ * @param cp the packet to actually send.
+ */
+void NetworkGameSocketHandler::SendCommand(Packet *p, const CommandPacket *cp)
+{
+	p->Send_uint8 (cp->company);
+	p->Send_uint32(cp->cmd);
+	p->Send_uint32(cp->p1);
+	p->Send_uint32(cp->p2);
+	p->Send_uint32(cp->tile);
+	p->Send_uint32(cp->binary_length);
+	SendCommandTextAndCallback(p, cp);
+}
+
+/**
+ * Receives a single command of a batched command packet from the network.
+ * @param p the packet to read from.
+ * @param cp the struct to write the data to.
+ * @param prev_frame the frame of execution of the previous command in the batch.
+ * @return an error message. When NULL there has been no error.
+ */
+const char *NetworkGameSocketHandler::ReceiveCommandBatchItem(Packet *p, CommandPacket *cp, uint32 prev_frame)
+{
+	cp->company = (CompanyID)p->Recv_uint8();
+	cp->cmd     = (uint32)p->Recv_varuint();
+	const char *err = CheckReceivedCommandID(cp->cmd);
+	if (err != NULL) return err;
+
+	cp->p1      = (uint32)p->Recv_varuint();
+	cp->p2      = (uint32)p->Recv_varuint();
+	cp->tile    = (uint32)p->Recv_varuint();
+	err = ReceiveCommandTextAndCallback(p, cp, (uint32)p->Recv_varuint());
+	if (err != NULL) return err;
+
+	cp->frame   = prev_frame + (uint32)p->Recv_varuint();
+	cp->my_cmd  = p->Recv_bool();
+	return NULL;
+}
+
+/**
+ * Sends a single command of a batched command packet over the network.
+ * Commands in the outgoing queue are in frame order, so the frame is sent
+ * as a small delta relative to the previous command in the batch.
+ * @param p the packet to send it in.
+ * @param cp the packet to actually send.
+ * @param prev_frame the frame of execution of the previous command in the batch.
+ */
+void NetworkGameSocketHandler::SendCommandBatchItem(Packet *p, const CommandPacket *cp, uint32 prev_frame)
+{
+	assert(cp->frame >= prev_frame);
+
+	p->Send_uint8  (cp->company);
+	p->Send_varuint(cp->cmd);
+	p->Send_varuint(cp->p1);
+	p->Send_varuint(cp->p2);
+	p->Send_varuint(cp->tile);
+	p->Send_varuint(cp->binary_length);
+	SendCommandTextAndCallback(p, cp);
+	p->Send_varuint(cp->frame - prev_frame);
+	p->Send_bool   (cp->my_cmd);
+}
+
 #endif /* ENABLE_NETWORK */
@@ -16,6 +16,7 @@
 #include "../date_func.h"
 #include "network_admin.h"
 #include "network_server.h"
+#include "network_state_hash.h"
 #include "network_udp.h"
 #include "network_base.h"
 #include "../console_func.h"
@@ -720,6 +721,17 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	p->Send_uint32(_sync_seed_2);
 #endif
+
+	p->Send_uint16(_network_state_hash_interval);
+	if (_network_state_hashes.frame != 0 && _network_state_hashes.frame != this->last_state_hash_frame) {
+		this->last_state_hash_frame = _network_state_hashes.frame;
+		p->Send_uint32(_network_state_hashes.frame);
+		p->Send_uint8(NSHS_END);
+		for (uint i = 0; i < NSHS_END; i++) p->Send_uint32(_network_state_hashes.hash[i]);
+	} else {
+		p->Send_uint32(0);
+	}
+
 	this->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -736,10 +748,51 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacke
 	p->Send_uint32(cp->frame);
 	p->Send_bool  (cp->my_cmd);
 
+	this->cmd_sent_count++;
+	this->cmd_sent_packets++;
+	this->cmd_sent_bytes += p->size;
 	this->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Send all commands in the outgoing queue to the client, packing as many
+ * commands as fit into each packet.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommandBatch()
+{
+	/* Upper bound of the encoded size of a command, excluding its text. */
+	static const uint MAX_BATCH_ITEM_OVERHEAD = 1 + 5 * 5 + 1 + 1 + 5 + 1;
+
+	Packet *p = NULL;
+	uint32 prev_frame = 0;
+	std::unique_ptr<CommandPacket> cp;
+	while ((cp = this->outgoing_queue.Pop()) != NULL) {
+		size_t item_size = MAX_BATCH_ITEM_OVERHEAD + cp->text.size();
+		if (p != NULL && p->size + item_size >= SHRT_MAX) {
+			this->cmd_sent_bytes += p->size;
+			this->SendPacket(p);
+			p = NULL;
+		}
+		if (p == NULL) {
+			p = new Packet(PACKET_SERVER_COMMAND_BATCH);
+			p->Send_uint32(cp->frame);
+			prev_frame = cp->frame;
+			this->cmd_sent_packets++;
+		}
+
+		this->NetworkGameSocketHandler::SendCommandBatchItem(p, cp.get(), prev_frame);
+		prev_frame = cp->frame;
+		this->cmd_sent_count++;
+	}
+
+	if (p != NULL) {
+		this->cmd_sent_bytes += p->size;
+		this->SendPacket(p);
+	}
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -917,6 +970,11 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_JOIN(Packet *p)
 	playas = (Owner)p->Recv_uint8();
 	client_lang = (NetworkLanguage)p->Recv_uint8();
 
+	/* Clients which do not know about batched commands do not send this field. */
+	if (p->CanReadFromPacket(sizeof(uint8), true)) {
+		this->command_batch_version = min<byte>(p->Recv_uint8(), NETWORK_COMMAND_BATCH_VERSION);
+	}
+
 	if (this->HasClientQuit()) return NETWORK_RECV_STATUS_CONN_LOST;
 
 	/* join another company does not affect these values */
@@ -1187,6 +1245,31 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_ERROR(Packet *p
 	return this->CloseConnection(NETWORK_RECV_STATUS_CONN_LOST);
 }
 
+NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_DESYNC_REPORT(Packet *p)
+{
+	if (this->status < STATUS_DONE_MAP || this->HasClientQuit()) {
+		return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
+	}
+
+	uint32 frame = p->Recv_uint32();
+	uint32 mismatch = p->Recv_uint32();
+
+	char client_name[NETWORK_CLIENT_NAME_LENGTH];
+	this->GetClientName(client_name, lastof(client_name));
+
+	char buffer[256];
+	char *b = buffer;
+	for (uint i = 0; i < 32; i++) {
+		if (!HasBit(mismatch, i)) continue;
+		b += seprintf(b, lastof(buffer), "%s%s", b == buffer ? "" : ", ", GetNetworkStateHashSubsystemName(i));
+	}
+	if (b == buffer) strecpy(buffer, "none", lastof(buffer));
+
+	IConsolePrintF(CC_WARNING, "Client #%d (%s) desynced at frame %u, mismatching state: %s", this->client_id, client_name, frame, buffer);
+	DEBUG(desync, 0, "client %d desync report: frame %u, state mismatch: %s", this->client_id, frame, buffer);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_QUIT(Packet *p)
 {
 	/* The client wants to leave. Display this and report it to the other
@@ -1799,6 +1882,11 @@ void NetworkServerSetCompanyPassword(CompanyID company_id, const char *password,
  */
 static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
 {
+	if (cs->command_batch_version > 0 && _settings_client.network.command_batching) {
+		if (cs->outgoing_queue.Count() > 0) cs->SendCommandBatch();
+		return;
+	}
+
 	std::unique_ptr<CommandPacket> cp;
 	while ((cp = cs->outgoing_queue.Pop()) != NULL) {
 		cs->SendCommand(cp.get());
@@ -1994,6 +2082,9 @@ void NetworkServerShowStatusToConsole()
 			cs->client_id, ci->client_name, status, lag,
 			ci->client_playas + (Company::IsValidID(ci->client_playas) ? 1 : 0),
 			cs->GetClientIP());
+		IConsolePrintF(CC_INFO, "            commands sent: " OTTD_PRINTF64U "  packets: " OTTD_PRINTF64U "  bytes: " OTTD_PRINTF64U "  batched: %s",
+			cs->cmd_sent_count, cs->cmd_sent_packets, cs->cmd_sent_bytes,
+			(cs->command_batch_version > 0 && _settings_client.network.command_batching) ? "yes" : "no");
 	}
 }
 
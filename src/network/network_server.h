@@ -35,6 +35,7 @@ protected:
 	virtual NetworkRecvStatus Receive_CLIENT_GETMAP(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_MAP_OK(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_ACK(Packet *p);
+	virtual NetworkRecvStatus Receive_CLIENT_DESYNC_REPORT(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_COMMAND(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_SET_PASSWORD(Packet *p);
@@ -71,9 +72,15 @@ public:
 	byte lag_test;               ///< Byte used for lag-testing the client
 	byte last_token;             ///< The last random token we did send to verify the client is listening
 	uint32 last_token_frame;     ///< The last frame we received the right token
+	uint32 last_state_hash_frame; ///< The frame of the last state hashes we sent
 	ClientStatus status;         ///< Status of this client
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
+	byte command_batch_version;  ///< The version of batched command packets the client supports, 0 if none
+
+	uint64 cmd_sent_count;       ///< Number of commands sent to the client
+	uint64 cmd_sent_packets;     ///< Number of packets used to send commands to the client
+	uint64 cmd_sent_bytes;       ///< Number of bytes used to send commands to the client
 
 	struct PacketWriter *savegame; ///< Writer used to write the savegame.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
@@ -100,6 +107,7 @@ public:
 	NetworkRecvStatus SendFrame();
 	NetworkRecvStatus SendSync();
 	NetworkRecvStatus SendCommand(const CommandPacket *cp);
+	NetworkRecvStatus SendCommandBatch();
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 
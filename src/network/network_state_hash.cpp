@@ -0,0 +1,262 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file network_state_hash.cpp Per-subsystem game state hashes used to pinpoint desyncs.
+ *
+ * The map is far too large to hash in one go, so it is hashed in slices:
+ * every frame hashes MapSize() / interval tiles, such that a complete pass
+ * over the map takes exactly one hash interval. The other subsystems are
+ * small enough to be hashed as a whole at the end of each pass. Passes are
+ * aligned to the frame counter, so the server and all clients hash the same
+ * tiles in the same frames.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../stdafx.h"
+#include "../map_func.h"
+#include "../vehicle_base.h"
+#include "../station_base.h"
+#include "../company_base.h"
+#include "../linkgraph/linkgraph.h"
+#include "network_internal.h"
+#include "network_state_hash.h"
+
+#include "../safeguards.h"
+
+uint16 _network_state_hash_interval;       ///< Number of frames per state hash pass, 0 if disabled.
+NetworkStateHashes _network_state_hashes;  ///< The hashes of the last completed pass.
+
+static uint32 _map_hash_accumulator;       ///< Hash of the map slices hashed so far in the current pass.
+static bool _map_hash_pass_started;        ///< Whether the current pass started at its first slice.
+
+/** Incremental hash over 32 bit words, using the MurmurHash3 mixing steps. */
+struct StateHasher {
+	uint32 state; ///< Current state of the hash.
+
+	StateHasher(uint32 seed = 0x9E3779B9) : state(seed) {}
+
+	inline void Add(uint32 v)
+	{
+		v *= 0xCC9E2D51;
+		v = (v << 15) | (v >> 17);
+		v *= 0x1B873593;
+		this->state ^= v;
+		this->state = (this->state << 13) | (this->state >> 19);
+		this->state = this->state * 5 + 0xE6546B64;
+	}
+
+	inline void Add64(uint64 v)
+	{
+		this->Add((uint32)v);
+		this->Add((uint32)(v >> 32));
+	}
+};
+
+/**
+ * Hash a range of tiles.
+ * @param hasher Hasher to add the tiles to.
+ * @param begin First tile to hash.
+ * @param end Tile after the last tile to hash.
+ */
+static void HashMapSlice(StateHasher &hasher, TileIndex begin, TileIndex end)
+{
+	for (TileIndex t = begin; t < end; t++) {
+		const Tile &m = _m[t];
+		const TileExtended &me = _me[t];
+		hasher.Add((uint32)m.type | ((uint32)m.height << 8) | ((uint32)m.m2 << 16));
+		hasher.Add((uint32)m.m1 | ((uint32)m.m3 << 8) | ((uint32)m.m4 << 16) | ((uint32)m.m5 << 24));
+		hasher.Add((uint32)me.m6 | ((uint32)me.m7 << 8) | ((uint32)me.m8 << 16));
+	}
+}
+
+static uint32 HashVehicles()
+{
+	StateHasher hasher;
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		hasher.Add(v->index);
+		hasher.Add((uint32)v->type | ((uint32)v->direction << 8) | ((uint32)v->vehstatus << 16) | ((uint32)v->progress << 24));
+		hasher.Add(v->tile);
+		hasher.Add(v->x_pos);
+		hasher.Add(v->y_pos);
+		hasher.Add(v->z_pos);
+		hasher.Add((uint32)v->cur_speed | ((uint32)v->subspeed << 16));
+		hasher.Add(v->reliability);
+		hasher.Add64(v->profit_this_year);
+	}
+	return hasher.state;
+}
+
+static uint32 HashStations()
+{
+	StateHasher hasher;
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		hasher.Add(st->index);
+		hasher.Add(st->xy);
+		hasher.Add(st->facilities);
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			const GoodsEntry &ge = st->goods[c];
+			hasher.Add((uint32)ge.status | ((uint32)ge.rating << 8) | ((uint32)ge.time_since_pickup << 16) | ((uint32)ge.last_speed << 24));
+		}
+	}
+	return hasher.state;
+}
+
+static uint32 HashCargo()
+{
+	StateHasher hasher;
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->cargo_cap == 0) continue;
+		hasher.Add(v->index);
+		hasher.Add(v->cargo.TotalCount());
+		hasher.Add64(v->cargo.FeederShare());
+	}
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		hasher.Add(st->index);
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			hasher.Add(st->goods[c].cargo.TotalCount());
+		}
+	}
+	return hasher.state;
+}
+
+static uint32 HashCompanies()
+{
+	StateHasher hasher;
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		hasher.Add(c->index);
+		hasher.Add64(c->money);
+		hasher.Add(c->money_fraction);
+		hasher.Add64(c->current_loan);
+		hasher.Add(c->terraform_limit);
+		hasher.Add(c->clear_limit);
+		hasher.Add(c->tree_limit);
+	}
+	return hasher.state;
+}
+
+static uint32 HashLinkGraphs()
+{
+	StateHasher hasher;
+	const LinkGraph *lg;
+	FOR_ALL_LINK_GRAPHS(lg) {
+		hasher.Add(lg->index);
+		hasher.Add(lg->Cargo());
+		hasher.Add(lg->Size());
+		for (NodeID from = 0; from < lg->Size(); from++) {
+			LinkGraph::ConstNode node = (*lg)[from];
+			hasher.Add(node.Station());
+			hasher.Add(node.Supply());
+			hasher.Add(node.Demand());
+			for (LinkGraph::ConstEdgeIterator it = node.Begin(); it != node.End(); ++it) {
+				hasher.Add(it->first);
+				hasher.Add(it->second.Capacity());
+				hasher.Add(it->second.Usage());
+			}
+		}
+	}
+	return hasher.state;
+}
+
+/**
+ * Forget all hashes and any partial pass, e.g. when joining a game.
+ */
+void NetworkStateHashReset()
+{
+	_map_hash_pass_started = false;
+	MemSetT(&_network_state_hashes, 0);
+}
+
+/**
+ * Set the interval of state hash passes.
+ * Changing the interval invalidates the pass in progress.
+ * @param interval Number of frames per pass, 0 to disable hashing.
+ */
+void NetworkStateHashSetInterval(uint16 interval)
+{
+	if (interval == _network_state_hash_interval) return;
+	_network_state_hash_interval = interval;
+	NetworkStateHashReset();
+}
+
+/**
+ * Hash the next slice of the map and, at the end of a pass, the remaining subsystems.
+ * Must be called after each game loop iteration, with the frame counter of that iteration.
+ */
+void NetworkStateHashTick()
+{
+	const uint interval = _network_state_hash_interval;
+	if (interval == 0) return;
+
+	const uint slice = _frame_counter % interval;
+	if (slice == 0) {
+		_map_hash_accumulator = 0;
+		_map_hash_pass_started = true;
+	}
+	if (!_map_hash_pass_started) return;
+
+	const uint tiles_per_slice = CeilDiv(MapSize(), interval);
+	const uint begin = min(slice * tiles_per_slice, MapSize());
+	const uint end = min(begin + tiles_per_slice, MapSize());
+	StateHasher hasher(_map_hash_accumulator);
+	HashMapSlice(hasher, begin, end);
+	_map_hash_accumulator = hasher.state;
+
+	if (slice != interval - 1) return;
+
+	_network_state_hashes.frame = _frame_counter;
+	_network_state_hashes.hash[NSHS_MAP] = _map_hash_accumulator;
+	_network_state_hashes.hash[NSHS_VEHICLES] = HashVehicles();
+	_network_state_hashes.hash[NSHS_STATIONS] = HashStations();
+	_network_state_hashes.hash[NSHS_CARGO] = HashCargo();
+	_network_state_hashes.hash[NSHS_COMPANIES] = HashCompanies();
+	_network_state_hashes.hash[NSHS_LINKGRAPH] = HashLinkGraphs();
+}
+
+/**
+ * Compare two sets of state hashes.
+ * @param a First set of hashes.
+ * @param b Second set of hashes.
+ * @return Bitmask of the #NetworkStateHashSubsystem which differ.
+ */
+uint32 NetworkStateHashCompare(const NetworkStateHashes &a, const NetworkStateHashes &b)
+{
+	uint32 mismatch = 0;
+	for (uint i = 0; i < NSHS_END; i++) {
+		if (a.hash[i] != b.hash[i]) SetBit(mismatch, i);
+	}
+	return mismatch;
+}
+
+/**
+ * Get the name of a state hash subsystem, for use in logs.
+ * @param subsystem The subsystem.
+ * @return The name.
+ */
+const char *GetNetworkStateHashSubsystemName(uint subsystem)
+{
+	static const char * const names[] = {
+		"map",
+		"vehicles",
+		"stations",
+		"cargo",
+		"companies",
+		"link graph",
+	};
+	assert_compile(lengthof(names) == NSHS_END);
+	return subsystem < lengthof(names) ? names[subsystem] : "unknown";
+}
+
+#endif /* ENABLE_NETWORK */
@@ -0,0 +1,45 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_state_hash.h Per-subsystem game state hashes used to pinpoint desyncs. */
+
+#ifndef NETWORK_STATE_HASH_H
+#define NETWORK_STATE_HASH_H
+
+#ifdef ENABLE_NETWORK
+
+/** Subsystems of the game state which are hashed separately. */
+enum NetworkStateHashSubsystem {
+	NSHS_MAP,       ///< All tiles of the map, hashed incrementally over the hash interval.
+	NSHS_VEHICLES,  ///< Position, speed and state of all vehicles.
+	NSHS_STATIONS,  ///< Stations and their cargo ratings.
+	NSHS_CARGO,     ///< Cargo amounts in vehicles and stations.
+	NSHS_COMPANIES, ///< Finances of all companies.
+	NSHS_LINKGRAPH, ///< Nodes and edges of all link graphs.
+	NSHS_END,       ///< End marker.
+};
+
+/** Set of state hashes taken at a particular frame. */
+struct NetworkStateHashes {
+	uint32 frame;            ///< Frame at which the hashes were completed, 0 if there are none.
+	uint32 hash[NSHS_END];   ///< Hash of each subsystem.
+};
+
+extern uint16 _network_state_hash_interval;
+extern NetworkStateHashes _network_state_hashes;
+
+void NetworkStateHashReset();
+void NetworkStateHashSetInterval(uint16 interval);
+void NetworkStateHashTick();
+uint32 NetworkStateHashCompare(const NetworkStateHashes &a, const NetworkStateHashes &b);
+const char *GetNetworkStateHashSubsystemName(uint subsystem);
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_STATE_HASH_H */
@@ -56,6 +56,7 @@ struct AirportTileResolverObject : public ResolverObject {
 			default: return ResolverObject::GetScope(scope, relative);
 		}
 	}
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_AIRPORTTILES; }
 };
 
 /**
@@ -67,6 +67,8 @@ struct VehicleResolverObject : public ResolverObject {
 	/* virtual */ ScopeResolver *GetScope(VarSpriteGroupScope scope = VSG_SCOPE_SELF, byte relative = 0);
 
 	/* virtual */ const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
+
+	/* virtual */ GrfSpecFeature GetFeature() const;
 };
 
 static const uint TRAININFO_DEFAULT_VEHICLE_WIDTH   = 29;
@@ -64,6 +64,8 @@ struct GenericResolverObject : public ResolverObject {
 	}
 
 	/* virtual */ const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
+
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_GLOBALVAR; }
 };
 
 struct GenericCallback {
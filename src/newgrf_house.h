@@ -89,6 +89,7 @@ struct HouseResolverObject : public ResolverObject {
 			default: return ResolverObject::GetScope(scope, relative);
 		}
 	}
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_HOUSES; }
 };
 
 /**
@@ -65,6 +65,7 @@ struct IndustriesResolverObject : public ResolverObject {
 				return ResolverObject::GetScope(scope, relative);
 		}
 	}
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_INDUSTRIES; }
 };
 
 /** When should the industry(tile) be triggered for random bits? */
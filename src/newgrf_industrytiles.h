@@ -53,6 +53,7 @@ struct IndustryTileResolverObject : public ResolverObject {
 			default: return ResolverObject::GetScope(scope, relative);
 		}
 	}
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_INDUSTRYTILES; }
 };
 
 bool DrawNewIndustryTile(TileInfo *ti, Industry *i, IndustryGfx gfx, const IndustryTileSpec *inds);
@@ -146,6 +146,8 @@ struct ObjectResolverObject : public ResolverObject {
 		}
 	}
 
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_OBJECTS; }
+
 private:
 	TownScopeResolver *GetTown();
 };
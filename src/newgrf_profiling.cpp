@@ -0,0 +1,193 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_profiling.cpp Profiling of NewGRF sprite group resolution. */
+
+#include "stdafx.h"
+#include "newgrf_profiling.h"
+#include "newgrf_spritegroup.h"
+#include "newgrf_config.h"
+#include "console_func.h"
+#include "string_func.h"
+#include "3rdparty/cpp-btree/btree_map.h"
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+#include "safeguards.h"
+
+bool _newgrf_profiling_active = false;             ///< Whether top level resolutions are being profiled.
+uint32 _newgrf_profile_evaluations = 0;            ///< Number of VarAction2 evaluated so far, wraps around.
+NewGRFResultCacheStats _newgrf_result_cache_stats; ///< Statistics of cached NewGRF results.
+
+/**
+ * Statistics per NewGRF, feature and callback.
+ * The key holds the GRF ID in the upper 32 bits, the feature in bits 16..23 and the callback in the lower 16 bits.
+ */
+static btree::btree_map<uint64, NewGRFProfileStats> _newgrf_profile_stats;
+
+/** Get a timestamp in nanoseconds for profiling. */
+static inline uint64 GetNewGRFProfileTimer()
+{
+	using namespace std::chrono;
+	return (uint64)time_point_cast<nanoseconds>(high_resolution_clock::now()).time_since_epoch().count();
+}
+
+/** Begin profiling a resolution. */
+void NewGRFProfileMeasurer::Begin()
+{
+	this->start_evaluations = _newgrf_profile_evaluations;
+	this->start_time = GetNewGRFProfileTimer();
+}
+
+/** Finish profiling a resolution and add it to the statistics of its NewGRF, feature and callback. */
+void NewGRFProfileMeasurer::End()
+{
+	uint64 duration = GetNewGRFProfileTimer() - this->start_time;
+	uint32 evaluations = _newgrf_profile_evaluations - this->start_evaluations;
+
+	uint32 grfid = this->object.grffile != NULL ? this->object.grffile->grfid : 0;
+	uint64 key = ((uint64)grfid << 32) | ((uint64)(byte)this->object.GetFeature() << 16) | (uint16)this->object.callback;
+	NewGRFProfileStats &stats = _newgrf_profile_stats[key];
+	stats.calls++;
+	stats.time += duration;
+	stats.evaluations += evaluations;
+	stats.max_evaluations = max(stats.max_evaluations, evaluations);
+}
+
+/** Discard all profiling data and start profiling. */
+void StartNewGRFProfiling()
+{
+	_newgrf_profile_stats.clear();
+	MemSetT(&_newgrf_result_cache_stats, 0);
+	_newgrf_profiling_active = true;
+}
+
+/** Stop profiling, keeping the data gathered so far. */
+void StopNewGRFProfiling()
+{
+	_newgrf_profiling_active = false;
+}
+
+/**
+ * Get the name of a feature for the profile output.
+ * @param feature The feature.
+ * @return Name of the feature.
+ */
+static const char *GetNewGRFProfileFeatureName(byte feature)
+{
+	static const char * const FEATURE_NAMES[] = {
+		"trains",
+		"road vehicles",
+		"ships",
+		"aircraft",
+		"stations",
+		"canals",
+		"bridges",
+		"houses",
+		"global",
+		"industry tiles",
+		"industries",
+		"cargoes",
+		"sounds",
+		"airports",
+		"signals",
+		"objects",
+		"rail types",
+		"airport tiles",
+		"towns",
+	};
+	assert_compile(lengthof(FEATURE_NAMES) == GSF_FAKE_END);
+	return feature < lengthof(FEATURE_NAMES) ? FEATURE_NAMES[feature] : "unknown";
+}
+
+/**
+ * Describe a group of statistics for the profile output.
+ * @param buf Buffer to write to.
+ * @param last Last element of the buffer.
+ * @param key Key of the group, with the parts not grouped by set to zero.
+ * @param by_grf Whether the key contains a NewGRF.
+ * @param by_feature Whether the key contains a feature.
+ * @param by_callback Whether the key contains a callback.
+ */
+static void GetNewGRFProfileGroupName(char *buf, const char *last, uint64 key, bool by_grf, bool by_feature, bool by_callback)
+{
+	buf[0] = '\0';
+	if (by_grf) {
+		uint32 grfid = (uint32)(key >> 32);
+		const GRFConfig *c = GetGRFConfig(grfid);
+		buf += seprintf(buf, last, "%08X (%s) ", BSWAP32(grfid), c != NULL ? c->GetName() : "none");
+	}
+	if (by_feature) {
+		buf += seprintf(buf, last, "%s ", GetNewGRFProfileFeatureName(GB(key, 16, 8)));
+	}
+	if (by_callback) {
+		uint16 callback = GB(key, 0, 16);
+		switch (callback) {
+			case CBID_NO_CALLBACK:    seprintf(buf, last, "sprites"); break;
+			case CBID_RANDOM_TRIGGER: seprintf(buf, last, "random triggers"); break;
+			default:                  seprintf(buf, last, "callback 0x%02X", callback); break;
+		}
+	}
+}
+
+/**
+ * Print the NewGRF resolutions which took the most time to the console.
+ * @param group_by How to group the statistics: "grf", "feature", "callback" or "all".
+ * @param count Number of groups to print.
+ */
+void ConPrintNewGRFProfile(const char *group_by, uint count)
+{
+	bool by_grf = strcmp(group_by, "grf") == 0;
+	bool by_feature = strcmp(group_by, "feature") == 0;
+	bool by_callback = strcmp(group_by, "callback") == 0;
+	if (strcmp(group_by, "all") == 0) {
+		by_grf = by_feature = by_callback = true;
+	} else if (!by_grf && !by_feature && !by_callback) {
+		IConsoleError("Statistics can only be grouped by 'grf', 'feature', 'callback' or 'all'");
+		return;
+	}
+
+	uint64 mask = 0;
+	if (by_grf) mask |= (uint64)0xFFFFFFFF << 32;
+	if (by_feature) mask |= 0xFF << 16;
+	if (by_callback) mask |= 0xFFFF;
+
+	btree::btree_map<uint64, NewGRFProfileStats> groups;
+	NewGRFProfileStats total;
+	for (const auto &it : _newgrf_profile_stats) {
+		groups[it.first & mask].Add(it.second);
+		total.Add(it.second);
+	}
+
+	if (groups.empty()) {
+		IConsoleWarning(_newgrf_profiling_active ? "No NewGRF resolutions have been profiled yet" : "NewGRF profiling has not been started, use 'newgrf_profile start' first");
+		return;
+	}
+
+	std::vector<std::pair<uint64, NewGRFProfileStats>> sorted(groups.begin(), groups.end());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint64, NewGRFProfileStats> &a, const std::pair<uint64, NewGRFProfileStats> &b) {
+		return a.second.time > b.second.time;
+	});
+
+	IConsolePrintF(CC_DEFAULT, "Total: " OTTD_PRINTF64U " resolutions, %.3f ms%s", total.calls, total.time / 1000000.0, _newgrf_profiling_active ? "" : " (stopped)");
+	IConsolePrint(CC_DEFAULT, "Calls, total ms, average us, average and maximum VarAction2 evaluated:");
+	for (uint i = 0; i < sorted.size() && i < count; i++) {
+		const NewGRFProfileStats &stats = sorted[i].second;
+		char name[256];
+		GetNewGRFProfileGroupName(name, lastof(name), sorted[i].first, by_grf, by_feature, by_callback);
+		IConsolePrintF(CC_INFO, "%s: " OTTD_PRINTF64U "  %.3f  %.2f  %.1f  %u",
+				name, stats.calls, stats.time / 1000000.0, stats.time / 1000.0 / stats.calls,
+				(double)stats.evaluations / stats.calls, stats.max_evaluations);
+	}
+
+	const NewGRFResultCacheStats &cache = _newgrf_result_cache_stats;
+	IConsolePrintF(CC_DEFAULT, "Vehicle sprite cache: " OTTD_PRINTF64U " hits, " OTTD_PRINTF64U " misses, " OTTD_PRINTF64U " not cacheable",
+			cache.vehicle_sprite_hits, cache.vehicle_sprite_misses, cache.vehicle_sprite_uncacheable);
+}
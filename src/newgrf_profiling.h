@@ -0,0 +1,76 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_profiling.h Profiling of NewGRF sprite group resolution. */
+
+#ifndef NEWGRF_PROFILING_H
+#define NEWGRF_PROFILING_H
+
+#include "core/math_func.hpp"
+
+struct ResolverObject;
+
+/** Statistics of the resolutions of one NewGRF, feature and callback. */
+struct NewGRFProfileStats {
+	uint64 calls;           ///< Number of resolutions.
+	uint64 time;            ///< Time taken by all resolutions in nanoseconds, including nested resolutions.
+	uint64 evaluations;     ///< Number of VarAction2 evaluated by all resolutions.
+	uint32 max_evaluations; ///< Largest number of VarAction2 evaluated by a single resolution.
+
+	NewGRFProfileStats() : calls(0), time(0), evaluations(0), max_evaluations(0) {}
+
+	void Add(const NewGRFProfileStats &other)
+	{
+		this->calls += other.calls;
+		this->time += other.time;
+		this->evaluations += other.evaluations;
+		this->max_evaluations = max(this->max_evaluations, other.max_evaluations);
+	}
+};
+
+/** Statistics of cached NewGRF results. */
+struct NewGRFResultCacheStats {
+	uint64 vehicle_sprite_hits;        ///< Vehicle sprites reused without resolving them.
+	uint64 vehicle_sprite_misses;      ///< Vehicle sprites resolved, after which they could be cached.
+	uint64 vehicle_sprite_uncacheable; ///< Vehicle sprites resolved, which could not be cached.
+};
+
+extern bool _newgrf_profiling_active;
+extern uint32 _newgrf_profile_evaluations;
+extern NewGRFResultCacheStats _newgrf_result_cache_stats;
+
+/**
+ * RAII class for profiling a top level sprite group resolution.
+ * Nothing is measured unless NewGRF profiling is active.
+ */
+class NewGRFProfileMeasurer {
+	const ResolverObject &object;
+	bool active;
+	uint64 start_time;
+	uint32 start_evaluations;
+
+	void Begin();
+	void End();
+public:
+	inline NewGRFProfileMeasurer(const ResolverObject &object) : object(object), active(_newgrf_profiling_active)
+	{
+		if (this->active) this->Begin();
+	}
+
+	inline ~NewGRFProfileMeasurer()
+	{
+		if (this->active) this->End();
+	}
+};
+
+void StartNewGRFProfiling();
+void StopNewGRFProfiling();
+void ConPrintNewGRFProfile(const char *group_by, uint count);
+
+#endif /* NEWGRF_PROFILING_H */
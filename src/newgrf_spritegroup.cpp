@@ -15,6 +15,8 @@
 #include "newgrf_spritegroup.h"
 #include "core/pool_func.hpp"
 #include "vehicle_type.h"
+#include "framerate_type.h"
+#include "newgrf_profiling.h"
 
 #include "safeguards.h"
 
@@ -39,6 +41,11 @@ TemporaryStorageArray<int32, 0x110> _temp_store;
 	if (group == NULL) return NULL;
 	if (top_level) {
 		_temp_store.ClearChanges();
+		NewGRFProfileMeasurer profile(object);
+		if (object.callback != CBID_NO_CALLBACK) {
+			PerformanceZoneMeasurer zone(PFZ_NEWGRF_CALLBACKS);
+			return group->Resolve(object);
+		}
 	}
 	return group->Resolve(object);
 }
@@ -203,6 +210,8 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 
 	ScopeResolver *scope = object.GetScope(this->var_scope);
 
+	_newgrf_profile_evaluations++;
+
 	for (i = 0; i < this->num_adjusts; i++) {
 		DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
 
@@ -367,6 +367,12 @@ struct ResolverObject {
 
 	virtual ScopeResolver *GetScope(VarSpriteGroupScope scope = VSG_SCOPE_SELF, byte relative = 0);
 
+	/**
+	 * Get the feature of the object being resolved, for debugging and profiling.
+	 * @return The feature, or #GSF_INVALID if unknown.
+	 */
+	virtual GrfSpecFeature GetFeature() const { return GSF_INVALID; }
+
 	/**
 	 * Returns the waiting triggers that did not trigger any rerandomisation.
 	 */
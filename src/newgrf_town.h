@@ -71,6 +71,7 @@ struct TownResolverObject : public ResolverObject {
 			default: return ResolverObject::GetScope(scope, relative);
 		}
 	}
+	/* virtual */ GrfSpecFeature GetFeature() const { return GSF_FAKE_TOWNS; }
 };
 
 #endif /* NEWGRF_TOWN_H */
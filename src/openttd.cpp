@@ -49,6 +49,8 @@
 #include "rev.h"
 #include "highscore.h"
 #include "station_base.h"
+#include "station_func.h"
+#include "industry.h"
 #include "crashlog.h"
 #include "engine_func.h"
 #include "core/random_func.hpp"
@@ -334,6 +336,7 @@ static void ParseResolution(Dimension *res, const char *s)
  */
 static void ShutdownGame()
 {
+	StopSpritePrefetch();
 	IConsoleFree();
 
 	if (_network_available) NetworkShutDown(); // Shut down the network and close any open connections
@@ -373,6 +376,9 @@ static void ShutdownGame()
 	UninitFreeType();
 
 	ViewportMapClearTunnelCache();
+	ViewportMapClearCache();
+	ClearSmallMapCache();
+	ClearMapTileExport();
 	ClearCommandLog();
 }
 
@@ -1494,6 +1500,20 @@ void CheckCaches(bool force_check)
 			st->goods[c].cargo.InvalidateCache();
 			assert(memcmp(&st->goods[c].cargo, buff, sizeof(StationCargoList)) == 0);
 		}
+
+		if (!IsStationCatchmentIndexValid(st)) DEBUG(desync, 0, "station catchment index mismatch: station %i", (int)st->index);
+	}
+
+	Industry *ind;
+	FOR_ALL_INDUSTRIES(ind) {
+		/* Lists made with an older version of the station catchment index are rebuilt when used. */
+		if (ind->stations_near_version != _station_catchment_index_version) continue;
+
+		StationList stations;
+		FindStationsAroundTiles(ind->location, &stations);
+		bool same = stations.Length() == ind->stations_near.Length();
+		for (uint i = 0; same && i < stations.Length(); i++) same = stations[i] == ind->stations_near[i];
+		if (!same) DEBUG(desync, 0, "industry stations near mismatch: industry %i", (int)ind->index);
 	}
 }
 
@@ -1547,6 +1567,7 @@ void StateGameLoop()
 
 	PerformanceMeasurer framerate(PFE_GAMELOOP);
 	PerformanceAccumulator::Reset(PFE_GL_LANDSCAPE);
+	PerformanceZoneMeasurer::Tick();
 	if (HasModalProgress()) return;
 
 	Layouter::ReduceLineCache();
@@ -1658,7 +1679,8 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
-	IncreaseSpriteLRU();
+	ProcessSpritePrefetches();
+	CheckSpriteCacheSize();
 	InteractiveRandom();
 
 	extern int _caret_timer;
@@ -221,6 +221,11 @@ uint GetCPUCoreCount()
 	return 1;
 }
 
+size_t GetPeakMemoryUsage()
+{
+	return 0;
+}
+
 void OSOpenBrowser(const char *url)
 {
 	// stub only
@@ -24,6 +24,9 @@
 #include <sys/stat.h>
 #include <time.h>
 #include <signal.h>
+#if !defined(__MORPHOS__) && !defined(__AMIGA__)
+#include <sys/resource.h>
+#endif
 
 #ifdef __APPLE__
 	#include <sys/mount.h>
@@ -332,6 +335,26 @@ void CSleep(int milliseconds)
 }
 
 
+/**
+ * Get the peak resident memory usage of the process.
+ * @return The peak memory usage in bytes, or 0 if unknown.
+ */
+size_t GetPeakMemoryUsage()
+{
+#if defined(__MORPHOS__) || defined(__AMIGA__)
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	/* macOS reports bytes, everything else kilobytes. */
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
 #ifndef __APPLE__
 uint GetCPUCoreCount()
 {
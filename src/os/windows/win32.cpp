@@ -19,6 +19,7 @@
 #include <regstr.h>
 #include <shlobj.h> /* SHGetFolderPath */
 #include <shellapi.h>
+#include <psapi.h>
 #include "win32.h"
 #include "../../fios.h"
 #include "../../core/alloc_func.hpp"
@@ -743,6 +744,29 @@ uint GetCPUCoreCount()
 	return info.dwNumberOfProcessors;
 }
 
+/**
+ * Get the peak working set size of the process.
+ * @return The peak memory usage in bytes, or 0 if unknown.
+ */
+size_t GetPeakMemoryUsage()
+{
+	static BOOL (WINAPI *GetProcessMemoryInfoProc)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD) = NULL;
+	static bool first_time = true;
+
+	/* The function lives in kernel32.dll as of Windows 7, before that only in psapi.dll. */
+	if (first_time) {
+		if (!LoadLibraryList((Function*)&GetProcessMemoryInfoProc, "kernel32.dll\0K32GetProcessMemoryInfo\0\0")) {
+			LoadLibraryList((Function*)&GetProcessMemoryInfoProc, "psapi.dll\0GetProcessMemoryInfo\0\0");
+		}
+		first_time = false;
+	}
+	if (GetProcessMemoryInfoProc == NULL) return 0;
+
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfoProc(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize;
+}
+
 
 static WCHAR _cur_iso_locale[16] = L"";
 
@@ -28,6 +28,7 @@
 #include "../roadveh.h"
 #include "../train.h"
 #include "../station_base.h"
+#include "../station_func.h"
 #include "../waypoint_base.h"
 #include "../roadstop_base.h"
 #include "../dock_base.h"
@@ -293,6 +294,7 @@ static void InitializeWindowsAndCaches()
 
 	GroupStatistics::UpdateAfterLoad();
 
+	ClearStationCatchmentIndex();
 	Station::RecomputeIndustriesNearForAll();
 	RebuildSubsidisedSourceAndDestinationCache();
 
@@ -597,6 +599,10 @@ bool AfterLoadGame()
 
 	TileIndex map_size = MapSize();
 
+	/* The spatial indices are needed by CalcClosestTownFromTile and friends below. */
+	RebuildTownGridIndex();
+	RebuildIndustryGridIndex();
+
 	extern TileIndex _cur_tileloop_tile; // From landscape.cpp.
 	/* The LFSR used in RunTileLoop iteration cannot have a zeroed state, make it non-zeroed. */
 	if (_cur_tileloop_tile == 0) _cur_tileloop_tile = 1;
@@ -119,6 +119,10 @@ const SaveLoad *GetCargoPacketDesc()
  */
 static void Save_CAPA()
 {
+	/* Save the days in transit including the ageing the vehicles postponed. */
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) v->cargo.ApplyPendingAge();
+
 	CargoPacket *cp;
 
 	FOR_ALL_CARGOPACKETS(cp) {
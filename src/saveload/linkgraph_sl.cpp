@@ -24,6 +24,7 @@ typedef LinkGraph::BaseEdge Edge;
 const SettingDesc *GetSettingDescription(uint index);
 
 static uint16 _num_nodes;
+static NodeID _next_edge; ///< Destination of the next edge in the chain of saved edges of a node.
 
 /**
  * Get a SaveLoad array for a link graph.
@@ -134,31 +135,71 @@ static const SaveLoad _edge_desc[] = {
 	     SLE_VAR(Edge, usage,                    SLE_UINT32),
 	     SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 	 SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, 187, SL_MAX_VERSION),
-	     SLE_VAR(Edge, next_edge,                SLE_UINT16),
+	    SLEG_VAR(_next_edge,                     SLE_UINT16),
 	     SLE_END()
 };
 
 /**
- * Save/load a link graph.
- * @param lg Link graph to be saved or loaded.
+ * Save a link graph. The edges of each node are saved as a chain, starting
+ * with an empty edge from the node to itself, each edge holding the
+ * destination of the next one.
+ * @param lg Link graph to be saved.
  */
-void SaveLoad_LinkGraph(LinkGraph &lg)
+void Save_LinkGraph(LinkGraph &lg)
 {
 	uint size = lg.Size();
 	for (NodeID from = 0; from < size; ++from) {
-		Node *node = &lg.nodes[from];
-		SlObject(node, _node_desc);
+		SlObject(&lg.nodes[from], _node_desc);
+		LinkGraph::EdgeVector &edges = *lg.edges[from];
+		Edge start;
+		start.Init(from);
+		_next_edge = edges.empty() ? INVALID_NODE : edges.front().dest_node;
+		SlObject(&start, _edge_desc);
+		for (size_t i = 0; i < edges.size(); ++i) {
+			_next_edge = i + 1 < edges.size() ? edges[i + 1].dest_node : INVALID_NODE;
+			SlObject(&edges[i], _edge_desc);
+		}
+	}
+}
+
+/**
+ * Load a link graph and convert the saved edge chains to sorted edge lists.
+ * @param lg Link graph to be loaded.
+ */
+void Load_LinkGraph(LinkGraph &lg)
+{
+	uint size = lg.Size();
+	std::vector<Edge> row;
+	std::vector<NodeID> next;
+	for (NodeID from = 0; from < size; ++from) {
+		SlObject(&lg.nodes[from], _node_desc);
+		LinkGraph::EdgeVector &edges = *lg.edges[from];
 		if (IsSavegameVersionBefore(191)) {
 			/* We used to save the full matrix ... */
+			row.resize(size);
+			next.resize(size);
 			for (NodeID to = 0; to < size; ++to) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+				row[to].Init(to);
+				SlObject(&row[to], _edge_desc);
+				next[to] = _next_edge;
+			}
+			for (NodeID to = next[from]; to != INVALID_NODE; to = next[to]) {
+				edges.push_back(row[to]);
 			}
 		} else {
 			/* ... but as that wasted a lot of space we save a sparse matrix now. */
-			for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+			Edge edge;
+			edge.Init(from);
+			SlObject(&edge, _edge_desc);
+			for (NodeID to = _next_edge; to != INVALID_NODE; to = _next_edge) {
+				edge.Init(to);
+				SlObject(&edge, _edge_desc);
+				edges.push_back(edge);
 			}
 		}
+		std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+			return a.dest_node < b.dest_node;
+		});
 	}
 }
 
@@ -171,7 +212,7 @@ static void DoSave_LGRJ(LinkGraphJob *lgj)
 	SlObject(lgj, GetLinkGraphJobDesc());
 	_num_nodes = lgj->Size();
 	SlObject(const_cast<LinkGraph *>(&lgj->Graph()), GetLinkGraphDesc());
-	SaveLoad_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
+	Save_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
 }
 
 /**
@@ -182,7 +223,7 @@ static void DoSave_LGRP(LinkGraph *lg)
 {
 	_num_nodes = lg->Size();
 	SlObject(lg, GetLinkGraphDesc());
-	SaveLoad_LinkGraph(*lg);
+	Save_LinkGraph(*lg);
 }
 
 /**
@@ -199,7 +240,7 @@ static void Load_LGRP()
 		LinkGraph *lg = new (index) LinkGraph();
 		SlObject(lg, GetLinkGraphDesc());
 		lg->Init(_num_nodes);
-		SaveLoad_LinkGraph(*lg);
+		Load_LinkGraph(*lg);
 	}
 }
 
@@ -222,7 +263,7 @@ static void Load_LGRJ()
 		LinkGraph &lg = const_cast<LinkGraph &>(lgj->Graph());
 		SlObject(&lg, GetLinkGraphDesc());
 		lg.Init(_num_nodes);
-		SaveLoad_LinkGraph(lg);
+		Load_LinkGraph(lg);
 	}
 }
 
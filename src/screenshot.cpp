@@ -26,9 +26,12 @@
 #include "tile_map.h"
 #include "landscape.h"
 #include "smallmap_gui.h"
+#include "thread/thread.h"
 
 #include "table/strings.h"
 
+#include <vector>
+
 #include "safeguards.h"
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
@@ -749,6 +752,175 @@ void SetupScreenshotViewport(ScreenshotType t, ViewPort *vp)
 	vp->overlay = NULL;
 }
 
+/** Maximum number of bytes of a strip rendered for a screenshot which is encoded by another thread. */
+static const uint SCREENSHOT_STRIP_BYTES = 32 * 1024 * 1024;
+/** Maximum number of lines of a strip rendered for a screenshot which is encoded by another thread. */
+static const uint SCREENSHOT_STRIP_MAX_LINES = 256;
+/** Number of strips that can be rendered ahead of the encoder; one is being rendered while the other is encoded. */
+static const uint SCREENSHOT_STRIP_COUNT = 2;
+
+/**
+ * Rendering of a screenshot on the main thread, while the image encoder of the screenshot format
+ * runs on its own thread. The encoder asks for the lines in its own order and chunk size, the
+ * main thread renders ahead in larger strips so the drawing of the viewport can be split over
+ * multiple threads as well. At most #SCREENSHOT_STRIP_COUNT strips are in memory.
+ */
+struct ScreenshotPipeline {
+	/** A strip of rendered lines. */
+	struct Strip {
+		uint8 *buf;    ///< The pixels of the strip.
+		uint y;        ///< First line of the strip.
+		uint n;        ///< Number of lines in the strip.
+		uint consumed; ///< Number of lines already handed to the encoder.
+	};
+
+	const ScreenshotFormat *sf; ///< Format to encode the screenshot in.
+	const char *name;           ///< Filename of the screenshot.
+	ScreenshotCallback *callb;  ///< Function rendering the lines of the screenshot.
+	void *userdata;             ///< User data of #callb.
+	uint width;                 ///< Width of the screenshot in pixels.
+	uint height;                ///< Height of the screenshot in pixels.
+	int pixelformat;            ///< Bits per pixel.
+	const Colour *palette;      ///< Colour palette for 8bpp screenshots.
+
+	ThreadMutex *mutex;         ///< Mutex guarding everything below.
+	uint strip_lines;           ///< Number of lines per strip; 0 until the encoder asked for its first lines.
+	bool bottom_up;             ///< Whether the encoder asks for the bottom lines first.
+	bool done;                  ///< Whether the encoder has finished, possibly without asking for all lines.
+	bool result;                ///< Whether the encoder wrote the screenshot successfully.
+	uint rendered;              ///< Number of strips rendered so far.
+	uint encoded;               ///< Number of strips fully handed to the encoder.
+	Strip strips[SCREENSHOT_STRIP_COUNT]; ///< Buffers of the strips; strip \c i is in <tt>strips[i % SCREENSHOT_STRIP_COUNT]</tt>.
+
+	/**
+	 * Get the lines of a strip.
+	 * @param index Index of the strip in rendering order.
+	 * @param[out] y First line of the strip.
+	 * @param[out] n Number of lines in the strip.
+	 */
+	void GetStripLines(uint index, uint *y, uint *n) const
+	{
+		uint start = index * this->strip_lines;
+		*n = min(this->strip_lines, this->height - start);
+		*y = this->bottom_up ? this->height - start - *n : start;
+	}
+};
+
+/**
+ * Callback for the encoder thread of a #ScreenshotPipeline, handing out the lines rendered by the main thread.
+ * @see ScreenshotCallback
+ */
+static void ScreenshotPipelineCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	ScreenshotPipeline *sp = (ScreenshotPipeline *)userdata;
+	ThreadMutexLocker lock(sp->mutex);
+
+	if (sp->strip_lines == 0) {
+		/* Render in whole multiples of the chunks of the encoder, so every chunk is within one strip. */
+		uint line_bytes = sp->width * sp->pixelformat / 8;
+		uint chunks = Clamp(SCREENSHOT_STRIP_BYTES / (line_bytes * n), 1, max(1U, SCREENSHOT_STRIP_MAX_LINES / n));
+		sp->strip_lines = chunks * n;
+		sp->bottom_up = y != 0;
+		sp->mutex->SendSignal();
+	}
+
+	while (sp->encoded == sp->rendered) sp->mutex->WaitForSignal();
+
+	ScreenshotPipeline::Strip &strip = sp->strips[sp->encoded % SCREENSHOT_STRIP_COUNT];
+	assert(y >= strip.y && y + n <= strip.y + strip.n);
+
+	/* The main thread does not touch this strip until it is consumed. */
+	sp->mutex->EndCritical();
+	uint line_bytes = pitch * sp->pixelformat / 8;
+	memcpy(buf, strip.buf + (y - strip.y) * line_bytes, n * line_bytes);
+	sp->mutex->BeginCritical();
+
+	strip.consumed += n;
+	if (strip.consumed == strip.n) {
+		sp->encoded++;
+		sp->mutex->SendSignal();
+	}
+}
+
+/**
+ * Encoder thread of a #ScreenshotPipeline.
+ * @param data The ScreenshotPipeline.
+ */
+static void ScreenshotPipelineThread(void *data)
+{
+	ScreenshotPipeline *sp = (ScreenshotPipeline *)data;
+	bool result = sp->sf->proc(sp->name, ScreenshotPipelineCallback, sp, sp->width, sp->height, sp->pixelformat, sp->palette);
+
+	ThreadMutexLocker lock(sp->mutex);
+	sp->result = result;
+	sp->done = true;
+	sp->mutex->SendSignal();
+}
+
+/**
+ * Write a screenshot, rendering it on this thread while it is encoded on another.
+ * When no thread can be started the screenshot is written in the usual way.
+ * @param sf          Format of the screenshot.
+ * @param name        Filename, including extension.
+ * @param callb       Callback function for generating lines of pixels; called on this thread only.
+ * @param userdata    User data, passed on to \a callb.
+ * @param w           Width of the image in pixels.
+ * @param h           Height of the image in pixels.
+ * @param pixelformat Bits per pixel (bpp), either 8 or 32.
+ * @param palette     %Colour palette (for 8bpp images).
+ * @return File was written successfully.
+ */
+static bool MakePipelinedScreenshot(const ScreenshotFormat *sf, const char *name, ScreenshotCallback *callb, void *userdata, uint w, uint h, int pixelformat, const Colour *palette)
+{
+	ScreenshotPipeline sp;
+	MemSetT(&sp, 0);
+	sp.sf = sf;
+	sp.name = name;
+	sp.callb = callb;
+	sp.userdata = userdata;
+	sp.width = w;
+	sp.height = h;
+	sp.pixelformat = pixelformat;
+	sp.palette = palette;
+	sp.mutex = ThreadMutex::New();
+
+	ThreadObject *thread;
+	if (!ThreadObject::New(&ScreenshotPipelineThread, &sp, &thread, "ottd:screenshot")) {
+		delete sp.mutex;
+		return sf->proc(name, callb, userdata, w, h, pixelformat, palette);
+	}
+
+	sp.mutex->BeginCritical();
+	/* The strip size and order depend on how the encoder asks for the lines. */
+	while (sp.strip_lines == 0 && !sp.done) sp.mutex->WaitForSignal();
+
+	uint count = sp.done ? 0 : CeilDiv(h, sp.strip_lines);
+	for (uint i = 0; i < count; i++) {
+		while (sp.rendered - sp.encoded == SCREENSHOT_STRIP_COUNT && !sp.done) sp.mutex->WaitForSignal();
+		if (sp.done) break;
+
+		ScreenshotPipeline::Strip &strip = sp.strips[i % SCREENSHOT_STRIP_COUNT];
+		if (strip.buf == NULL) strip.buf = MallocT<uint8>((size_t)sp.strip_lines * w * pixelformat / 8);
+		sp.GetStripLines(i, &strip.y, &strip.n);
+		strip.consumed = 0;
+
+		sp.mutex->EndCritical();
+		callb(userdata, strip.buf, strip.y, w, strip.n);
+		sp.mutex->BeginCritical();
+
+		sp.rendered++;
+		sp.mutex->SendSignal();
+	}
+	sp.mutex->EndCritical();
+
+	thread->Join();
+	delete thread;
+	delete sp.mutex;
+	for (uint i = 0; i < SCREENSHOT_STRIP_COUNT; i++) free(sp.strips[i].buf);
+
+	return sp.result;
+}
+
 /**
  * Make a screenshot of the map.
  * @param t Screenshot type: World or viewport screenshot
@@ -760,7 +932,7 @@ static bool MakeLargeWorldScreenshot(ScreenshotType t)
 	SetupScreenshotViewport(t, &vp);
 
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
-	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
+	return MakePipelinedScreenshot(sf, MakeScreenshotName(SCREENSHOT_NAME, sf->extension), LargeWorldCallback, &vp, vp.width, vp.height,
 			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
 }
 
@@ -954,10 +1126,8 @@ static void MinimapOwnerCallback(void *userdata, void *buf, uint y, uint pitch,
 	}
 }
 
-/**
- * Saves the complete savemap in a PNG-file.
- */
-void SaveMinimap(const char *name)
+/** Fill the table with the colour of each owner in the minimap. */
+static void SetupMinimapOwnerColours()
 {
 	/* setup owner table */
 	const Company *c;
@@ -973,6 +1143,14 @@ void SaveMinimap(const char *name)
 		_owner_colours[c->index] =
 			_colour_gradient[c->colour][5] * 0x01010101;
 	}
+}
+
+/**
+ * Saves the complete savemap in a PNG-file.
+ */
+void SaveMinimap(const char *name)
+{
+	SetupMinimapOwnerColours();
 
 	_screenshot_name[0] = '\0';
 	if (name != NULL) strecpy(_screenshot_name, name, lastof(_screenshot_name));
@@ -980,3 +1158,207 @@ void SaveMinimap(const char *name)
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
 	sf->proc(MakeScreenshotName("minimap", sf->extension), MinimapOwnerCallback, NULL, MapSizeX(), MapSizeY(), 32, _cur_palette.palette);
 }
+
+/** Width and height in pixels of the images of an exported map tile pyramid. */
+static const uint MAP_EXPORT_TILE_SIZE = 256;
+
+/**
+ * State of the export of the map as a pyramid of image tiles, see #ExportMapTiles.
+ * Level 0 has one pixel per map tile, every next level halves the width and height, up to
+ * the level which fits in a single image. The pixels of all levels are kept, so an image
+ * of a level above 0 is made from the level below instead of from the whole map area it covers.
+ */
+struct MapTileExport {
+	uint size_x;                              ///< Width of the map the export was made for.
+	uint size_y;                              ///< Height of the map the export was made for.
+	byte owner_colours[OWNER_END + 1];        ///< Owner colours the export was made with.
+	std::vector<byte> base;                   ///< Palette index of every pixel of level 0.
+	std::vector<std::vector<Colour>> levels;  ///< Pixels of level 1 and up.
+	std::vector<bool> dirty;                  ///< For each image of level 0, whether one of its map tiles changed since the last export.
+
+	/**
+	 * Get the width of a level in pixels.
+	 * @param level The level.
+	 * @return The width.
+	 */
+	uint GetWidth(uint level) const { return CeilDiv(this->size_x, 1 << level); }
+
+	/**
+	 * Get the height of a level in pixels.
+	 * @param level The level.
+	 * @return The height.
+	 */
+	uint GetHeight(uint level) const { return CeilDiv(this->size_y, 1 << level); }
+
+	/**
+	 * Get the number of images in a row of a level.
+	 * @param level The level.
+	 * @return The number of columns.
+	 */
+	uint GetColumns(uint level) const { return CeilDiv(this->GetWidth(level), MAP_EXPORT_TILE_SIZE); }
+
+	/**
+	 * Get the number of images in a column of a level.
+	 * @param level The level.
+	 * @return The number of rows.
+	 */
+	uint GetRows(uint level) const { return CeilDiv(this->GetHeight(level), MAP_EXPORT_TILE_SIZE); }
+
+	/**
+	 * Get the colour of a pixel.
+	 * @param level The level of the pixel.
+	 * @param x The X position of the pixel, less than the width of the level.
+	 * @param y The Y position of the pixel, less than the height of the level.
+	 * @return The colour.
+	 */
+	Colour GetPixel(uint level, uint x, uint y) const
+	{
+		if (level == 0) return _cur_palette.palette[this->base[y * this->size_x + x]];
+		return this->levels[level - 1][y * this->GetWidth(level) + x];
+	}
+};
+
+static MapTileExport _map_tile_export;
+
+/** An image of the map tile pyramid which is being written. */
+struct MapTileExportImage {
+	uint level; ///< Level of the image.
+	uint x;     ///< First pixel column of the image in the level.
+	uint y;     ///< First pixel row of the image in the level.
+};
+
+/**
+ * Callback for writing an image of the map tile pyramid; pixels beyond the edge of the map are black.
+ * @see ScreenshotCallback
+ */
+static void MapTileExportCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	const MapTileExportImage *image = (const MapTileExportImage *)userdata;
+	const MapTileExport &mte = _map_tile_export;
+	uint width = mte.GetWidth(image->level);
+	uint height = mte.GetHeight(image->level);
+
+	Colour *dst = (Colour *)buf;
+	for (uint row = image->y + y; row < image->y + y + n; row++) {
+		for (uint col = image->x; col < image->x + pitch; col++) {
+			*dst++ = (row < height && col < width) ? mte.GetPixel(image->level, col, row) : Colour(0, 0, 0);
+		}
+	}
+}
+
+/**
+ * Invalidate the exported map tile image which shows a map tile.
+ * @param tile The tile that changed.
+ */
+void InvalidateMapTileExportTile(TileIndex tile)
+{
+	MapTileExport &mte = _map_tile_export;
+	if (mte.dirty.empty()) return;
+
+	/* Like the minimap, the X axis of the map runs from right to left. */
+	uint x = MapMaxX() - TileX(tile);
+	uint y = TileY(tile);
+	mte.dirty[(y / MAP_EXPORT_TILE_SIZE) * mte.GetColumns(0) + x / MAP_EXPORT_TILE_SIZE] = true;
+}
+
+/** Drop the state of the map tile export, so the next export writes all images again. */
+void ClearMapTileExport()
+{
+	MapTileExport &mte = _map_tile_export;
+	mte.base.clear();
+	mte.base.shrink_to_fit();
+	mte.levels.clear();
+	mte.dirty.clear();
+}
+
+/**
+ * Export the map as a pyramid of images of #MAP_EXPORT_TILE_SIZE pixels square, coloured by owner
+ * like the minimap, for use in zoomable web maps. The images are written in the screenshot format
+ * to <tt>name/level/column_row.ext</tt> in the screenshot directory, with level 0 having one pixel
+ * per map tile. Only images showing map tiles which changed since the previous export are written
+ * again. No blitter or sprites are needed, so this also works on a dedicated server.
+ * @param name Name of the directory to write to.
+ * @return Number of written images, or -1 when an image could not be written.
+ */
+int ExportMapTiles(const char *name)
+{
+	MapTileExport &mte = _map_tile_export;
+	SetupMinimapOwnerColours();
+
+	if (mte.size_x != MapSizeX() || mte.size_y != MapSizeY() || mte.dirty.empty() || memcmp(mte.owner_colours, _owner_colours, sizeof(_owner_colours)) != 0) {
+		mte.size_x = MapSizeX();
+		mte.size_y = MapSizeY();
+		MemCpyT(mte.owner_colours, _owner_colours, lengthof(_owner_colours));
+		mte.base.resize(MapSize());
+		mte.levels.clear();
+		for (uint level = 1; mte.GetColumns(level - 1) > 1 || mte.GetRows(level - 1) > 1; level++) {
+			mte.levels.emplace_back(mte.GetWidth(level) * mte.GetHeight(level));
+		}
+		mte.dirty.assign(mte.GetColumns(0) * mte.GetRows(0), true);
+	}
+
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	char path[MAX_PATH];
+	seprintf(path, lastof(path), "%s%s", FiosGetScreenshotDir(), name);
+	FioCreateDirectory(path);
+
+	int written = 0;
+	std::vector<bool> dirty = mte.dirty;
+	for (uint level = 0; level <= mte.levels.size(); level++) {
+		uint width = mte.GetWidth(level);
+		uint height = mte.GetHeight(level);
+		uint columns = mte.GetColumns(level);
+
+		seprintf(path, lastof(path), "%s%s" PATHSEP "%u", FiosGetScreenshotDir(), name, level);
+		FioCreateDirectory(path);
+
+		for (uint i = 0; i < dirty.size(); i++) {
+			if (!dirty[i]) continue;
+
+			uint left = (i % columns) * MAP_EXPORT_TILE_SIZE;
+			uint top = (i / columns) * MAP_EXPORT_TILE_SIZE;
+			uint right = min(left + MAP_EXPORT_TILE_SIZE, width);
+			uint bottom = min(top + MAP_EXPORT_TILE_SIZE, height);
+
+			for (uint y = top; y < bottom; y++) {
+				for (uint x = left; x < right; x++) {
+					if (level == 0) {
+						TileIndex tile = TileXY(MapMaxX() - x, y);
+						mte.base[y * width + x] = IsTileType(tile, MP_VOID) ? 0 : GetMinimapOwnerPixels(tile);
+						continue;
+					}
+
+					/* Average the (up to) four pixels of the level below. */
+					uint r = 0, g = 0, b = 0, count = 0;
+					for (uint sy = y * 2; sy < min(y * 2 + 2, mte.GetHeight(level - 1)); sy++) {
+						for (uint sx = x * 2; sx < min(x * 2 + 2, mte.GetWidth(level - 1)); sx++) {
+							Colour c = mte.GetPixel(level - 1, sx, sy);
+							r += c.r;
+							g += c.g;
+							b += c.b;
+							count++;
+						}
+					}
+					mte.levels[level - 1][y * width + x] = Colour(r / count, g / count, b / count);
+				}
+			}
+
+			char filename[MAX_PATH];
+			seprintf(filename, lastof(filename), "%s" PATHSEP "%u_%u.%s", path, i % columns, i / columns, sf->extension);
+			MapTileExportImage image = { level, left, top };
+			if (!sf->proc(filename, MapTileExportCallback, &image, MAP_EXPORT_TILE_SIZE, MAP_EXPORT_TILE_SIZE, 32, _cur_palette.palette)) return -1;
+			written++;
+		}
+
+		/* An image of the next level is dirty when any of the four images it is made of is. */
+		uint next_columns = CeilDiv(columns, 2);
+		std::vector<bool> next(next_columns * CeilDiv(mte.GetRows(level), 2), false);
+		for (uint i = 0; i < dirty.size(); i++) {
+			if (dirty[i]) next[(i / columns / 2) * next_columns + (i % columns) / 2] = true;
+		}
+		dirty.swap(next);
+	}
+
+	mte.dirty.assign(mte.dirty.size(), false);
+	return written;
+}
@@ -12,6 +12,8 @@
 #ifndef SCREENSHOT_H
 #define SCREENSHOT_H
 
+#include "tile_type.h"
+
 void InitializeScreenshotFormats();
 
 const char *GetCurrentScreenshotExtension();
@@ -33,6 +35,9 @@ bool MakeHeightmapScreenshot(const char *filename);
 bool MakeSmallMapScreenshot(unsigned int width, unsigned int height, SmallMapWindow *window);
 bool MakeScreenshot(ScreenshotType t, const char *name);
 void SaveMinimap(const char *name);
+int ExportMapTiles(const char *name);
+void InvalidateMapTileExportTile(TileIndex tile);
+void ClearMapTileExport();
 
 extern char _screenshot_format_name[8];
 extern uint _num_screenshot_formats;
@@ -461,6 +461,8 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 {
 	assert(IsValidDiagDirection(enterdir));
 
+	PerformanceZoneMeasurer zone(PFZ_SHIP_PATHFINDER);
+
 	bool path_found = true;
 	Track track;
 	switch (_settings_game.pf.pathfinder_for_ships) {
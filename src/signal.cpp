@@ -22,6 +22,7 @@
 #include "programmable_signals.h"
 #include "error.h"
 #include "infrastructure_func.h"
+#include "framerate_type.h"
 
 #include "safeguards.h"
 
@@ -612,6 +613,8 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 {
 	assert(Company::IsValidID(owner));
 
+	PerformanceZoneMeasurer zone(PFZ_SIGNALS);
+
 	bool first = true;  // first block?
 	SigSegState state = SIGSEG_FREE; // value to return
 	_num_signals_evaluated = 0;
@@ -31,6 +31,8 @@
 #include "table/strings.h"
 
 #include <bitset>
+#include <map>
+#include <memory>
 
 #include "safeguards.h"
 
@@ -162,6 +164,105 @@ static bool _smallmap_industry_highlight_state;
 /** For connecting company ID to position in owner list (small map legend) */
 uint _company_to_list_pos[MAX_COMPANIES];
 
+static const uint SMALLMAP_CACHE_CHUNK_BITS = 5;                              ///< Number of bits of the width and height in cells of a chunk of the smallmap cache.
+static const uint SMALLMAP_CACHE_CHUNK_SIZE = 1 << SMALLMAP_CACHE_CHUNK_BITS; ///< Width and height in cells of a chunk of the smallmap cache.
+static const uint SMALLMAP_CACHE_MAX_CHUNKS = 4096;                           ///< Number of cached chunks at which the smallmap cache is discarded.
+static const uint SMALLMAP_CACHE_MAP_TYPES  = 8;                              ///< Number of map types which can be cached.
+static const uint SMALLMAP_CACHE_MAX_ZOOM   = 8;                              ///< Highest zoom level of the smallmap which can be cached.
+
+/**
+ * Colours of a square of cells of the smallmap, a cell being the area of tiles shown by one group of four pixels.
+ * The colours of a cell are only determined again after one of its tiles has been marked dirty.
+ */
+struct SmallMapCacheChunk {
+	uint32 colours[SMALLMAP_CACHE_CHUNK_SIZE * SMALLMAP_CACHE_CHUNK_SIZE];    ///< Colours of the cells, see #SmallMapWindow::GetTileColours.
+	uint64 dirty[SMALLMAP_CACHE_CHUNK_SIZE * SMALLMAP_CACHE_CHUNK_SIZE / 64]; ///< Bit set for each cell whose colours have to be determined.
+};
+
+/** Cached chunks of the smallmap, see #GetSmallMapCacheKey. */
+static std::map<uint64, std::unique_ptr<SmallMapCacheChunk>> _smallmap_cache;
+/** For each map type and zoom level, a bit for each offset of the cells (bit y * 8 + x) of which chunks are cached. */
+static uint64 _smallmap_cache_offsets[SMALLMAP_CACHE_MAP_TYPES][SMALLMAP_CACHE_MAX_ZOOM + 1];
+static uint32 _smallmap_cache_state = 0;                  ///< Settings and legends the cache was filled with, see #GetSmallMapCacheState.
+static uint64 _smallmap_cache_last_key = 0;               ///< Key of the chunk used last.
+static SmallMapCacheChunk *_smallmap_cache_last_chunk = NULL; ///< Chunk used last, or \c NULL.
+
+/**
+ * Get the key of a chunk of the smallmap cache.
+ * The cells of the smallmap start at tiles which are a multiple of the zoom level apart, so which
+ * cells are shown depends on the offset of their first tile modulo the zoom level. Chunks for
+ * different offsets are cached side by side, so scrolling does not invalidate anything.
+ * @param map_type Map type of the chunk.
+ * @param zoom Zoom level of the chunk.
+ * @param offs_x X coordinate of the first tile of the cells modulo the zoom level.
+ * @param offs_y Y coordinate of the first tile of the cells modulo the zoom level.
+ * @param cx X coordinate of the first tile of a cell divided by the zoom level.
+ * @param cy Y coordinate of the first tile of a cell divided by the zoom level.
+ * @return Key of the chunk containing the cell.
+ */
+static inline uint64 GetSmallMapCacheKey(uint map_type, uint zoom, uint offs_x, uint offs_y, uint cx, uint cy)
+{
+	return (uint64)map_type << 56 | (uint64)zoom << 48 | (uint64)offs_x << 44 | (uint64)offs_y << 40 |
+			(uint64)(cx >> SMALLMAP_CACHE_CHUNK_BITS) << 20 | (cy >> SMALLMAP_CACHE_CHUNK_BITS);
+}
+
+/**
+ * Get a hash of the settings and legends which influence the colours of the smallmap.
+ * @return The hash.
+ */
+static uint32 GetSmallMapCacheState()
+{
+	uint32 state = (_smallmap_show_heightmap ? 1 : 0) | (_settings_client.gui.smallmap_land_colour << 1) |
+			(_settings_game.construction.max_heightlevel << 8);
+	if (_smallmap_industry_highlight != INVALID_INDUSTRYTYPE) {
+		state ^= (_smallmap_industry_highlight << 1 | (_smallmap_industry_highlight_state ? 1 : 0)) << 16;
+	}
+	for (const LegendAndColour &lc : _legend_land_owners) state = state * 31 + (lc.colour << 1 | lc.show_on_map);
+	for (const LegendAndColour &lc : _legend_from_industries) state = state * 31 + lc.show_on_map;
+	return state * 31 + MapSize();
+}
+
+/** Discard the cached colours of the smallmap. */
+void ClearSmallMapCache()
+{
+	_smallmap_cache.clear();
+	MemSetT(&_smallmap_cache_offsets, 0);
+	_smallmap_cache_last_chunk = NULL;
+}
+
+/**
+ * Mark the cached colours of the smallmap cells containing a tile as dirty.
+ * @param tile The tile that changed.
+ */
+void InvalidateSmallMapCacheTile(TileIndex tile)
+{
+	if (_smallmap_cache.empty()) return;
+
+	const uint x = TileX(tile);
+	const uint y = TileY(tile);
+	for (uint map_type = 0; map_type < SMALLMAP_CACHE_MAP_TYPES; map_type++) {
+		for (uint zoom = 1; zoom <= SMALLMAP_CACHE_MAX_ZOOM; zoom++) {
+			const uint64 offsets = _smallmap_cache_offsets[map_type][zoom];
+			if (offsets == 0) continue;
+
+			for (uint offs_y = 0; offs_y < zoom && offs_y <= y; offs_y++) {
+				for (uint offs_x = 0; offs_x < zoom && offs_x <= x; offs_x++) {
+					if (!HasBit(offsets, offs_y * 8 + offs_x)) continue;
+
+					/* Cells starting left or above the map are never drawn, so those need no checks. */
+					const uint cx = (x - offs_x) / zoom;
+					const uint cy = (y - offs_y) / zoom;
+					const auto it = _smallmap_cache.find(GetSmallMapCacheKey(map_type, zoom, offs_x, offs_y, cx, cy));
+					if (it == _smallmap_cache.end()) continue;
+
+					const uint index = (cy % SMALLMAP_CACHE_CHUNK_SIZE) * SMALLMAP_CACHE_CHUNK_SIZE + cx % SMALLMAP_CACHE_CHUNK_SIZE;
+					SetBit(it->second->dirty[index / 64], index % 64);
+				}
+			}
+		}
+	}
+}
+
 /**
  * Fills an array for the industries legends.
  */
@@ -705,6 +806,48 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
 	}
 }
 
+/**
+ * Get the colours of a cell of the smallmap from the cache, determining them again only when one of its tiles changed.
+ * @param xc The X coordinate of the first tile of the cell.
+ * @param yc The Y coordinate of the first tile of the cell.
+ * @param ta Tile area of the cell.
+ * @return Colours to display.
+ */
+inline uint32 SmallMapWindow::GetCachedTileColours(uint xc, uint yc, const TileArea &ta) const
+{
+	assert_compile(SMT_OWNER < SMALLMAP_CACHE_MAP_TYPES);
+	if (this->zoom > (int)SMALLMAP_CACHE_MAX_ZOOM) return this->GetTileColours(ta);
+
+	const uint offs_x = xc % this->zoom;
+	const uint offs_y = yc % this->zoom;
+	const uint cx = xc / this->zoom;
+	const uint cy = yc / this->zoom;
+	const uint64 key = GetSmallMapCacheKey(this->map_type, this->zoom, offs_x, offs_y, cx, cy);
+
+	SmallMapCacheChunk *chunk = _smallmap_cache_last_chunk;
+	if (chunk == NULL || key != _smallmap_cache_last_key) {
+		const auto it = _smallmap_cache.find(key);
+		if (it != _smallmap_cache.end()) {
+			chunk = it->second.get();
+		} else {
+			if (_smallmap_cache.size() >= SMALLMAP_CACHE_MAX_CHUNKS) ClearSmallMapCache();
+			chunk = new SmallMapCacheChunk();
+			MemSetT(chunk->dirty, 0xFF, lengthof(chunk->dirty));
+			_smallmap_cache.emplace(key, std::unique_ptr<SmallMapCacheChunk>(chunk));
+			SetBit(_smallmap_cache_offsets[this->map_type][this->zoom], offs_y * 8 + offs_x);
+		}
+		_smallmap_cache_last_key = key;
+		_smallmap_cache_last_chunk = chunk;
+	}
+
+	const uint index = (cy % SMALLMAP_CACHE_CHUNK_SIZE) * SMALLMAP_CACHE_CHUNK_SIZE + cx % SMALLMAP_CACHE_CHUNK_SIZE;
+	if (HasBit(chunk->dirty[index / 64], index % 64)) {
+		chunk->colours[index] = this->GetTileColours(ta);
+		ClrBit(chunk->dirty[index / 64], index % 64);
+	}
+	return chunk->colours[index];
+}
+
 /**
  * Draws one column of tiles of the small map in a certain mode onto the screen buffer, skipping the shifted rows in between.
  *
@@ -742,7 +885,7 @@ void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch,
 		}
 		ta.ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
 
-		uint32 val = this->GetTileColours(ta);
+		uint32 val = this->GetCachedTileColours(xc, yc, ta);
 		uint8 *val8 = (uint8 *)&val;
 		int idx = max(0, -start_pos);
 		for (int pos = max(0, start_pos); pos < end_pos; pos++) {
@@ -848,8 +991,8 @@ void SmallMapWindow::DrawMapIndicators() const
  * Basically, the small map is draw column of pixels by column of pixels. The pixels
  * are drawn directly into the screen buffer. The final map is drawn in multiple passes.
  * The passes are:
- * <ol><li>The colours of tiles in the different modes.</li>
- * <li>Town names (optional)</li></ol>
+ * <ol><li>The colours of tiles in the different modes, taken from the cache where the tiles did not change.</li>
+ * <li>Vehicles, link stats and town names (optional)</li></ol>
  *
  * @param dpi pointer to pixel to write onto
  */
@@ -864,6 +1007,13 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi, bool draw_indicators) cons
 	/* Clear it */
 	GfxFillRect(dpi->left, dpi->top, dpi->left + dpi->width - 1, dpi->top + dpi->height - 1, PC_BLACK);
 
+	/* Discard the cached colours when they were determined with other settings or legends. */
+	const uint32 cache_state = GetSmallMapCacheState();
+	if (cache_state != _smallmap_cache_state) {
+		ClearSmallMapCache();
+		_smallmap_cache_state = cache_state;
+	}
+
 	/* Which tile is displayed at (dpi->left, dpi->top)? */
 	int dx;
 	Point tile = this->PixelToTile(dpi->left, dpi->top, &dx);
@@ -1437,6 +1587,9 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 {
 	if (!gui_scope) return;
 
+	/* Ownership or industries may have changed without marking all their tiles dirty. */
+	ClearSmallMapCache();
+
 	switch (data) {
 		case 1:
 			/* The owner legend has already been rebuilt. */
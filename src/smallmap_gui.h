@@ -51,6 +51,8 @@ void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
 void BuildOwnerLegend();
+void ClearSmallMapCache();
+void InvalidateSmallMapCacheTile(TileIndex tile);
 
 /** Structure for holding relevant data for legends in small map */
 struct LegendAndColour {
@@ -190,6 +192,7 @@ protected:
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
 	uint32 GetTileColours(const TileArea &ta) const;
+	uint32 GetCachedTileColours(uint xc, uint yc, const TileArea &ta) const;
 
 	int GetPositionOnLegend(Point pt);
 
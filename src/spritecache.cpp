@@ -11,6 +11,7 @@
 
 #include "stdafx.h"
 #include "fileio_func.h"
+#include "fios.h"
 #include "spriteloader/grf.hpp"
 #include "gfx_func.h"
 #include "error.h"
@@ -20,6 +21,7 @@
 #include "core/alloc_func.hpp"
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
+#include "thread/thread.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -28,6 +30,7 @@
 #include "3rdparty/cpp-btree/btree_map.h"
 
 #include <vector>
+#include <deque>
 #include <algorithm>
 
 #include "safeguards.h"
@@ -56,6 +59,19 @@ public:
 		_spritecache_bytes_used += this->size;
 	}
 
+	/**
+	 * Take ownership of already allocated memory.
+	 * @param ptr Memory allocated with malloc.
+	 * @param size Size of the memory.
+	 */
+	void Adopt(void *ptr, uint32 size)
+	{
+		this->Clear();
+		this->ptr = ptr;
+		this->size = size;
+		_spritecache_bytes_used += this->size;
+	}
+
 	void Clear()
 	{
 		_spritecache_bytes_used -= this->size;
@@ -93,10 +109,12 @@ PACK_N(struct SpriteCache {
 	size_t file_pos;
 	SpriteDataBuffer buffer;
 	uint32 id;
-	uint32 lru;
+	uint32 clock_index;      ///< Position in #_sprite_clock, if the sprite is cached and not a recolour sprite.
 	uint16 file_slot;
-	SpriteType type : 7; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
+	SpriteType type : 5; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned : 1;         ///< True iff the user has been warned about incorrect use of this sprite
+	bool prefetch : 1;       ///< True iff the sprite is being decoded in the background, see #PrefetchSprite
+	bool referenced : 1;     ///< True iff the sprite has been used since the clock hand last passed it
 	byte container_ver;      ///< Container version of the GRF the sprite is from.
 
 	void *GetPtr() { return this->buffer.GetPtr(); }
@@ -125,9 +143,20 @@ static SpriteCache *AllocateSpriteCache(uint index)
 	return GetSpriteCache(index);
 }
 
-static uint32 _sprite_lru_counter;
+static std::vector<SpriteID> _sprite_clock; ///< All cached sprites which may be evicted, in the order the clock hand visits them.
+static size_t _sprite_clock_hand;           ///< Index in #_sprite_clock of the next sprite to consider for eviction.
+
+/** Statistics of the sprite cache, see #DumpSpriteCacheStats. */
+static struct SpriteCacheStats {
+	uint64 hits;                             ///< Number of requests for a sprite which was cached.
+	uint64 misses;                           ///< Number of requests for a sprite which had to be loaded.
+	uint64 evictions;                        ///< Number of sprites removed from the cache to make room.
+	uint64 evicted_bytes;                    ///< Number of bytes freed by evicting sprites.
+	uint32 evictions_per_slot[MAX_FILE_SLOTS]; ///< Number of evicted sprites per file slot.
+} _sprite_cache_stats;
 
 static void *AllocSprite(size_t mem_req);
+static void DeleteEntryFromSpriteCache(uint item);
 
 /**
  * Skip the given amount of sprite graphics data.
@@ -430,6 +459,57 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
 	return dest;
 }
 
+/**
+ * Load all available zoom levels of a sprite from disk.
+ * The 32bpp version of the sprite is preferred when the blitter supports it.
+ * @param[out] sprite      Filled with the sprite image data of each zoom level.
+ * @param file_slot        GRF to load from.
+ * @param file_pos         Position of the sprite in the GRF.
+ * @param container_ver    Container version of the GRF.
+ * @param sprite_type      Type of sprite.
+ * @return Bit mask of the zoom levels which were loaded, 0 on failure.
+ */
+static uint8 LoadSpriteZoomLevels(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, byte container_ver, SpriteType sprite_type)
+{
+	uint8 sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
+
+	SpriteLoaderGrf sprite_loader(container_ver);
+	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
+	}
+	return sprite_avail;
+}
+
+/**
+ * Create the missing zoom levels of a loaded sprite and encode it for the current blitter.
+ * @param sprite       Sprite image data of each zoom level.
+ * @param sprite_avail Bit mask of the zoom levels which were loaded.
+ * @param file_slot    GRF the sprite was loaded from.
+ * @param file_id      Sprite number in the GRF.
+ * @param allocator    Allocator function to use.
+ * @return Encoded sprite, or NULL if the missing zoom levels could not be created.
+ */
+static void *EncodeSprite(SpriteLoader::Sprite *sprite, uint8 sprite_avail, uint file_slot, uint32 file_id, AllocatorProc *allocator)
+{
+	if (!ResizeSprites(sprite, sprite_avail, file_slot, file_id)) return NULL;
+
+	if (sprite->type == ST_FONT && ZOOM_LVL_GUI != ZOOM_LVL_NORMAL) {
+		/* Make ZOOM_LVL_GUI be ZOOM_LVL_NORMAL */
+		sprite[ZOOM_LVL_NORMAL].width  = sprite[ZOOM_LVL_GUI].width;
+		sprite[ZOOM_LVL_NORMAL].height = sprite[ZOOM_LVL_GUI].height;
+		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[ZOOM_LVL_GUI].x_offs;
+		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[ZOOM_LVL_GUI].y_offs;
+		sprite[ZOOM_LVL_NORMAL].data   = sprite[ZOOM_LVL_GUI].data;
+	}
+
+	return BlitterFactory::GetCurrentBlitter()->Encode(sprite, allocator);
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -440,9 +520,6 @@ static void *ReadRecolourSprite(uint16 file_slot, uint num)
  */
 static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_type, AllocatorProc *allocator)
 {
-	uint file_slot = sc->file_slot;
-	size_t file_pos = sc->file_pos;
-
 	assert(sprite_type != ST_RECOLOUR);
 	assert(IsMapgenSpriteID(id) == (sprite_type == ST_MAPGEN));
 	assert(sc->type == sprite_type);
@@ -450,17 +527,7 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 	DEBUG(sprite, 9, "Load sprite %d", id);
 
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
-	uint8 sprite_avail = 0;
-	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
-
-	SpriteLoaderGrf sprite_loader(sc->container_ver);
-	if (sprite_type != ST_MAPGEN && BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, true);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file_slot, file_pos, sprite_type, false);
-	}
+	uint8 sprite_avail = LoadSpriteZoomLevels(sprite, sc->file_slot, sc->file_pos, sc->container_ver, sprite_type);
 
 	if (sprite_avail == 0) {
 		if (sprite_type == ST_MAPGEN) return NULL;
@@ -496,24 +563,15 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		return s;
 	}
 
-	if (!ResizeSprites(sprite, sprite_avail, file_slot, sc->id)) {
+	void *data = EncodeSprite(sprite, sprite_avail, sc->file_slot, sc->id, allocator);
+	if (data == NULL) {
 		if (id == SPR_IMG_QUERY) usererror("Okay... something went horribly wrong. I couldn't resize the fallback sprite. What should I do?");
 		return (void*)GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, allocator);
 	}
 
-	if (sprite->type == ST_FONT && ZOOM_LVL_GUI != ZOOM_LVL_NORMAL) {
-		/* Make ZOOM_LVL_GUI be ZOOM_LVL_NORMAL */
-		sprite[ZOOM_LVL_NORMAL].width  = sprite[ZOOM_LVL_GUI].width;
-		sprite[ZOOM_LVL_NORMAL].height = sprite[ZOOM_LVL_GUI].height;
-		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[ZOOM_LVL_GUI].x_offs;
-		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[ZOOM_LVL_GUI].y_offs;
-		sprite[ZOOM_LVL_NORMAL].data   = sprite[ZOOM_LVL_GUI].data;
-	}
-
-	return BlitterFactory::GetCurrentBlitter()->Encode(sprite, allocator);
+	return data;
 }
 
-
 /** Map from sprite numbers to position in the GRF file. */
 static btree::btree_map<uint32, size_t> _grf_sprite_offsets;
 
@@ -615,16 +673,19 @@ bool LoadNextSprite(int load_index, byte file_slot, uint file_sprite_id, byte co
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	/* Drop the cached version of the sprite this one replaces. */
+	if (sc->type != ST_RECOLOUR && sc->GetPtr() != NULL) DeleteEntryFromSpriteCache(load_index);
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	if (data != nullptr) {
 		assert(data == _last_sprite_allocation.GetPtr());
 		sc->buffer = std::move(_last_sprite_allocation);
 	}
-	sc->lru = 0;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
+	sc->prefetch = false;
+	sc->referenced = false;
 	sc->container_ver = container_version;
 
 	return true;
@@ -636,11 +697,14 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	if (scnew->type != ST_RECOLOUR && scnew->GetPtr() != NULL) DeleteEntryFromSpriteCache(new_spr);
 	scnew->file_slot = scold->file_slot;
 	scnew->file_pos = scold->file_pos;
 	scnew->id = scold->id;
 	scnew->type = scold->type;
 	scnew->warned = false;
+	scnew->prefetch = false;
+	scnew->referenced = false;
 	scnew->container_ver = scold->container_ver;
 }
 
@@ -649,98 +713,141 @@ static size_t GetSpriteCacheUsage()
 	return _spritecache_bytes_used;
 }
 
+/**
+ * Add a sprite which just got cached to the eviction clock.
+ * It is placed right behind the clock hand, so it is the last to be considered for eviction.
+ * @param sprite The sprite.
+ * @param referenced Whether the sprite is in use; if not, it is evicted the first time the clock hand passes it.
+ */
+static void AddSpriteToClock(SpriteID sprite, bool referenced)
+{
+	SpriteCache *sc = GetSpriteCache(sprite);
+	sc->referenced = referenced;
+	sc->clock_index = (uint32)_sprite_clock.size();
+	_sprite_clock.push_back(sprite);
+
+	if (_sprite_clock_hand + 1 < _sprite_clock.size()) {
+		/* Swap with the sprite under the hand and move the hand past the new sprite. */
+		SpriteID other = _sprite_clock[_sprite_clock_hand];
+		_sprite_clock[_sprite_clock_hand] = sprite;
+		_sprite_clock.back() = other;
+		GetSpriteCache(other)->clock_index = sc->clock_index;
+		sc->clock_index = (uint32)_sprite_clock_hand;
+		_sprite_clock_hand++;
+	}
+}
+
 /**
  * Delete a single entry from the sprite cache.
  * @param item Entry to delete.
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	GetSpriteCache(item)->buffer.Clear();
+	SpriteCache *sc = GetSpriteCache(item);
+	sc->buffer.Clear();
+
+	/* Fill the hole in the clock with the last sprite. */
+	SpriteID last = _sprite_clock.back();
+	_sprite_clock[sc->clock_index] = last;
+	GetSpriteCache(last)->clock_index = sc->clock_index;
+	_sprite_clock.pop_back();
+	if (_sprite_clock_hand >= _sprite_clock.size()) _sprite_clock_hand = 0;
 }
 
+/**
+ * Evict sprites from the sprite cache with the clock algorithm.
+ * The hand sweeps over the cached sprites; a sprite which has been used since the last sweep gets
+ * another chance, any other sprite is removed. Every sprite is thus visited at most twice.
+ * @param target Number of bytes to free.
+ */
 static void DeleteEntriesFromSpriteCache(size_t target)
 {
 	const size_t initial_in_use = GetSpriteCacheUsage();
-
-	struct SpriteInfo {
-		uint32 lru;
-		SpriteID id;
-		uint32 size;
-
-		bool operator<(const SpriteInfo &other) const
-		{
-			return this->lru < other.lru;
+	size_t freed = 0;
+	uint deleted = 0;
+
+	while (freed < target && !_sprite_clock.empty()) {
+		SpriteID sprite = _sprite_clock[_sprite_clock_hand];
+		SpriteCache *sc = GetSpriteCache(sprite);
+		if (sc->referenced) {
+			sc->referenced = false;
+			if (++_sprite_clock_hand == _sprite_clock.size()) _sprite_clock_hand = 0;
+			continue;
 		}
-	};
-	std::vector<SpriteInfo> candidates;
-	size_t candidate_bytes = 0;
 
-	auto push = [&](SpriteInfo info) {
-		candidates.push_back(info);
-		std::push_heap(candidates.begin(), candidates.end());
-		candidate_bytes += info.size;
-	};
-
-	auto pop = [&]() {
-		candidate_bytes -= candidates.front().size;
-		std::pop_heap(candidates.begin(), candidates.end());
-		candidates.pop_back();
-	};
-
-	SpriteID i = 0;
-	for (; i != _spritecache.size() && candidate_bytes < target; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->GetPtr() != NULL) {
-			push({ sc->lru, i, sc->buffer.GetSize() });
-			if (candidate_bytes >= target) break;
-		}
-	}
-	for (; i != _spritecache.size(); i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->GetPtr() != NULL && sc->lru <= candidates.front().lru) {
-			push({ sc->lru, i, sc->buffer.GetSize() });
-			while (!candidates.empty() && candidate_bytes - candidates.front().size >= target) {
-				pop();
-			}
-		}
+		/* The last sprite takes its place in the clock, so the hand need not move. */
+		freed += sc->buffer.GetSize();
+		_sprite_cache_stats.evictions_per_slot[sc->file_slot]++;
+		DeleteEntryFromSpriteCache(sprite);
+		deleted++;
 	}
 
-	for (auto &it : candidates) {
-		DeleteEntryFromSpriteCache(it.id);
-	}
+	_sprite_cache_stats.evictions += deleted;
+	_sprite_cache_stats.evicted_bytes += freed;
 
-	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: " PRINTF_SIZE ", freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", delta: " PRINTF_SIZE ", requested: " PRINTF_SIZE,
-			candidates.size(), candidate_bytes, initial_in_use, GetSpriteCacheUsage(), initial_in_use - GetSpriteCacheUsage(), target);
+	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: %u, freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", requested: " PRINTF_SIZE,
+			deleted, freed, initial_in_use, GetSpriteCacheUsage(), target);
 }
 
-void IncreaseSpriteLRU()
+/**
+ * Get the number of bytes the sprite cache may use for the current blitter.
+ * @return The target size of the sprite cache.
+ */
+static size_t GetSpriteCacheTargetSize()
 {
 	int bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
-	uint target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
+	return (size_t)(bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
+}
+
+/**
+ * Shrink the sprite cache when it uses more memory than allowed.
+ * Sprites are only evicted here, so pointers returned by #GetRawSprite stay valid until the next call.
+ */
+void CheckSpriteCacheSize()
+{
+	size_t target_size = GetSpriteCacheTargetSize();
 	if (_spritecache_bytes_used > target_size) {
 		DeleteEntriesFromSpriteCache(_spritecache_bytes_used - target_size + 512 * 1024);
 	}
+}
 
-	/* Increase all LRU values */
-	if (_sprite_lru_counter >= 0xC0000000) {
-		SpriteID i;
-
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Write the statistics of the sprite cache, with the memory usage and evictions per GRF file.
+ * @param buffer Buffer to write to.
+ * @param last Last character of the buffer.
+ */
+void DumpSpriteCacheStats(char *buffer, const char *last)
+{
+	size_t bytes[MAX_FILE_SLOTS] = {};
+	uint sprites[MAX_FILE_SLOTS] = {};
+	for (SpriteCache &sc : _spritecache) {
+		if (sc.buffer.GetPtr() == NULL) continue;
+		bytes[sc.file_slot] += sc.buffer.GetSize();
+		sprites[sc.file_slot]++;
+	}
 
-		for (i = 0; i != _spritecache.size(); i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->GetPtr() != NULL) {
-				if (sc->lru > 0x80000000) {
-					sc->lru -= 0x80000000;
-				} else {
-					sc->lru = 0;
-				}
-			}
-		}
-		_sprite_lru_counter -= 0x80000000;
+	const SpriteCacheStats &stats = _sprite_cache_stats;
+	uint64 requests = stats.hits + stats.misses;
+	buffer += seprintf(buffer, last, "Sprite cache: " PRINTF_SIZE " KiB in use of " PRINTF_SIZE " KiB, " PRINTF_SIZE " evictable sprites\n",
+			GetSpriteCacheUsage() / 1024, GetSpriteCacheTargetSize() / 1024, _sprite_clock.size());
+	buffer += seprintf(buffer, last, "Requests: " OTTD_PRINTF64 ", hits: " OTTD_PRINTF64 ", misses: " OTTD_PRINTF64 ", hit rate: %.1f%%\n",
+			requests, stats.hits, stats.misses, requests == 0 ? 0.0 : 100.0 * stats.hits / requests);
+	buffer += seprintf(buffer, last, "Evictions: " OTTD_PRINTF64 " sprites, " OTTD_PRINTF64 " KiB\n", stats.evictions, stats.evicted_bytes / 1024);
+
+	for (uint slot = 0; slot < MAX_FILE_SLOTS; slot++) {
+		if (sprites[slot] == 0 && stats.evictions_per_slot[slot] == 0) continue;
+		const char *name = FioGetFilename(slot);
+		buffer += seprintf(buffer, last, "  %3u %-32s %6u sprites, %8u KiB, %8u evictions\n",
+				slot, name != NULL ? name : "-", sprites[slot], (uint)(bytes[slot] / 1024), stats.evictions_per_slot[slot]);
 	}
 }
 
+/** Reset the statistics of the sprite cache. */
+void ResetSpriteCacheStats()
+{
+	MemSetT(&_sprite_cache_stats, 0);
+}
+
 static void *AllocSprite(size_t mem_req)
 {
 	assert(_last_sprite_allocation.GetPtr() == nullptr);
@@ -820,14 +927,16 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	if (allocator == NULL) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
-
 		/* Load the sprite, if it is not loaded, yet */
 		if (sc->GetPtr() == NULL) {
+			_sprite_cache_stats.misses++;
 			void *ptr = ReadSprite(sc, sprite, type, AllocSprite);
 			assert(ptr == _last_sprite_allocation.GetPtr());
 			sc->buffer = std::move(_last_sprite_allocation);
+			if (type != ST_RECOLOUR) AddSpriteToClock(sprite, true);
+		} else {
+			_sprite_cache_stats.hits++;
+			sc->referenced = true;
 		}
 
 		return sc->GetPtr();
@@ -837,6 +946,217 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	}
 }
 
+/** A sprite to decode in the background, see #PrefetchSprite. */
+struct SpritePrefetchJob {
+	SpriteID sprite;     ///< The sprite to decode.
+	size_t file_pos;     ///< Position of the sprite in the GRF.
+	uint32 file_id;      ///< Sprite number in the GRF.
+	uint16 file_slot;    ///< GRF the sprite is in.
+	byte container_ver;  ///< Container version of the GRF.
+	void *data;          ///< The encoded sprite, or NULL if it could not be decoded.
+	uint32 size;         ///< Size of the encoded sprite.
+	SpriteLoaderWarnings warnings; ///< Warnings found while decoding, shown by the main thread when the sprite is published.
+};
+
+/** Maximum number of sprites waiting to be decoded or published. */
+static const uint MAX_SPRITE_PREFETCHES = 256;
+
+static ThreadObject *_sprite_prefetch_thread = NULL;       ///< Thread decoding the prefetched sprites.
+static ThreadMutex *_sprite_prefetch_mutex = NULL;         ///< Mutex protecting the queues shared with the prefetch thread.
+static bool _sprite_prefetch_disabled = false;             ///< Whether no prefetch thread can or should be started.
+static bool _sprite_prefetch_exit = false;                 ///< Whether the prefetch thread should stop; protected by the mutex.
+static std::deque<SpritePrefetchJob> _sprite_prefetch_queue;  ///< Sprites waiting to be decoded; protected by the mutex.
+static std::vector<SpritePrefetchJob> _sprite_prefetch_done;  ///< Decoded sprites waiting to be published; protected by the mutex.
+static std::vector<SpritePrefetchJob> _sprite_prefetch_new;   ///< Sprites requested during this tick; main thread only.
+static uint _sprite_prefetch_count = 0;                    ///< Number of sprites requested but not yet published; main thread only.
+
+static void *_sprite_prefetch_allocation = NULL;           ///< Last allocation of the prefetch thread.
+static uint32 _sprite_prefetch_allocation_size = 0;        ///< Size of the last allocation of the prefetch thread.
+
+/**
+ * Allocator of the prefetch thread; the sprite cache itself may only be touched by the main thread.
+ * @param mem_req Size of the sprite.
+ * @return The allocated memory.
+ */
+static void *AllocPrefetchedSprite(size_t mem_req)
+{
+	assert(_sprite_prefetch_allocation == NULL);
+	_sprite_prefetch_allocation = MallocT<byte>(mem_req);
+	_sprite_prefetch_allocation_size = (uint32)mem_req;
+	return _sprite_prefetch_allocation;
+}
+
+/**
+ * Decode a sprite for the prefetch thread.
+ * @param job The sprite to decode, receives the encoded sprite.
+ */
+static void DecodePrefetchedSprite(SpritePrefetchJob *job)
+{
+	job->data = NULL;
+	job->size = 0;
+
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
+	SetSpriteLoaderWarningQueue(&job->warnings);
+	uint8 sprite_avail = LoadSpriteZoomLevels(sprite, job->file_slot, job->file_pos, job->container_ver, ST_NORMAL);
+	SetSpriteLoaderWarningQueue(NULL);
+	/* Sprites which fail to load are left to the main thread, which takes care of the fallback and finds the same warnings. */
+	if (sprite_avail == 0) {
+		job->warnings.clear();
+		return;
+	}
+
+	if (EncodeSprite(sprite, sprite_avail, job->file_slot, job->file_id, AllocPrefetchedSprite) == NULL) return;
+
+	job->data = _sprite_prefetch_allocation;
+	job->size = _sprite_prefetch_allocation_size;
+	_sprite_prefetch_allocation = NULL;
+}
+
+/**
+ * Main loop of the prefetch thread.
+ * It reads the GRFs with its own file handles, see #FioCreateThreadFiles.
+ */
+static void SpritePrefetchThread(void *)
+{
+	FioCreateThreadFiles();
+
+	_sprite_prefetch_mutex->BeginCritical();
+	for (;;) {
+		while (_sprite_prefetch_queue.empty() && !_sprite_prefetch_exit) _sprite_prefetch_mutex->WaitForSignal();
+		if (_sprite_prefetch_exit) break;
+
+		SpritePrefetchJob job = std::move(_sprite_prefetch_queue.front());
+		_sprite_prefetch_queue.pop_front();
+		_sprite_prefetch_mutex->EndCritical();
+
+		DecodePrefetchedSprite(&job);
+
+		_sprite_prefetch_mutex->BeginCritical();
+		_sprite_prefetch_done.push_back(std::move(job));
+	}
+	_sprite_prefetch_mutex->EndCritical();
+
+	FioCloseThreadFiles();
+}
+
+/**
+ * Start the prefetch thread, if it is not running yet.
+ * @return True if the prefetch thread is running.
+ */
+static bool StartSpritePrefetch()
+{
+	if (_sprite_prefetch_thread != NULL) return true;
+	if (_sprite_prefetch_disabled) return false;
+
+	/* With a single core the decoding would only take time away from the game. */
+	if (GetCPUCoreCount() <= 1) {
+		_sprite_prefetch_disabled = true;
+		return false;
+	}
+
+	if (_sprite_prefetch_mutex == NULL) _sprite_prefetch_mutex = ThreadMutex::New();
+	_sprite_prefetch_exit = false;
+	if (!ThreadObject::New(&SpritePrefetchThread, NULL, &_sprite_prefetch_thread, "ottd:sprites")) {
+		DEBUG(sprite, 1, "Could not start sprite prefetch thread");
+		_sprite_prefetch_thread = NULL;
+		_sprite_prefetch_disabled = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Request a sprite to be decoded in the background, because it is likely to be drawn soon.
+ * The request is handed to the prefetch thread by #ProcessSpritePrefetches.
+ * Only normal sprites which are not cached yet are decoded; everything else is ignored.
+ * @param sprite The sprite to decode.
+ */
+void PrefetchSprite(SpriteID sprite)
+{
+	if (sprite == 0 || !SpriteExists(sprite)) return;
+
+	SpriteCache *sc = GetSpriteCache(sprite);
+	if (sc->type != ST_NORMAL || sc->prefetch || sc->GetPtr() != NULL) return;
+	if (_sprite_prefetch_count >= MAX_SPRITE_PREFETCHES) return;
+	if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 0) return;
+	if (!StartSpritePrefetch()) return;
+
+	sc->prefetch = true;
+	_sprite_prefetch_count++;
+	_sprite_prefetch_new.push_back({ sprite, sc->file_pos, sc->id, sc->file_slot, sc->container_ver, NULL, 0, SpriteLoaderWarnings() });
+}
+
+/**
+ * Hand the requested sprites to the prefetch thread, and publish the sprites it has decoded into the sprite cache.
+ * The main thread never waits for the prefetch thread: a sprite which is drawn before it is
+ * published is simply decoded by the main thread, and the background result is dropped.
+ */
+void ProcessSpritePrefetches()
+{
+	if (_sprite_prefetch_thread == NULL) return;
+
+	static std::vector<SpritePrefetchJob> done;
+	assert(done.empty());
+
+	_sprite_prefetch_mutex->BeginCritical();
+	if (!_sprite_prefetch_new.empty()) {
+		_sprite_prefetch_queue.insert(_sprite_prefetch_queue.end(), _sprite_prefetch_new.begin(), _sprite_prefetch_new.end());
+		_sprite_prefetch_mutex->SendSignal();
+	}
+	done.swap(_sprite_prefetch_done);
+	_sprite_prefetch_mutex->EndCritical();
+	_sprite_prefetch_new.clear();
+
+	for (const SpritePrefetchJob &job : done) {
+		SpriteCache *sc = GetSpriteCache(job.sprite);
+		assert(sc->prefetch);
+		sc->prefetch = false;
+		_sprite_prefetch_count--;
+
+		for (const auto &warn : job.warnings) warn();
+
+		if (job.data == NULL) continue;
+		if (sc->type != ST_NORMAL || sc->GetPtr() != NULL) {
+			free(job.data);
+			continue;
+		}
+		sc->buffer.Adopt(job.data, job.size);
+		/* Not referenced yet, so it is the first to go when it does not get drawn after all. */
+		AddSpriteToClock(job.sprite, false);
+	}
+	done.clear();
+}
+
+/**
+ * Stop the prefetch thread and drop all sprites it has not published yet.
+ * Must be called before anything the decoding depends on changes, like the loaded GRFs or the blitter.
+ */
+void StopSpritePrefetch()
+{
+	if (_sprite_prefetch_thread != NULL) {
+		_sprite_prefetch_mutex->BeginCritical();
+		_sprite_prefetch_exit = true;
+		_sprite_prefetch_mutex->SendSignal();
+		_sprite_prefetch_mutex->EndCritical();
+
+		_sprite_prefetch_thread->Join();
+		delete _sprite_prefetch_thread;
+		_sprite_prefetch_thread = NULL;
+	}
+
+	auto drop = [](const SpritePrefetchJob &job) {
+		GetSpriteCache(job.sprite)->prefetch = false;
+		free(job.data);
+	};
+	for (const SpritePrefetchJob &job : _sprite_prefetch_new) drop(job);
+	for (const SpritePrefetchJob &job : _sprite_prefetch_queue) drop(job);
+	for (const SpritePrefetchJob &job : _sprite_prefetch_done) drop(job);
+	_sprite_prefetch_new.clear();
+	_sprite_prefetch_queue.clear();
+	_sprite_prefetch_done.clear();
+	_sprite_prefetch_count = 0;
+}
+
 /**
  * Reads a sprite and finds its most representative colour.
  * @param sprite Sprite to read.
@@ -936,8 +1256,12 @@ uint32 GetSpriteMainColour(SpriteID sprite_id, PaletteID palette_id)
 
 void GfxInitSpriteMem()
 {
+	StopSpritePrefetch();
+
 	/* Reset the spritecache 'pool' */
 	_spritecache.clear();
+	_sprite_clock.clear();
+	_sprite_clock_hand = 0;
 	assert(_spritecache_bytes_used == 0);
 }
 
@@ -947,11 +1271,14 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
+	StopSpritePrefetch();
+
 	/* Clear sprite ptr for all cached items */
-	for (uint i = 0; i != _spritecache.size(); i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->GetPtr() != NULL) DeleteEntryFromSpriteCache(i);
+	for (SpriteID sprite : _sprite_clock) {
+		GetSpriteCache(sprite)->buffer.Clear();
 	}
+	_sprite_clock.clear();
+	_sprite_clock_hand = 0;
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
@@ -50,7 +50,11 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
-void IncreaseSpriteLRU();
+void CheckSpriteCacheSize();
+
+void PrefetchSprite(SpriteID sprite);
+void ProcessSpritePrefetches();
+void StopSpritePrefetch();
 
 void ReadGRFSpriteOffsets(byte container_version);
 size_t GetGRFSpriteOffset(uint32 id);
@@ -20,6 +20,7 @@
 #include "../core/alloc_type.hpp"
 #include "../core/bitmath_func.hpp"
 #include "grf.hpp"
+#include <string>
 
 #include "../safeguards.h"
 
@@ -34,6 +35,32 @@ enum SpriteColourComponent {
 };
 DECLARE_ENUM_AS_BIT_SET(SpriteColourComponent)
 
+/** Queue of the warnings about sprites of the current thread, NULL to show them right away. */
+static thread_local SpriteLoaderWarnings *_sprite_loader_warnings = NULL;
+
+/**
+ * Queue the warnings about sprites found by the current thread, instead of showing them.
+ * Only the main thread may show warnings, as they go to the console and error windows.
+ * @param warnings Queue to add the warnings to, or NULL to show them right away again.
+ */
+void SetSpriteLoaderWarningQueue(SpriteLoaderWarnings *warnings)
+{
+	_sprite_loader_warnings = warnings;
+}
+
+/**
+ * Show a warning about a sprite, or queue it if the current thread queues its warnings.
+ * @param warn Function showing the warning; it must not refer to data of the current thread.
+ */
+static void ShowSpriteLoaderWarning(std::function<void()> warn)
+{
+	if (_sprite_loader_warnings != NULL) {
+		_sprite_loader_warnings->push_back(std::move(warn));
+	} else {
+		warn();
+	}
+}
+
 /**
  * We found a corrupted sprite. This means that the sprite itself
  * contains invalid data or is too small for the given dimensions.
@@ -44,19 +71,23 @@ DECLARE_ENUM_AS_BIT_SET(SpriteColourComponent)
  */
 static bool WarnCorruptSprite(uint file_slot, size_t file_pos, int line)
 {
-	static byte warning_level = 0;
-	if (warning_level == 0) {
-		SetDParamStr(0, FioGetFilename(file_slot));
-		ShowErrorMessage(STR_NEWGRF_ERROR_CORRUPT_SPRITE, INVALID_STRING_ID, WL_ERROR);
-	}
-	DEBUG(sprite, warning_level, "[%i] Loading corrupted sprite from %s at position %i", line, FioGetFilename(file_slot), (int)file_pos);
-	warning_level = 6;
+	std::string filename = FioGetFilename(file_slot);
+	ShowSpriteLoaderWarning([filename, file_pos, line]() {
+		static byte warning_level = 0;
+		if (warning_level == 0) {
+			SetDParamStr(0, filename.c_str());
+			ShowErrorMessage(STR_NEWGRF_ERROR_CORRUPT_SPRITE, INVALID_STRING_ID, WL_ERROR);
+		}
+		DEBUG(sprite, warning_level, "[%i] Loading corrupted sprite from %s at position %i", line, filename.c_str(), (int)file_pos);
+		warning_level = 6;
+	});
 	return false;
 }
 
 /**
  * Decode the image data of a single sprite.
  * @param[in,out] sprite Filled with the sprite image data.
+ * @param reader Reader positioned at the image data.
  * @param file_slot File slot.
  * @param file_pos File position.
  * @param sprite_type Type of the sprite we're decoding.
@@ -67,7 +98,7 @@ static bool WarnCorruptSprite(uint file_slot, size_t file_pos, int line)
  * @param container_format Container format of the GRF this sprite is in.
  * @return True if the sprite was successfully loaded.
  */
-bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
+static bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, FioReader &reader, uint file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
 {
 	AutoFreePtr<byte> dest_orig(MallocT<byte>(num));
 	byte *dest = dest_orig;
@@ -75,20 +106,18 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 
 	/* Read the file, which has some kind of compression */
 	while (num > 0) {
-		int8 code = FioReadByte();
+		int8 code = reader.ReadByte();
 
 		if (code >= 0) {
 			/* Plain bytes to read */
 			int size = (code == 0) ? 0x80 : code;
 			num -= size;
 			if (num < 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
-			for (; size > 0; size--) {
-				*dest = FioReadByte();
-				dest++;
-			}
+			reader.ReadBlock(dest, size);
+			dest += size;
 		} else {
 			/* Copy bytes from earlier in the sprite */
-			const uint data_offset = ((code & 7) << 8) | FioReadByte();
+			const uint data_offset = ((code & 7) << 8) | reader.ReadByte();
 			if (dest - data_offset < dest_orig) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
 			int size = -(code >> 3);
 			num -= size;
@@ -183,9 +212,13 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 		}
 
 		if (dest_size > sprite->width * sprite->height * bpp) {
-			static byte warning_level = 0;
-			DEBUG(sprite, warning_level, "Ignoring " OTTD_PRINTF64 " unused extra bytes from the sprite from %s at position %i", dest_size - sprite->width * sprite->height * bpp, FioGetFilename(file_slot), (int)file_pos);
-			warning_level = 6;
+			int64 extra = dest_size - sprite->width * sprite->height * bpp;
+			std::string filename = FioGetFilename(file_slot);
+			ShowSpriteLoaderWarning([extra, filename, file_pos]() {
+				static byte warning_level = 0;
+				DEBUG(sprite, warning_level, "Ignoring " OTTD_PRINTF64 " unused extra bytes from the sprite from %s at position %i", extra, filename.c_str(), (int)file_pos);
+				warning_level = 6;
+			});
 		}
 
 		dest = dest_orig;
@@ -221,21 +254,21 @@ uint8 LoadSpriteV1(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 	if (load_32bpp) return 0;
 
 	/* Open the right file and go to the correct position */
-	FioSeekToFile(file_slot, file_pos);
+	FioReader reader(file_slot, file_pos);
 
 	/* Read the size and type */
-	int num = FioReadWord();
-	byte type = FioReadByte();
+	int num = reader.ReadWord();
+	byte type = reader.ReadByte();
 
 	/* Type 0xFF indicates either a colourmap or some other non-sprite info; we do not handle them here */
 	if (type == 0xFF) return 0;
 
 	ZoomLevel zoom_lvl = (sprite_type != ST_MAPGEN) ? ZOOM_LVL_OUT_4X : ZOOM_LVL_NORMAL;
 
-	sprite[zoom_lvl].height = FioReadByte();
-	sprite[zoom_lvl].width  = FioReadWord();
-	sprite[zoom_lvl].x_offs = FioReadWord();
-	sprite[zoom_lvl].y_offs = FioReadWord();
+	sprite[zoom_lvl].height = reader.ReadByte();
+	sprite[zoom_lvl].width  = reader.ReadWord();
+	sprite[zoom_lvl].x_offs = reader.ReadWord();
+	sprite[zoom_lvl].y_offs = reader.ReadWord();
 
 	if (sprite[zoom_lvl].width > INT16_MAX) {
 		WarnCorruptSprite(file_slot, file_pos, __LINE__);
@@ -246,7 +279,7 @@ uint8 LoadSpriteV1(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 	 * In case it is uncompressed, the size is 'num' - 8 (header-size). */
 	num = (type & 0x02) ? sprite[zoom_lvl].width * sprite[zoom_lvl].height : num - 8;
 
-	if (DecodeSingleSprite(&sprite[zoom_lvl], file_slot, file_pos, sprite_type, num, type, zoom_lvl, SCC_PAL, 1)) return 1 << zoom_lvl;
+	if (DecodeSingleSprite(&sprite[zoom_lvl], reader, file_slot, file_pos, sprite_type, num, type, zoom_lvl, SCC_PAL, 1)) return 1 << zoom_lvl;
 
 	return 0;
 }
@@ -259,36 +292,39 @@ uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 	if (file_pos == SIZE_MAX) return 0;
 
 	/* Open the right file and go to the correct position */
-	FioSeekToFile(file_slot, file_pos);
+	FioReader reader(file_slot, file_pos);
 
-	uint32 id = FioReadDword();
+	uint32 id = reader.ReadDword();
 
 	uint8 loaded_sprites = 0;
 	do {
-		int64 num = FioReadDword();
-		size_t start_pos = FioGetPos();
-		byte type = FioReadByte();
+		int64 num = reader.ReadDword();
+		size_t start_pos = reader.GetPos();
+		byte type = reader.ReadByte();
 
 		/* Type 0xFF indicates either a colourmap or some other non-sprite info; we do not handle them here. */
 		if (type == 0xFF) return 0;
 
 		byte colour = type & SCC_MASK;
-		byte zoom = FioReadByte();
+		byte zoom = reader.ReadByte();
 
 		if (colour != 0 && (load_32bpp ? colour != SCC_PAL : colour == SCC_PAL) && (sprite_type != ST_MAPGEN ? zoom < lengthof(zoom_lvl_map) : zoom == 0)) {
 			ZoomLevel zoom_lvl = (sprite_type != ST_MAPGEN) ? zoom_lvl_map[zoom] : ZOOM_LVL_NORMAL;
 
 			if (HasBit(loaded_sprites, zoom_lvl)) {
 				/* We already have this zoom level, skip sprite. */
-				DEBUG(sprite, 1, "Ignoring duplicate zoom level sprite %u from %s", id, FioGetFilename(file_slot));
-				FioSkipBytes(num - 2);
+				std::string filename = FioGetFilename(file_slot);
+				ShowSpriteLoaderWarning([id, filename]() {
+					DEBUG(sprite, 1, "Ignoring duplicate zoom level sprite %u from %s", id, filename.c_str());
+				});
+				reader.SkipBytes(num - 2);
 				continue;
 			}
 
-			sprite[zoom_lvl].height = FioReadWord();
-			sprite[zoom_lvl].width  = FioReadWord();
-			sprite[zoom_lvl].x_offs = FioReadWord();
-			sprite[zoom_lvl].y_offs = FioReadWord();
+			sprite[zoom_lvl].height = reader.ReadWord();
+			sprite[zoom_lvl].width  = reader.ReadWord();
+			sprite[zoom_lvl].x_offs = reader.ReadWord();
+			sprite[zoom_lvl].y_offs = reader.ReadWord();
 
 			if (sprite[zoom_lvl].width > INT16_MAX || sprite[zoom_lvl].height > INT16_MAX) {
 				WarnCorruptSprite(file_slot, file_pos, __LINE__);
@@ -306,10 +342,10 @@ uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 
 			/* For chunked encoding we store the decompressed size in the file,
 			 * otherwise we can calculate it from the image dimensions. */
-			uint decomp_size = (type & 0x08) ? FioReadDword() : sprite[zoom_lvl].width * sprite[zoom_lvl].height * bpp;
+			uint decomp_size = (type & 0x08) ? reader.ReadDword() : sprite[zoom_lvl].width * sprite[zoom_lvl].height * bpp;
 
-			bool valid = DecodeSingleSprite(&sprite[zoom_lvl], file_slot, file_pos, sprite_type, decomp_size, type, zoom_lvl, colour, 2);
-			if (FioGetPos() != start_pos + num) {
+			bool valid = DecodeSingleSprite(&sprite[zoom_lvl], reader, file_slot, file_pos, sprite_type, decomp_size, type, zoom_lvl, colour, 2);
+			if (reader.GetPos() != start_pos + num) {
 				WarnCorruptSprite(file_slot, file_pos, __LINE__);
 				return 0;
 			}
@@ -317,10 +353,10 @@ uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 			if (valid) SetBit(loaded_sprites, zoom_lvl);
 		} else {
 			/* Not the wanted zoom level or colour depth, continue searching. */
-			FioSkipBytes(num - 2);
+			reader.SkipBytes(num - 2);
 		}
 
-	} while (FioReadDword() == id);
+	} while (reader.ReadDword() == id);
 
 	return loaded_sprites;
 }
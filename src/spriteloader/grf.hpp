@@ -13,6 +13,13 @@
 #define SPRITELOADER_GRF_HPP
 
 #include "spriteloader.hpp"
+#include <vector>
+#include <functional>
+
+/** Warnings about sprites found by another thread than the main thread, to be shown by the main thread. */
+typedef std::vector<std::function<void()> > SpriteLoaderWarnings;
+
+void SetSpriteLoaderWarningQueue(SpriteLoaderWarnings *warnings);
 
 /** Sprite loader for graphics coming from a (New)GRF. */
 class SpriteLoaderGrf : public SpriteLoader {
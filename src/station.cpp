@@ -28,6 +28,7 @@
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "station_func.h"
 
 #include "table/strings.h"
 
@@ -63,6 +64,7 @@ Station::Station(TileIndex tile) :
 	time_since_unload(255)
 {
 	/* this->random_bits is set in Station::AddFacility() */
+	this->catchment_index_rect = { 0, 0, -1, -1 };
 }
 
 /**
@@ -85,6 +87,8 @@ Station::~Station()
 		this->loading_vehicles.front()->LeaveStation();
 	}
 
+	UpdateStationCatchmentIndex(this, true);
+
 	Aircraft *a;
 	FOR_ALL_AIRCRAFT(a) {
 		if (!a->IsNormalAircraft()) continue;
@@ -361,10 +365,14 @@ static bool FindIndustryToDeliver(TileIndex ind_tile, void *user_data)
 
 /**
  * Recomputes Station::industries_near, list of industries possibly
- * accepting cargo in station's catchment radius
+ * accepting cargo in station's catchment radius, and updates
+ * the station in the station catchment index.
  */
 void Station::RecomputeIndustriesNear()
 {
+	/* The catchment changes in the same cases as the industries near the station. */
+	UpdateStationCatchmentIndex(this);
+
 	this->industries_near.Clear();
 	if (this->rect.IsEmpty()) return;
 
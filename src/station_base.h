@@ -19,9 +19,9 @@
 #include "industry_type.h"
 #include "linkgraph/linkgraph_type.h"
 #include "newgrf_storage.h"
-#include "3rdparty/cpp-btree/btree_map.h"
 #include <map>
 #include <vector>
+#include <algorithm>
 
 typedef Pool<BaseStation, StationID, 32, 64000> StationPool;
 extern StationPool _station_pool;
@@ -30,14 +30,45 @@ static const byte INITIAL_STATION_RATING = 175;
 
 /**
  * Flow statistics telling how much flow should be sent along a link. This is
- * done by creating "flow shares" and using std::map's upper_bound() method to
- * look them up with a random number. A flow share is the difference between a
- * key in a map and the previous key. So one key in the map doesn't actually
- * mean anything by itself.
+ * done by creating "flow shares" and using a binary search for the upper bound
+ * to look them up with a random number. A flow share is the difference between
+ * a key in the shares map and the previous key. So one key in the map doesn't
+ * actually mean anything by itself.
  */
 class FlowStat {
 public:
-	typedef btree::btree_map<uint32, StationID> SharesMap;
+	/**
+	 * Shares of flow as pairs of the accumulated flow up to and including the
+	 * share and the station of the share. The pairs are kept in a vector, in
+	 * ascending order of accumulated flow, so looking up a share is a binary
+	 * search in contiguous memory.
+	 */
+	class SharesMap : public std::vector<std::pair<uint32, StationID> > {
+	public:
+		/**
+		 * Find the first share with an accumulated flow greater than the given one.
+		 * @param flow Accumulated flow to search for.
+		 * @return Iterator to the share or end() if there is none.
+		 */
+		inline const_iterator upper_bound(uint32 flow) const
+		{
+			return std::upper_bound(this->begin(), this->end(), flow, [](uint32 value, const value_type &share) {
+				return value < share.first;
+			});
+		}
+
+		/**
+		 * Add a share after all other shares.
+		 * @param flow Accumulated flow up to and including the new share.
+		 * @param st Station of the new share.
+		 * @pre flow is greater than the accumulated flow of all other shares.
+		 */
+		inline void Append(uint32 flow, StationID st)
+		{
+			assert(this->empty() || this->back().first < flow);
+			this->emplace_back(flow, st);
+		}
+	};
 
 	static const SharesMap empty_sharesmap;
 
@@ -57,7 +88,7 @@ public:
 	inline FlowStat(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[flow] = st;
+		this->shares.Append(flow, st);
 		this->unrestricted = restricted ? 0 : flow;
 	}
 
@@ -72,7 +103,7 @@ public:
 	inline void AppendShare(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[(--this->shares.end())->first + flow] = st;
+		this->shares.Append(this->shares.back().first + flow, st);
 		if (!restricted) this->unrestricted += flow;
 	}
 
@@ -110,6 +141,16 @@ public:
 		Swap(this->unrestricted, other.unrestricted);
 	}
 
+	/**
+	 * Check if another flow stat has the same shares.
+	 * @param other Flow stat to compare with.
+	 * @return If both have the same shares and unrestricted limit.
+	 */
+	inline bool HasSameShares(const FlowStat &other) const
+	{
+		return this->unrestricted == other.unrestricted && this->shares == other.shares;
+	}
+
 	/**
 	 * Get a station a package can be routed to. This done by drawing a
 	 * random number between 0 and sum_shares and then looking that up in
@@ -478,6 +519,7 @@ public:
 	CargoTypes always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	Rect catchment_index_rect;      ///< NOSAVE: Area in which the station is listed in the station catchment index, @see FindStationsAroundTiles()
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
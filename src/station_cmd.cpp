@@ -55,9 +55,14 @@
 #include "linkgraph/refresh.h"
 #include "widgets/station_widget.h"
 #include "zoning.h"
+#include "framerate_type.h"
+#include "thread/thread_pool.h"
 
 #include "table/strings.h"
 
+#include <vector>
+#include <algorithm>
+
 #include "safeguards.h"
 
 /**
@@ -505,15 +510,14 @@ CargoArray GetProductionAroundTiles(TileIndex tile, int w, int h, int rad)
 	 * area loop might not hit an industry tile while
 	 * the industry would produce cargo for the station.
 	 */
-	const Industry *i;
-	FOR_ALL_INDUSTRIES(i) {
-		if (!ta.Intersects(i->location)) continue;
-
+	_industry_grid.FindInRect(TileX(ta.tile), TileY(ta.tile), TileX(ta.tile) + ta.w - 1, TileY(ta.tile) + ta.h - 1, [&produced](IndustryID id) {
+		const Industry *i = Industry::Get(id);
 		for (uint j = 0; j < lengthof(i->produced_cargo); j++) {
 			CargoID cargo = i->produced_cargo[j];
 			if (cargo != CT_INVALID) produced[cargo]++;
 		}
-	}
+		return false;
+	});
 
 	return produced;
 }
@@ -3490,13 +3494,55 @@ static void TruncateCargo(const CargoSpec *cs, GoodsEntry *ge, uint amount = UIN
 	}
 }
 
-static void UpdateStationRating(Station *st)
+/** Part of the rating update of a cargo at a station which only depends on the station itself. */
+struct CargoRatingUpdate {
+	int base;      ///< Rating from the speed and the waiting time.
+	int bonus;     ///< Rating from the statue and the age of the vehicles.
+	bool callback; ///< Whether the NewGRF callback has to be tried for the rating, instead of the speed, waiting time and waiting cargo.
+	bool expired;  ///< Whether the cargo has not been picked up for too long and is removed.
+};
+
+/**
+ * Rating update of a station. It is prepared for all stations of a tick at once, possibly in
+ * parallel, before the stations are ticked; the part which draws random numbers or changes
+ * other stations is applied in the order of the stations.
+ */
+struct StationRatingUpdate {
+	Station *st;                         ///< The station.
+	CargoRatingUpdate cargo[NUM_CARGO];  ///< Prepared updates of the cargoes with a rating.
+};
+
+static ThreadPool _station_rating_pool("ottd:station"); ///< Threads for preparing the station rating updates.
+static const uint STATION_RATING_MIN_PARALLEL_STATIONS = 64; ///< Minimum number of stations before preparing their rating updates is split over multiple threads.
+static std::vector<StationRatingUpdate> _station_rating_updates; ///< Prepared rating updates of the current tick, in order of the stations.
+static uint _station_rating_next; ///< Index of the first prepared rating update which has not been applied yet.
+
+/**
+ * Get the value the rating counter of a station will have after its next tick.
+ * @param st The station.
+ * @return The new counter; the rating is updated when it is 0.
+ */
+static inline byte GetNextStationRatingCounter(const BaseStation *st)
 {
-	bool waiting_changed = false;
+	byte b = st->delete_ctr + 1;
+	if (b >= STATION_RATING_TICKS) b = 0;
+	return b;
+}
+
+/**
+ * Prepare the rating update of a station. This only reads and changes the station itself, so it can be
+ * done for multiple stations at the same time.
+ * @param update The update to prepare; its station must be set.
+ */
+static void PrepareStationRating(StationRatingUpdate *update)
+{
+	Station *st = update->st;
 
 	byte_inc_sat(&st->time_since_load);
 	byte_inc_sat(&st->time_since_unload);
 
+	int statue = (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) ? 26 : 0;
+
 	const CargoSpec *cs;
 	FOR_ALL_CARGOSPECS(cs) {
 		GoodsEntry *ge = &st->goods[cs->Index()];
@@ -3508,144 +3554,215 @@ static void UpdateStationRating(Station *st)
 		}
 
 		/* Only change the rating if we are moving this cargo */
-		if (ge->HasRating()) {
-			byte_inc_sat(&ge->time_since_pickup);
-			if (ge->time_since_pickup == 255 && _settings_game.order.selectgoods) {
-				ClrBit(ge->status, GoodsEntry::GES_RATING);
-				ge->last_speed = 0;
-				TruncateCargo(cs, ge);
-				waiting_changed = true;
-				continue;
+		if (!ge->HasRating()) continue;
+
+		CargoRatingUpdate &cu = update->cargo[cs->Index()];
+		byte_inc_sat(&ge->time_since_pickup);
+		cu.expired = ge->time_since_pickup == 255 && _settings_game.order.selectgoods;
+		if (cu.expired) continue;
+
+		cu.callback = HasBit(cs->callback_mask, CBM_CARGO_STATION_RATING_CALC);
+
+		int rating = 0;
+		int b = ge->last_speed - 85;
+		if (b >= 0) rating += b >> 2;
+
+		uint waittime = ge->time_since_pickup;
+		if (_settings_game.station.cargo_class_rating_wait_time) {
+			if (cs->classes & CC_PASSENGERS) {
+				waittime *= 3;
+			} else if (cs->classes & CC_REFRIGERATED) {
+				waittime *= 2;
+			} else if (cs->classes & (CC_MAIL | CC_ARMOURED | CC_EXPRESS)) {
+				waittime += (waittime >> 1);
+			} else if (cs->classes & (CC_BULK | CC_LIQUID)) {
+				waittime >>= 2;
 			}
+		}
+		if (ge->last_vehicle_type == VEH_SHIP) waittime >>= 2;
+		(waittime > 21) ||
+		(rating += 25, waittime > 12) ||
+		(rating += 25, waittime > 6) ||
+		(rating += 45, waittime > 3) ||
+		(rating += 35, true);
+		cu.base = rating;
+
+		rating = statue;
+		byte age = ge->last_age;
+		(age >= 3) ||
+		(rating += 10, age >= 2) ||
+		(rating += 10, age >= 1) ||
+		(rating += 13, true);
+		cu.bonus = rating;
+	}
+}
 
-			bool skip = false;
-			int rating = 0;
-			uint waiting = ge->cargo.AvailableCount();
-
-			/* num_dests is at least 1 if there is any cargo as
-			 * INVALID_STATION is also a destination.
-			 */
-			uint num_dests = (uint)ge->cargo.Packets()->MapSize();
-
-			/* Average amount of cargo per next hop, but prefer solitary stations
-			 * with only one or two next hops. They are allowed to have more
-			 * cargo waiting per next hop.
-			 * With manual cargo distribution waiting_avg = waiting / 2 as then
-			 * INVALID_STATION is the only destination.
-			 */
-			uint waiting_avg = waiting / (num_dests + 1);
-
-			if (HasBit(cs->callback_mask, CBM_CARGO_STATION_RATING_CALC)) {
-				/* Perform custom station rating. If it succeeds the speed, days in transit and
-				 * waiting cargo ratings must not be executed. */
-
-				/* NewGRFs expect last speed to be 0xFF when no vehicle has arrived yet. */
-				uint last_speed = ge->HasVehicleEverTriedLoading() ? ge->last_speed : 0xFF;
-
-				uint32 var18 = min(ge->time_since_pickup, 0xFF) | (min(ge->max_waiting_cargo, 0xFFFF) << 8) | (min(last_speed, 0xFF) << 24);
-				/* Convert to the 'old' vehicle types */
-				uint32 var10 = (ge->last_vehicle_type == VEH_INVALID) ? 0x0 : (ge->last_vehicle_type + 0x10);
-				uint16 callback = GetCargoCallback(CBID_CARGO_STATION_RATING_CALC, var10, var18, cs);
-				if (callback != CALLBACK_FAILED) {
-					skip = true;
-					rating = GB(callback, 0, 14);
-
-					/* Simulate a 15 bit signed value */
-					if (HasBit(callback, 14)) rating -= 0x4000;
-				}
-			}
+/**
+ * Prepare the rating updates of a range of stations.
+ * @param data The vector of StationRatingUpdate.
+ * @param index Index of the first update of the range.
+ */
+static void PrepareStationRatingRange(void *data, uint index)
+{
+	std::vector<StationRatingUpdate> *updates = (std::vector<StationRatingUpdate> *)data;
+	uint count = (uint)updates->size();
+	uint threads = _station_rating_pool.GetThreadCount();
+	for (uint i = count * index / threads; i < count * (index + 1) / threads; i++) {
+		PrepareStationRating(&(*updates)[i]);
+	}
+}
 
-			if (!skip) {
-				int b = ge->last_speed - 85;
-				if (b >= 0) rating += b >> 2;
-
-				uint waittime = ge->time_since_pickup;
-				if (_settings_game.station.cargo_class_rating_wait_time) {
-					if (cs->classes & CC_PASSENGERS) {
-						waittime *= 3;
-					} else if (cs->classes & CC_REFRIGERATED) {
-						waittime *= 2;
-					} else if (cs->classes & (CC_MAIL | CC_ARMOURED | CC_EXPRESS)) {
-						waittime += (waittime >> 1);
-					} else if (cs->classes & (CC_BULK | CC_LIQUID)) {
-						waittime >>= 2;
-					}
-				}
-				if (ge->last_vehicle_type == VEH_SHIP) waittime >>= 2;
-				(waittime > 21) ||
-				(rating += 25, waittime > 12) ||
-				(rating += 25, waittime > 6) ||
-				(rating += 45, waittime > 3) ||
-				(rating += 35, true);
-
-				(rating -= 90, ge->max_waiting_cargo > 1500) ||
-				(rating += 55, ge->max_waiting_cargo > 1000) ||
-				(rating += 35, ge->max_waiting_cargo > 600) ||
-				(rating += 10, ge->max_waiting_cargo > 300) ||
-				(rating += 20, ge->max_waiting_cargo > 100) ||
-				(rating += 10, true);
-			}
+/** Prepare the rating updates of all stations whose rating is updated in the current tick. */
+static void PrepareStationRatings()
+{
+	PerformanceZoneMeasurer zone(PFZ_STATION_RATINGS);
 
-			if (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) rating += 26;
+	_station_rating_updates.clear();
+	_station_rating_next = 0;
 
-			byte age = ge->last_age;
-			(age >= 3) ||
-			(rating += 10, age >= 2) ||
-			(rating += 10, age >= 1) ||
-			(rating += 13, true);
+	Station *st;
+	FOR_ALL_STATIONS(st) {
+		if (!st->IsInUse() || GetNextStationRatingCounter(st) != 0) continue;
 
-			{
-				int or_ = ge->rating; // old rating
+		_station_rating_updates.emplace_back();
+		_station_rating_updates.back().st = st;
+	}
 
-				/* only modify rating in steps of -2, -1, 0, 1 or 2 */
-				ge->rating = rating = or_ + Clamp(Clamp(rating, 0, 255) - or_, -2, 2);
+	if (_station_rating_updates.size() < STATION_RATING_MIN_PARALLEL_STATIONS) {
+		for (StationRatingUpdate &update : _station_rating_updates) PrepareStationRating(&update);
+	} else {
+		_station_rating_pool.Run(&PrepareStationRatingRange, &_station_rating_updates, _station_rating_pool.GetThreadCount());
+	}
+}
 
-				/* if rating is <= 64 and more than 100 items waiting on average per destination,
-				 * remove some random amount of goods from the station */
-				if (rating <= 64 && waiting_avg >= 100) {
-					int dec = Random() & 0x1F;
-					if (waiting_avg < 200) dec &= 7;
-					waiting -= (dec + 1) * num_dests;
-					waiting_changed = true;
-				}
+/**
+ * Apply the prepared rating update of a station: determine the rating from the waiting cargo
+ * and the NewGRF callback, and remove cargo when the rating is low.
+ * @param update The prepared update.
+ */
+static void UpdateStationRating(const StationRatingUpdate &update)
+{
+	PerformanceZoneMeasurer zone(PFZ_STATION_RATINGS);
 
-				/* if rating is <= 127 and there are any items waiting, maybe remove some goods. */
-				if (rating <= 127 && waiting != 0) {
-					uint32 r = Random();
-					if (rating <= (int)GB(r, 0, 7)) {
-						/* Need to have int, otherwise it will just overflow etc. */
-						waiting = max((int)waiting - (int)((GB(r, 8, 2) - 1) * num_dests), 0);
-						waiting_changed = true;
-					}
-				}
+	Station *st = update.st;
+	bool waiting_changed = false;
 
-				/* At some point we really must cap the cargo. Previously this
-				 * was a strict 4095, but now we'll have a less strict, but
-				 * increasingly aggressive truncation of the amount of cargo. */
-				static const uint WAITING_CARGO_THRESHOLD  = 1 << 12;
-				static const uint WAITING_CARGO_CUT_FACTOR = 1 <<  6;
-				static const uint MAX_WAITING_CARGO        = 1 << 15;
+	const CargoSpec *cs;
+	FOR_ALL_CARGOSPECS(cs) {
+		GoodsEntry *ge = &st->goods[cs->Index()];
+		if (!ge->HasRating()) continue;
+
+		const CargoRatingUpdate &cu = update.cargo[cs->Index()];
+		if (cu.expired) {
+			ClrBit(ge->status, GoodsEntry::GES_RATING);
+			ge->last_speed = 0;
+			TruncateCargo(cs, ge);
+			waiting_changed = true;
+			continue;
+		}
 
-				if (waiting > WAITING_CARGO_THRESHOLD) {
-					uint difference = waiting - WAITING_CARGO_THRESHOLD;
-					waiting -= (difference / WAITING_CARGO_CUT_FACTOR);
+		bool skip = false;
+		int rating = 0;
+		uint waiting = ge->cargo.AvailableCount();
+
+		/* num_dests is at least 1 if there is any cargo as
+		 * INVALID_STATION is also a destination.
+		 */
+		uint num_dests = (uint)ge->cargo.Packets()->MapSize();
+
+		/* Average amount of cargo per next hop, but prefer solitary stations
+		 * with only one or two next hops. They are allowed to have more
+		 * cargo waiting per next hop.
+		 * With manual cargo distribution waiting_avg = waiting / 2 as then
+		 * INVALID_STATION is the only destination.
+		 */
+		uint waiting_avg = waiting / (num_dests + 1);
+
+		if (cu.callback) {
+			/* Perform custom station rating. If it succeeds the speed, days in transit and
+			 * waiting cargo ratings must not be executed. */
+
+			/* NewGRFs expect last speed to be 0xFF when no vehicle has arrived yet. */
+			uint last_speed = ge->HasVehicleEverTriedLoading() ? ge->last_speed : 0xFF;
+
+			uint32 var18 = min(ge->time_since_pickup, 0xFF) | (min(ge->max_waiting_cargo, 0xFFFF) << 8) | (min(last_speed, 0xFF) << 24);
+			/* Convert to the 'old' vehicle types */
+			uint32 var10 = (ge->last_vehicle_type == VEH_INVALID) ? 0x0 : (ge->last_vehicle_type + 0x10);
+			uint16 callback = GetCargoCallback(CBID_CARGO_STATION_RATING_CALC, var10, var18, cs);
+			if (callback != CALLBACK_FAILED) {
+				skip = true;
+				rating = GB(callback, 0, 14);
+
+				/* Simulate a 15 bit signed value */
+				if (HasBit(callback, 14)) rating -= 0x4000;
+			}
+		}
+
+		if (!skip) {
+			/* The amount of waiting cargo can be changed by the ticks of stations before this
+			 * one, so it is only taken into account now. */
+			rating = cu.base;
+			(rating -= 90, ge->max_waiting_cargo > 1500) ||
+			(rating += 55, ge->max_waiting_cargo > 1000) ||
+			(rating += 35, ge->max_waiting_cargo > 600) ||
+			(rating += 10, ge->max_waiting_cargo > 300) ||
+			(rating += 20, ge->max_waiting_cargo > 100) ||
+			(rating += 10, true);
+		}
+
+		rating += cu.bonus;
+
+		{
+			int or_ = ge->rating; // old rating
+
+			/* only modify rating in steps of -2, -1, 0, 1 or 2 */
+			ge->rating = rating = or_ + Clamp(Clamp(rating, 0, 255) - or_, -2, 2);
+
+			/* if rating is <= 64 and more than 100 items waiting on average per destination,
+			 * remove some random amount of goods from the station */
+			if (rating <= 64 && waiting_avg >= 100) {
+				int dec = Random() & 0x1F;
+				if (waiting_avg < 200) dec &= 7;
+				waiting -= (dec + 1) * num_dests;
+				waiting_changed = true;
+			}
 
-					waiting = min(waiting, MAX_WAITING_CARGO);
+			/* if rating is <= 127 and there are any items waiting, maybe remove some goods. */
+			if (rating <= 127 && waiting != 0) {
+				uint32 r = Random();
+				if (rating <= (int)GB(r, 0, 7)) {
+					/* Need to have int, otherwise it will just overflow etc. */
+					waiting = max((int)waiting - (int)((GB(r, 8, 2) - 1) * num_dests), 0);
 					waiting_changed = true;
 				}
+			}
 
-				/* We can't truncate cargo that's already reserved for loading.
-				 * Thus StoredCount() here. */
-				if (waiting_changed && waiting < ge->cargo.AvailableCount()) {
-					/* Feed back the exact own waiting cargo at this station for the
-					 * next rating calculation. */
-					ge->max_waiting_cargo = 0;
+			/* At some point we really must cap the cargo. Previously this
+			 * was a strict 4095, but now we'll have a less strict, but
+			 * increasingly aggressive truncation of the amount of cargo. */
+			static const uint WAITING_CARGO_THRESHOLD  = 1 << 12;
+			static const uint WAITING_CARGO_CUT_FACTOR = 1 <<  6;
+			static const uint MAX_WAITING_CARGO        = 1 << 15;
 
-					TruncateCargo(cs, ge, ge->cargo.AvailableCount() - waiting);
-				} else {
-					/* If the average number per next hop is low, be more forgiving. */
-					ge->max_waiting_cargo = waiting_avg;
-				}
+			if (waiting > WAITING_CARGO_THRESHOLD) {
+				uint difference = waiting - WAITING_CARGO_THRESHOLD;
+				waiting -= (difference / WAITING_CARGO_CUT_FACTOR);
+
+				waiting = min(waiting, MAX_WAITING_CARGO);
+				waiting_changed = true;
+			}
+
+			/* We can't truncate cargo that's already reserved for loading.
+			 * Thus StoredCount() here. */
+			if (waiting_changed && waiting < ge->cargo.AvailableCount()) {
+				/* Feed back the exact own waiting cargo at this station for the
+				 * next rating calculation. */
+				ge->max_waiting_cargo = 0;
+
+				TruncateCargo(cs, ge, ge->cargo.AvailableCount() - waiting);
+			} else {
+				/* If the average number per next hop is low, be more forgiving. */
+				ge->max_waiting_cargo = waiting_avg;
 			}
 		}
 	}
@@ -3697,12 +3814,19 @@ void DeleteStaleLinks(Station *from)
 		GoodsEntry &ge = from->goods[c];
 		LinkGraph *lg = LinkGraph::GetIfValid(ge.link_graph);
 		if (lg == NULL) continue;
-		Node node = (*lg)[ge.node];
-		for (EdgeIterator it(node.Begin()); it != node.End();) {
-			Edge edge = it->second;
-			Station *to = Station::Get((*lg)[it->first].Station());
-			assert(to->goods[c].node == it->first);
-			++it; // Do that before removing the edge. Anything else may crash.
+		/* Refreshing links below may add edges, which invalidates iterators and
+		 * edge wrappers. So collect the destinations first and look up the edges
+		 * again after refreshing. Only read the edges through a const link graph
+		 * so that they aren't copied if they are shared with a link graph job. */
+		const LinkGraph *const_lg = lg;
+		std::vector<NodeID> to_nodes;
+		for (ConstEdgeIterator it((*const_lg)[ge.node].Begin()); it != (*const_lg)[ge.node].End(); ++it) {
+			to_nodes.push_back(it->first);
+		}
+		for (NodeID to_node : to_nodes) {
+			ConstEdge edge = (*const_lg)[ge.node][to_node];
+			Station *to = Station::Get((*lg)[to_node].Station());
+			assert(to->goods[c].node == to_node);
 			assert(_date >= edge.LastUpdate());
 			uint timeout = max<uint>((LinkGraph::MIN_TIMEOUT_DISTANCE + (DistanceManhattan(from->xy, to->xy) >> 3)) / _settings_game.economy.day_length_factor, 1);
 			if ((uint)(_date - edge.LastUpdate()) > timeout) {
@@ -3735,7 +3859,7 @@ void DeleteStaleLinks(Station *from)
 						Vehicle *v = *iter;
 
 						LinkRefresher::Run(v, false); // Don't allow merging. Otherwise lg might get deleted.
-						if (edge.LastUpdate() == _date) {
+						if ((*const_lg)[ge.node][to_node].LastUpdate() == _date) {
 							updated = true;
 							break;
 						}
@@ -3754,16 +3878,16 @@ void DeleteStaleLinks(Station *from)
 
 				if (!updated) {
 					/* If it's still considered dead remove it. */
-					node.RemoveEdge(to->goods[c].node);
+					(*lg)[ge.node].RemoveEdge(to_node);
 					ge.flows.DeleteFlows(to->index);
 					RerouteCargo(from, c, to->index, from->index);
 				}
 			} else if (edge.LastUnrestrictedUpdate() != INVALID_DATE && (uint)(_date - edge.LastUnrestrictedUpdate()) > timeout) {
-				edge.Restrict();
+				(*lg)[ge.node][to_node].Restrict();
 				ge.flows.RestrictFlows(to->index);
 				RerouteCargo(from, c, to->index, from->index);
 			} else if (edge.LastRestrictedUpdate() != INVALID_DATE && (uint)(_date - edge.LastRestrictedUpdate()) > timeout) {
-				edge.Release();
+				(*lg)[ge.node][to_node].Release();
 			}
 		}
 		assert(_date >= lg->LastCompression());
@@ -3833,17 +3957,28 @@ static void StationHandleSmallTick(BaseStation *st)
 {
 	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return;
 
-	byte b = st->delete_ctr + 1;
-	if (b >= STATION_RATING_TICKS) b = 0;
+	byte b = GetNextStationRatingCounter(st);
 	st->delete_ctr = b;
+	if (b != 0) return;
 
-	if (b == 0) UpdateStationRating(Station::From(st));
+	/* Find the prepared update; stations which started to need one after preparing are prepared now. */
+	while (_station_rating_next < _station_rating_updates.size() && _station_rating_updates[_station_rating_next].st->index < st->index) _station_rating_next++;
+	if (_station_rating_next < _station_rating_updates.size() && _station_rating_updates[_station_rating_next].st == st) {
+		UpdateStationRating(_station_rating_updates[_station_rating_next++]);
+	} else {
+		StationRatingUpdate update;
+		update.st = Station::From(st);
+		PrepareStationRating(&update);
+		UpdateStationRating(update);
+	}
 }
 
 void OnTick_Station()
 {
 	if (_game_mode == GM_EDITOR) return;
 
+	PrepareStationRatings();
+
 	BaseStation *st;
 	FOR_ALL_BASE_STATIONS(st) {
 		StationHandleSmallTick(st);
@@ -3989,55 +4124,166 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 	return CommandCost();
 }
 
+/** Log2 of the width and height in tiles of the blocks of the station catchment index. */
+static const uint STATION_CATCHMENT_INDEX_BLOCK_BITS = 4;
+
+static std::vector<std::vector<StationID>> _station_catchment_index; ///< For every block of tiles, the stations whose catchment may reach into it.
+uint32 _station_catchment_index_version = 1; ///< Changed whenever #_station_catchment_index changes, so lists derived from it know when to update.
+
+/**
+ * Get the radius around its tiles in which a station gets cargo from houses and industries.
+ * @param st The station.
+ * @return The radius.
+ */
+static uint GetStationProductionRadius(const Station *st)
+{
+	if (_settings_game.station.modified_catchment) return st->GetCatchmentRadius();
+	return CA_UNMODIFIED + _settings_game.station.catchment_increase;
+}
+
+/**
+ * Get the rectangle a station should be listed for in the station catchment index.
+ * @param st The station.
+ * @return The rectangle; empty (left > right) when the station has no tiles.
+ */
+static Rect GetStationCatchmentIndexRect(const Station *st)
+{
+	if (st->rect.IsEmpty()) return { 0, 0, -1, -1 };
+	return st->GetCatchmentRectUsingRadius(GetStationProductionRadius(st));
+}
+
+/**
+ * Add or remove a station to the blocks of the station catchment index overlapping a rectangle.
+ * @param st The station.
+ * @param r The rectangle.
+ * @param add Whether to add or remove the station.
+ */
+static void ChangeStationCatchmentIndex(const Station *st, const Rect &r, bool add)
+{
+	uint columns = MapSizeX() >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+	for (int by = r.top >> STATION_CATCHMENT_INDEX_BLOCK_BITS; r.left <= r.right && by <= r.bottom >> STATION_CATCHMENT_INDEX_BLOCK_BITS; by++) {
+		for (int bx = r.left >> STATION_CATCHMENT_INDEX_BLOCK_BITS; bx <= r.right >> STATION_CATCHMENT_INDEX_BLOCK_BITS; bx++) {
+			std::vector<StationID> &block = _station_catchment_index[by * columns + bx];
+			if (add) {
+				block.push_back(st->index);
+			} else {
+				auto it = std::find(block.begin(), block.end(), st->index);
+				assert(it != block.end());
+				*it = block.back();
+				block.pop_back();
+			}
+		}
+	}
+}
+
+/**
+ * Update the blocks a station is listed in by the station catchment index, after the tiles,
+ * facilities or catchment of the station changed.
+ * @param st The station.
+ * @param remove Whether to remove the station from the index, as it is being deleted.
+ */
+void UpdateStationCatchmentIndex(Station *st, bool remove)
+{
+	/* While loading a game the index is not sized for the map yet; it is built after loading. */
+	if (_station_catchment_index.size() != MapSize() >> (2 * STATION_CATCHMENT_INDEX_BLOCK_BITS)) return;
+
+	/* Even when the rectangle stays the same, the tiles or catchment radius of
+	 * the station may have changed, so the stations found around producers can
+	 * differ. Always invalidate the lists derived from the index. */
+	_station_catchment_index_version++;
+
+	Rect r = remove ? Rect{ 0, 0, -1, -1 } : GetStationCatchmentIndexRect(st);
+	const Rect &old = st->catchment_index_rect;
+	if (r.left == old.left && r.top == old.top && r.right == old.right && r.bottom == old.bottom) return;
+
+	ChangeStationCatchmentIndex(st, old, false);
+	ChangeStationCatchmentIndex(st, r, true);
+	st->catchment_index_rect = r;
+}
+
+/**
+ * Empty the station catchment index and size it for the current map.
+ * The stations have to be added again with #UpdateStationCatchmentIndex.
+ */
+void ClearStationCatchmentIndex()
+{
+	_station_catchment_index.clear();
+	_station_catchment_index.resize(MapSize() >> (2 * STATION_CATCHMENT_INDEX_BLOCK_BITS));
+	_station_catchment_index_version++;
+
+	Station *st;
+	FOR_ALL_STATIONS(st) st->catchment_index_rect = { 0, 0, -1, -1 };
+}
+
+/**
+ * Check whether a station is listed in the station catchment index where it should be.
+ * @param st The station.
+ * @return True when the index is up to date for the station.
+ */
+bool IsStationCatchmentIndexValid(const Station *st)
+{
+	Rect r = GetStationCatchmentIndexRect(st);
+	const Rect &old = st->catchment_index_rect;
+	return r.left == old.left && r.top == old.top && r.right == old.right && r.bottom == old.bottom;
+}
+
+/**
+ * Check whether a station gets cargo from a producer, i.e. whether it has a tile within its catchment radius of the producer.
+ * @param st The station.
+ * @param location The location/area of the producer.
+ * @return True when the producer is within the catchment of the station.
+ */
+static bool IsProducerInStationCatchment(const Station *st, const TileArea &location)
+{
+	int rad = GetStationProductionRadius(st);
+	int left   = max<int>(TileX(location.tile) - rad, st->rect.left);
+	int top    = max<int>(TileY(location.tile) - rad, st->rect.top);
+	int right  = min<int>(TileX(location.tile) + location.w - 1 + rad, st->rect.right);
+	int bottom = min<int>(TileY(location.tile) + location.h - 1 + rad, st->rect.bottom);
+
+	for (int y = top; y <= bottom; y++) {
+		for (int x = left; x <= right; x++) {
+			TileIndex tile = TileXY(x, y);
+			if (IsTileType(tile, MP_STATION) && GetStationIndex(tile) == st->index) return true;
+		}
+	}
+	return false;
+}
+
 /**
  * Find all stations around a rectangular producer (industry, house, headquarter, ...)
+ * The candidates are taken from the station catchment index, so only the
+ * stations whose catchment rectangle overlaps the producer are checked.
  *
  * @param location The location/area of the producer
- * @param stations The list to store the stations in
+ * @param stations The list to store the stations in, sorted by station index
  */
 void FindStationsAroundTiles(const TileArea &location, StationList *stations)
 {
-	/* area to search = producer plus station catchment radius */
-	uint max_rad = (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED);
-	max_rad += _settings_game.station.catchment_increase;
-
-	uint x = TileX(location.tile);
-	uint y = TileY(location.tile);
-
-	uint min_x = (x > max_rad) ? x - max_rad : 0;
-	uint max_x = x + location.w + max_rad;
-	uint min_y = (y > max_rad) ? y - max_rad : 0;
-	uint max_y = y + location.h + max_rad;
-
-	if (min_x == 0 && _settings_game.construction.freeform_edges) min_x = 1;
-	if (min_y == 0 && _settings_game.construction.freeform_edges) min_y = 1;
-	if (max_x >= MapSizeX()) max_x = MapSizeX() - 1;
-	if (max_y >= MapSizeY()) max_y = MapSizeY() - 1;
-
-	for (uint cy = min_y; cy < max_y; cy++) {
-		for (uint cx = min_x; cx < max_x; cx++) {
-			TileIndex cur_tile = TileXY(cx, cy);
-			if (!IsTileType(cur_tile, MP_STATION)) continue;
-
-			Station *st = Station::GetByTile(cur_tile);
-			/* st can be NULL in case of waypoints */
-			if (st == NULL) continue;
-
-			if (_settings_game.station.modified_catchment) {
-				int rad = st->GetCatchmentRadius();
-				int rad_x = cx - x;
-				int rad_y = cy - y;
-
-				if (rad_x < -rad || rad_x >= rad + location.w) continue;
-				if (rad_y < -rad || rad_y >= rad + location.h) continue;
+	SmallVector<StationID, 8> rejected;
+	uint columns = MapSizeX() >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+	uint min_bx = TileX(location.tile) >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+	uint min_by = TileY(location.tile) >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+	uint max_bx = min(TileX(location.tile) + location.w - 1, MapMaxX()) >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+	uint max_by = min(TileY(location.tile) + location.h - 1, MapMaxY()) >> STATION_CATCHMENT_INDEX_BLOCK_BITS;
+
+	for (uint by = min_by; by <= max_by; by++) {
+		for (uint bx = min_bx; bx <= max_bx; bx++) {
+			for (StationID id : _station_catchment_index[by * columns + bx]) {
+				Station *st = Station::Get(id);
+				if (stations->Contains(st) || rejected.Contains(id)) continue;
+
+				if (IsProducerInStationCatchment(st, location)) {
+					*stations->Append() = st;
+				} else {
+					*rejected.Append() = id;
+				}
 			}
-
-			/* Insert the station in the set. This will fail if it has
-			 * already been added.
-			 */
-			stations->Include(st);
 		}
 	}
+
+	/* The order of the stations in the blocks depends on the order they were added in, which differs after loading a game. */
+	std::sort(stations->Begin(), stations->End(), [](const Station *a, const Station *b) { return a->index < b->index; });
 }
 
 /**
@@ -4453,13 +4699,11 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 void FlowStat::Invalidate()
 {
 	assert(!this->shares.empty());
-	SharesMap new_shares;
 	uint i = 0;
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
-		new_shares[++i] = it->second;
-		if (it->first == this->unrestricted) this->unrestricted = i;
+		if (it->first == this->unrestricted) this->unrestricted = i + 1;
+		it->first = ++i;
 	}
-	this->shares.swap(new_shares);
 	assert(!this->shares.empty() && this->unrestricted <= (--this->shares.end())->first);
 }
 
@@ -4475,11 +4719,12 @@ void FlowStat::ChangeShare(StationID st, int flow)
 	 * be empty. In that case the whole flow stat must be deleted then. */
 	assert(!this->shares.empty());
 
+	/* The shares are updated in place, moving the accumulated flow of all
+	 * shares after the changed one by the change. */
 	uint removed_shares = 0;
 	uint added_shares = 0;
 	uint last_share = 0;
-	SharesMap new_shares;
-	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
+	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end();) {
 		if (it->second == st) {
 			if (flow < 0) {
 				uint share = it->first - last_share;
@@ -4488,6 +4733,7 @@ void FlowStat::ChangeShare(StationID st, int flow)
 					if (it->first <= this->unrestricted) this->unrestricted -= share;
 					if (flow != INT_MIN) flow += share;
 					last_share = it->first;
+					it = this->shares.erase(it);
 					continue; // remove the whole share
 				}
 				removed_shares += (uint)(-flow);
@@ -4500,18 +4746,18 @@ void FlowStat::ChangeShare(StationID st, int flow)
 			 * removed. */
 			flow = 0;
 		}
-		new_shares[it->first + added_shares - removed_shares] = it->second;
 		last_share = it->first;
+		it->first += added_shares - removed_shares;
+		++it;
 	}
 	if (flow > 0) {
-		new_shares[last_share + (uint)flow] = st;
+		this->shares.Append(last_share + (uint)flow, st);
 		if (this->unrestricted < last_share) {
 			this->ReleaseShare(st);
 		} else {
 			this->unrestricted += flow;
 		}
 	}
-	this->shares.swap(new_shares);
 }
 
 /**
@@ -4532,15 +4778,15 @@ void FlowStat::RestrictShare(StationID st)
 				flow = it->first - last_share;
 				this->unrestricted -= flow;
 			} else {
-				new_shares[it->first] = it->second;
+				new_shares.Append(it->first, it->second);
 			}
 		} else {
-			new_shares[it->first - flow] = it->second;
+			new_shares.Append(it->first - flow, it->second);
 		}
 		last_share = it->first;
 	}
 	if (flow == 0) return;
-	new_shares[last_share + flow] = st;
+	new_shares.Append(last_share + flow, st);
 	this->shares.swap(new_shares);
 	assert(!this->shares.empty());
 }
@@ -4570,10 +4816,10 @@ void FlowStat::ReleaseShare(StationID st)
 	}
 	if (flow == 0) return;
 	SharesMap new_shares;
-	new_shares[flow] = st;
+	new_shares.Append(flow, st);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second != st) {
-			new_shares[flow + it->first] = it->second;
+			new_shares.Append(flow + it->first, it->second);
 		} else {
 			flow = 0;
 		}
@@ -4590,14 +4836,12 @@ void FlowStat::ReleaseShare(StationID st)
 void FlowStat::ScaleToMonthly(uint runtime)
 {
 	assert(runtime > 0);
-	SharesMap new_shares;
 	uint share = 0;
 	for (SharesMap::iterator i = this->shares.begin(); i != this->shares.end(); ++i) {
 		share = max(share + 1, i->first * 30 / runtime);
-		new_shares[share] = i->second;
 		if (this->unrestricted == i->first) this->unrestricted = share;
+		i->first = share;
 	}
-	this->shares.swap(new_shares);
 }
 
 /**
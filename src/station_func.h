@@ -23,6 +23,11 @@
 void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint radius);
 
 void FindStationsAroundTiles(const TileArea &location, StationList *stations);
+void UpdateStationCatchmentIndex(Station *st, bool remove = false);
+void ClearStationCatchmentIndex();
+bool IsStationCatchmentIndexValid(const Station *st);
+
+extern uint32 _station_catchment_index_version;
 
 void ShowStationViewWindow(StationID station);
 void UpdateAllStationVirtCoords();
@@ -0,0 +1,147 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Pool of worker threads for splitting work over multiple cores. */
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../core/math_func.hpp"
+#include "thread_pool.h"
+
+#include "../safeguards.h"
+
+/**
+ * Create a pool of worker threads. No threads are started until the pool is used.
+ * @param name Name of the worker threads; must stay valid for the lifetime of the pool.
+ * @param max_workers Maximum number of worker threads, excluding the calling thread.
+ */
+ThreadPool::ThreadPool(const char *name, uint max_workers) : name(name), max_workers(max_workers), started(false), mutex(NULL), proc(NULL), data(NULL), count(0), next(0), busy_workers(0)
+{
+}
+
+/** Stop all worker threads. */
+ThreadPool::~ThreadPool()
+{
+	for (Worker *w : this->workers) {
+		w->mutex->BeginCritical();
+		w->exit = true;
+		w->mutex->SendSignal();
+		w->mutex->EndCritical();
+		w->thread->Join();
+		delete w->thread;
+		delete w->mutex;
+		delete w;
+	}
+	delete this->mutex;
+}
+
+/** Start the worker threads, one for each core besides the one of the calling thread. */
+void ThreadPool::Start()
+{
+	if (this->started) return;
+	this->started = true;
+
+	uint cores = GetCPUCoreCount();
+	if (cores <= 1 || this->max_workers == 0) return;
+
+	this->mutex = ThreadMutex::New();
+	uint wanted = min(cores - 1, this->max_workers);
+	for (uint i = 0; i < wanted; i++) {
+		Worker *w = new Worker();
+		w->pool = this;
+		w->thread = NULL;
+		w->mutex = ThreadMutex::New();
+		w->pending = false;
+		w->exit = false;
+		if (!ThreadObject::New(&ThreadPool::WorkerThread, w, &w->thread, this->name)) {
+			delete w->mutex;
+			delete w;
+			break;
+		}
+		this->workers.push_back(w);
+	}
+	DEBUG(misc, 2, "Started %u worker threads for %s", (uint)this->workers.size(), this->name);
+}
+
+/** Work on items of the current job until all of them have been handed out. */
+void ThreadPool::RunItems()
+{
+	for (;;) {
+		this->mutex->BeginCritical();
+		uint index = this->next;
+		if (index < this->count) this->next++;
+		this->mutex->EndCritical();
+
+		if (index >= this->count) return;
+		this->proc(this->data, index);
+	}
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param param The Worker of the thread.
+ */
+/* static */ void ThreadPool::WorkerThread(void *param)
+{
+	Worker *w = (Worker *)param;
+	ThreadPool *pool = w->pool;
+
+	for (;;) {
+		w->mutex->BeginCritical();
+		while (!w->pending && !w->exit) w->mutex->WaitForSignal();
+		bool exit = w->exit;
+		w->pending = false;
+		w->mutex->EndCritical();
+		if (exit) return;
+
+		pool->RunItems();
+
+		pool->mutex->BeginCritical();
+		if (--pool->busy_workers == 0) pool->mutex->SendSignal();
+		pool->mutex->EndCritical();
+	}
+}
+
+/**
+ * Run a job on the pool and wait until it is finished.
+ * The work items may be executed in any order and on any thread, including the calling thread.
+ * @param proc Function to execute for each work item.
+ * @param data Data passed to \a proc.
+ * @param count Number of work items.
+ */
+void ThreadPool::Run(ThreadPoolProc proc, void *data, uint count)
+{
+	this->Start();
+
+	if (this->workers.empty() || count <= 1) {
+		for (uint i = 0; i < count; i++) proc(data, i);
+		return;
+	}
+
+	this->mutex->BeginCritical();
+	this->proc = proc;
+	this->data = data;
+	this->count = count;
+	this->next = 0;
+	this->busy_workers = (uint)this->workers.size();
+	this->mutex->EndCritical();
+
+	for (Worker *w : this->workers) {
+		w->mutex->BeginCritical();
+		w->pending = true;
+		w->mutex->SendSignal();
+		w->mutex->EndCritical();
+	}
+
+	this->RunItems();
+
+	this->mutex->BeginCritical();
+	while (this->busy_workers != 0) this->mutex->WaitForSignal();
+	this->mutex->EndCritical();
+}
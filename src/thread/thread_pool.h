@@ -0,0 +1,73 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.h Pool of worker threads for splitting work over multiple cores. */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "thread.h"
+#include <vector>
+
+/**
+ * Function executed for each work item of ThreadPool::Run.
+ * @param data Data passed to ThreadPool::Run.
+ * @param index Index of the work item.
+ */
+typedef void (*ThreadPoolProc)(void *data, uint index);
+
+/**
+ * Pool of worker threads for running independent work items in parallel.
+ * The threads are started on first use; the calling thread works on the items as well.
+ * When no threads can be started all work items are run by the calling thread.
+ */
+class ThreadPool {
+	/** State of a single worker thread. */
+	struct Worker {
+		ThreadPool *pool;     ///< Pool the worker belongs to.
+		ThreadObject *thread; ///< The thread itself.
+		ThreadMutex *mutex;   ///< Mutex for waking up the worker.
+		bool pending;         ///< Whether there is work to pick up.
+		bool exit;            ///< Whether the worker should stop.
+	};
+
+	const char *name;             ///< Name of the worker threads.
+	uint max_workers;             ///< Maximum number of worker threads, excluding the calling thread.
+	bool started;                 ///< Whether starting the workers has been attempted.
+	std::vector<Worker *> workers; ///< The worker threads.
+
+	ThreadMutex *mutex;           ///< Mutex protecting the current job.
+	ThreadPoolProc proc;          ///< Function of the current job.
+	void *data;                   ///< Data of the current job.
+	uint count;                   ///< Number of work items of the current job.
+	uint next;                    ///< Next work item to hand out.
+	uint busy_workers;            ///< Number of workers which have not yet finished the current job.
+
+	void Start();
+	void RunItems();
+	static void WorkerThread(void *param);
+
+public:
+	ThreadPool(const char *name, uint max_workers = UINT_MAX);
+	~ThreadPool();
+
+	void Run(ThreadPoolProc proc, void *data, uint count);
+
+	/**
+	 * Get the number of threads working on a job, including the calling thread.
+	 * @return Number of threads.
+	 */
+	uint GetThreadCount()
+	{
+		this->Start();
+		return (uint)this->workers.size() + 1;
+	}
+};
+
+#endif /* THREAD_POOL_H */
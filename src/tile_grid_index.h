@@ -0,0 +1,190 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tile_grid_index.h Spatial index of things on the map, like towns and industries. */
+
+#ifndef TILE_GRID_INDEX_H
+#define TILE_GRID_INDEX_H
+
+#include "tilearea_type.h"
+#include <vector>
+#include <algorithm>
+
+/**
+ * Index of things covering an area of the map, in a grid of square cells.
+ * Every item is listed in all cells its area overlaps, so the items near a
+ * location can be found without going over all items.
+ * The items are found in no particular order; the order can differ between
+ * a running game and the same game after loading it.
+ * @tparam T Identifier of the items, like the index in their pool.
+ */
+template <typename T>
+class TileGridIndex {
+	/** An item in a cell of the grid. */
+	struct Entry {
+		uint16 left;   ///< Westmost X coordinate of the area of the item.
+		uint16 top;    ///< Northmost Y coordinate of the area of the item.
+		uint16 right;  ///< Eastmost X coordinate of the area of the item.
+		uint16 bottom; ///< Southmost Y coordinate of the area of the item.
+		T item;        ///< The item.
+	};
+
+	uint cell_bits;                        ///< Log2 of the width and height of a cell in tiles.
+	uint columns;                          ///< Number of cells in a row of the grid.
+	uint rows;                             ///< Number of cells in a column of the grid.
+	std::vector<std::vector<Entry>> cells; ///< The items in every cell, in rows from north to south.
+
+	/**
+	 * Call a function for all cells an area overlaps.
+	 * @param left Westmost X coordinate of the area.
+	 * @param top Northmost Y coordinate of the area.
+	 * @param right Eastmost X coordinate of the area.
+	 * @param bottom Southmost Y coordinate of the area.
+	 * @param proc Function to call with the items of the cell.
+	 */
+	template <typename F>
+	inline void ForCells(uint left, uint top, uint right, uint bottom, F proc)
+	{
+		for (uint y = top >> this->cell_bits; y <= bottom >> this->cell_bits; y++) {
+			for (uint x = left >> this->cell_bits; x <= right >> this->cell_bits; x++) {
+				proc(this->cells[y * this->columns + x]);
+			}
+		}
+	}
+
+public:
+	/**
+	 * Create an empty index; #Reset has to be called before it can be used.
+	 * @param cell_bits Log2 of the width and height of a cell in tiles.
+	 */
+	TileGridIndex(uint cell_bits) : cell_bits(cell_bits), columns(0), rows(0) {}
+
+	/** Remove all items and size the grid for the current map. */
+	void Reset()
+	{
+		this->columns = MapSizeX() >> this->cell_bits;
+		this->rows = MapSizeY() >> this->cell_bits;
+		this->cells.clear();
+		this->cells.resize(this->columns * this->rows);
+	}
+
+	/**
+	 * Add an item.
+	 * @param area Area of the item; it may not be empty.
+	 * @param item The item.
+	 */
+	void Insert(const TileArea &area, T item)
+	{
+		assert(area.w != 0 && area.h != 0);
+		Entry e = { (uint16)TileX(area.tile), (uint16)TileY(area.tile), (uint16)(TileX(area.tile) + area.w - 1), (uint16)(TileY(area.tile) + area.h - 1), item };
+		this->ForCells(e.left, e.top, e.right, e.bottom, [&e](std::vector<Entry> &cell) {
+			cell.push_back(e);
+		});
+	}
+
+	/**
+	 * Remove an item. Nothing happens when the item is not in the index, like for
+	 * items removed while loading a game, before the index is built for it.
+	 * @param area Area the item was added with.
+	 * @param item The item.
+	 */
+	void Remove(const TileArea &area, T item)
+	{
+		uint right = TileX(area.tile) + area.w - 1;
+		uint bottom = TileY(area.tile) + area.h - 1;
+		if (right >> this->cell_bits >= this->columns || bottom >> this->cell_bits >= this->rows) return;
+
+		this->ForCells(TileX(area.tile), TileY(area.tile), right, bottom, [item](std::vector<Entry> &cell) {
+			auto it = std::find_if(cell.begin(), cell.end(), [item](const Entry &e) { return e.item == item; });
+			if (it == cell.end()) return;
+			*it = cell.back();
+			cell.pop_back();
+		});
+	}
+
+	/**
+	 * Find all items whose area overlaps a rectangle.
+	 * @param left Westmost X coordinate of the rectangle.
+	 * @param top Northmost Y coordinate of the rectangle.
+	 * @param right Eastmost X coordinate of the rectangle.
+	 * @param bottom Southmost Y coordinate of the rectangle.
+	 * @param proc Function called once for every found item; returning true stops the search.
+	 * @return True iff the search was stopped by \a proc.
+	 */
+	template <typename F>
+	bool FindInRect(uint left, uint top, uint right, uint bottom, F proc) const
+	{
+		right = min(right, MapMaxX());
+		bottom = min(bottom, MapMaxY());
+		if (left > right || top > bottom) return false;
+
+		for (uint cy = top >> this->cell_bits; cy <= bottom >> this->cell_bits; cy++) {
+			for (uint cx = left >> this->cell_bits; cx <= right >> this->cell_bits; cx++) {
+				for (const Entry &e : this->cells[cy * this->columns + cx]) {
+					if (e.right < left || e.left > right || e.bottom < top || e.top > bottom) continue;
+
+					/* Only report the item in the cell with the north corner of its overlap with the rectangle. */
+					if ((max<uint>(e.left, left) >> this->cell_bits) != cx || (max<uint>(e.top, top) >> this->cell_bits) != cy) continue;
+
+					if (proc(e.item)) return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Find all items whose area overlaps a square around a tile.
+	 * @param tile Center of the square.
+	 * @param radius Maximum distance along either axis to the tile.
+	 * @param proc Function called once for every found item; returning true stops the search.
+	 * @return True iff the search was stopped by \a proc.
+	 */
+	template <typename F>
+	bool FindAround(TileIndex tile, uint radius, F proc) const
+	{
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		return this->FindInRect(x > radius ? x - radius : 0, y > radius ? y - radius : 0, x + radius, y + radius, proc);
+	}
+
+	/**
+	 * Find the item with its north tile closest to a tile, by Manhattan distance.
+	 * Of multiple items at the same distance the one with the lowest identifier is returned,
+	 * like when going over all items of a pool in order.
+	 * @param tile Tile to search from.
+	 * @param threshold Only find items closer than this.
+	 * @param none Value to return when there is no item closer than \a threshold.
+	 * @param get_tile Function returning the north tile of an item.
+	 * @return The closest item.
+	 */
+	template <typename F>
+	T FindNearest(TileIndex tile, uint threshold, T none, F get_tile) const
+	{
+		T best_item = none;
+		uint best = threshold;
+		uint max_radius = min(threshold, max(MapSizeX(), MapSizeY()));
+
+		/* Look in growing squares around the tile. An item outside a square is further
+		 * away than the square's radius, so once the best item is within that it is final. */
+		for (uint radius = 1 << this->cell_bits;; radius *= 2) {
+			this->FindAround(tile, radius, [&](T item) {
+				uint dist = DistanceManhattan(tile, get_tile(item));
+				if (dist < best || (dist == best && dist < threshold && item < best_item)) {
+					best = dist;
+					best_item = item;
+				}
+				return false;
+			});
+			if (best <= radius || radius >= max_radius) return best_item;
+		}
+	}
+};
+
+#endif /* TILE_GRID_INDEX_H */
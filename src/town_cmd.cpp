@@ -51,15 +51,22 @@
 #include "zoom_func.h"
 #include "zoning.h"
 #include "scope.h"
+#include "tile_grid_index.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
 
+#include <vector>
+#include <algorithm>
+
 #include "safeguards.h"
 
 TownID _new_town_id;
 CargoTypes _town_cargoes_accepted; ///< Bitmap of all cargoes accepted by houses.
 
+/** Spatial index of the centre tiles of all towns. */
+static TileGridIndex<TownID> _town_grid(5);
+
 /* Initialize the town-pool */
 TownPool _town_pool("Town");
 INSTANTIATE_POOL_METHODS(Town)
@@ -109,6 +116,7 @@ Town::~Town()
 	DeleteSubsidyWith(ST_TOWN, this->index);
 	DeleteNewGRFInspectWindow(GSF_FAKE_TOWNS, this->index);
 	CargoPacket::InvalidateAllFrom(ST_TOWN, this->index);
+	_town_grid.Remove(TileArea(this->xy, 1, 1), this->index);
 	MarkWholeScreenDirty();
 }
 
@@ -450,30 +458,21 @@ static void AnimateTile_Town(TileIndex tile)
  */
 static bool IsCloseToTown(TileIndex tile, uint dist)
 {
-	/* On a large map with many towns, it may be faster to check the surroundings of the tile.
-	 * An iteration in TILE_AREA_LOOP() is generally 2 times faster than one in FOR_ALL_TOWNS(). */
-	if (Town::GetNumItems() > (size_t) (dist * dist * 2)) {
-		const int tx = TileX(tile);
-		const int ty = TileY(tile);
-		TileArea tile_area = TileArea(
-			TileXY(max(0,         tx - (int) dist), max(0,         ty - (int) dist)),
-			TileXY(min(MapMaxX(), tx + (int) dist), min(MapMaxY(), ty + (int) dist))
-		);
-		TILE_AREA_LOOP(atile, tile_area) {
-			if (GetTileType(atile) == MP_HOUSE) {
-				Town *t = Town::GetByTile(atile);
-				if (DistanceManhattan(tile, t->xy) < dist) return true;
-			}
-		}
-		return false;
-	}
+	if (dist == 0) return false;
 
-	const Town *t;
+	/* Towns closer than dist by Manhattan distance are at most dist - 1 tiles away along either axis. */
+	return _town_grid.FindAround(tile, dist - 1, [tile, dist](TownID id) {
+		return DistanceManhattan(tile, Town::Get(id)->xy) < dist;
+	});
+}
 
-	FOR_ALL_TOWNS(t) {
-		if (DistanceManhattan(tile, t->xy) < dist) return true;
-	}
-	return false;
+/** Rebuild the spatial index of the towns, after loading a game or starting a new one. */
+void RebuildTownGridIndex()
+{
+	_town_grid.Reset();
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) _town_grid.Insert(TileArea(t->xy, 1, 1), t->index);
 }
 
 /**
@@ -565,6 +564,75 @@ static void MakeTownHouseBigger(TileIndex tile)
 	if (flags & BUILDING_HAS_4_TILES) MakeSingleHouseBigger(TILE_ADDXY(tile, 1, 1));
 }
 
+/** Cargo produced by the houses of a town for the same stations, during a run of the tile loop. */
+struct HouseCargoBatch {
+	TownID town;   ///< Town of the houses.
+	CargoID cargo; ///< Produced cargo.
+	uint amount;   ///< Produced amount.
+	uint first;    ///< Index of the first station in #_house_cargo_batch_stations.
+	uint count;    ///< Number of stations.
+};
+
+static std::vector<HouseCargoBatch> _house_cargo_batches; ///< Cargo produced by houses in the current run of the tile loop.
+static std::vector<StationID> _house_cargo_batch_stations; ///< Stations around the houses of the batches.
+
+/**
+ * Move cargo produced by a house to the stations around it.
+ * When batching town cargo, the cargo is only moved at the end of the tile loop, together with
+ * the cargo of all other houses of the town around the same stations.
+ * @param t The town of the house.
+ * @param ct Type of the cargo.
+ * @param amount Amount of cargo.
+ * @param stations The stations around the house.
+ * @return Amount of cargo moved now.
+ */
+static uint MoveHouseCargoToStations(Town *t, CargoID ct, uint amount, StationFinder &stations)
+{
+	const StationList *list = stations.GetStations();
+	if (!_settings_game.economy.town_cargo_batching) return MoveGoodsToStation(ct, amount, ST_TOWN, t->index, list);
+	if (list->Length() == 0) return 0;
+
+	HouseCargoBatch batch = { t->index, ct, amount, (uint)_house_cargo_batch_stations.size(), list->Length() };
+	for (const Station * const *st = list->Begin(); st != list->End(); st++) _house_cargo_batch_stations.push_back((*st)->index);
+	_house_cargo_batches.push_back(batch);
+	return 0;
+}
+
+/**
+ * Move the cargo produced by houses in the current run of the tile loop to the stations.
+ * The cargo of houses of the same town around the same stations is moved at once.
+ */
+void FlushHouseCargoBatches()
+{
+	if (_house_cargo_batches.empty()) return;
+
+	/* Order the batches so the ones to combine are next to each other. */
+	auto less = [](const HouseCargoBatch &a, const HouseCargoBatch &b) {
+		if (a.town != b.town) return a.town < b.town;
+		if (a.cargo != b.cargo) return a.cargo < b.cargo;
+		return std::lexicographical_compare(_house_cargo_batch_stations.begin() + a.first, _house_cargo_batch_stations.begin() + a.first + a.count,
+				_house_cargo_batch_stations.begin() + b.first, _house_cargo_batch_stations.begin() + b.first + b.count);
+	};
+	std::sort(_house_cargo_batches.begin(), _house_cargo_batches.end(), less);
+
+	StationList stations;
+	for (auto it = _house_cargo_batches.begin(); it != _house_cargo_batches.end();) {
+		uint amount = 0;
+		auto end = it;
+		for (; end != _house_cargo_batches.end() && !less(*it, *end); ++end) amount += end->amount;
+
+		stations.Clear();
+		for (uint i = it->first; i < it->first + it->count; i++) *stations.Append() = Station::Get(_house_cargo_batch_stations[i]);
+
+		Town *t = Town::Get(it->town);
+		t->supplied[it->cargo].new_act += MoveGoodsToStation(it->cargo, amount, ST_TOWN, t->index, &stations);
+		it = end;
+	}
+
+	_house_cargo_batches.clear();
+	_house_cargo_batch_stations.clear();
+}
+
 /**
  * Generate cargo for a town (house).
  *
@@ -620,13 +688,13 @@ static void TownGenerateCargo (Town *t, CargoID ct, uint amount, StationFinder &
 		case CT_PASSENGERS:
 		case CT_MAIL:
 			t->supplied[ct].new_max += amount;
-			t->supplied[ct].new_act += MoveGoodsToStation(ct, amount, ST_TOWN, t->index, stations.GetStations());
+			t->supplied[ct].new_act += MoveHouseCargoToStations(t, ct, amount, stations);
 			break;
 
 		default: {
 			const CargoSpec *cs = CargoSpec::Get(ct);
 			t->supplied[cs->Index()].new_max += amount;
-			t->supplied[cs->Index()].new_act += MoveGoodsToStation(ct, amount, ST_TOWN, t->index, stations.GetStations());
+			t->supplied[cs->Index()].new_act += MoveHouseCargoToStations(t, ct, amount, stations);
 			break;
 		}
 	}
@@ -1773,6 +1841,7 @@ static void UpdateTownGrowth(Town *t);
 static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize size, bool city, TownLayout layout, bool manual)
 {
 	t->xy = tile;
+	_town_grid.Insert(TileArea(tile, 1, 1), t->index);
 	t->cache.num_houses = 0;
 	t->time_until_rebuild = 10;
 	UpdateTownRadius(t);
@@ -3590,19 +3659,8 @@ CommandCost CheckIfAuthorityAllowsNewStation(TileIndex tile, DoCommandFlag flags
  */
 Town *CalcClosestTownFromTile(TileIndex tile, uint threshold)
 {
-	Town *t;
-	uint best = threshold;
-	Town *best_town = NULL;
-
-	FOR_ALL_TOWNS(t) {
-		uint dist = DistanceManhattan(tile, t->xy);
-		if (dist < best) {
-			best = dist;
-			best_town = t;
-		}
-	}
-
-	return best_town;
+	TownID best = _town_grid.FindNearest(tile, threshold, INVALID_TOWN, [](TownID id) { return Town::Get(id)->xy; });
+	return best == INVALID_TOWN ? NULL : Town::Get(best);
 }
 
 /**
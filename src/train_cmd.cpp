@@ -2757,6 +2757,8 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  */
 static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
 {
+	PerformanceZoneMeasurer zone(PFZ_TRAIN_PATHFINDER);
+
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
 		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
@@ -3832,6 +3834,8 @@ uint16 ReversingDistanceTargetSpeed(const Train *v)
  */
 bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 {
+	PerformanceZoneMeasurer zone(PFZ_TRAIN_CONTROLLER);
+
 	Train *first = v->First();
 	Train *prev;
 	bool direction_changed = false; // has direction of any part changed?
@@ -1472,6 +1472,49 @@ void ViewportAddVehicles(DrawPixelInfo *dpi)
 	}
 }
 
+/**
+ * Request the sprites of the vehicles at a part of the screen to be decoded in the background,
+ * for the directions they face after their next turn.
+ * @param dpi Rectangle being drawn.
+ */
+void ViewportPrefetchVehicleSprites(const DrawPixelInfo *dpi)
+{
+	/* The bounding rectangle */
+	const int l = dpi->left;
+	const int r = dpi->left + dpi->width;
+	const int t = dpi->top;
+	const int b = dpi->top + dpi->height;
+
+	/* The hash area to scan */
+	const ViewportHashBound vhb = GetViewportHashBound(l, r, t, b);
+
+	for (int y = vhb.yl;; y = (y + (1 << 6)) & (0x3F << 6)) {
+		for (int x = vhb.xl;; x = (x + 1) & 0x3F) {
+			const Vehicle *v = _vehicle_viewport_hash[x + y]; // already masked & 0xFFF
+
+			while (v != NULL) {
+				if (v->type != VEH_EFFECT && v->type != VEH_DISASTER && v->IsDrawn() &&
+						l <= v->coord.right &&
+						t <= v->coord.bottom &&
+						r >= v->coord.left &&
+						b >= v->coord.top) {
+					static const DirDiff turns[] = { DIRDIFF_45LEFT, DIRDIFF_45RIGHT };
+					for (DirDiff turn : turns) {
+						VehicleSpriteSeq seq;
+						v->GetImage(ChangeDir(v->direction, turn), EIT_ON_MAP, &seq);
+						for (uint i = 0; i < seq.count; i++) PrefetchSprite(seq.seq[i].sprite & SPRITE_MASK);
+					}
+				}
+				v = v->hash_viewport_next;
+			}
+
+			if (x == vhb.xu) break;
+		}
+
+		if (y == vhb.yu) break;
+	}
+}
+
 void ViewportMapDrawVehicles(DrawPixelInfo *dpi)
 {
 	/* The bounding rectangle */
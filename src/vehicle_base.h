@@ -24,6 +24,7 @@
 #include "group_type.h"
 #include "timetable.h"
 #include "base_consist.h"
+#include "newgrf_profiling.h"
 #include "network/network.h"
 #include <list>
 #include <map>
@@ -1241,14 +1242,20 @@ struct SpecializedVehicle : public Vehicle {
 			VehicleSpriteSeq seq;
 			((T *)this)->T::GetImage(this->direction, EIT_ON_MAP, &seq);
 			this->cur_image_valid_dir = _sprite_group_resolve_check_veh_check ? this->direction : INVALID_DIR;
+			if (_sprite_group_resolve_check_veh_check) {
+				_newgrf_result_cache_stats.vehicle_sprite_misses++;
+			} else {
+				_newgrf_result_cache_stats.vehicle_sprite_uncacheable++;
+			}
 			_sprite_group_resolve_check_veh_check = false;
 			if (force_update || this->sprite_seq != seq) {
 				this->sprite_seq = seq;
 				this->UpdateSpriteSeqBound();
 				this->Vehicle::UpdateViewport(true);
 			}
-		} else if (force_update) {
-			this->Vehicle::UpdateViewport(true);
+		} else {
+			_newgrf_result_cache_stats.vehicle_sprite_hits++;
+			if (force_update) this->Vehicle::UpdateViewport(true);
 		}
 	}
 };
@@ -58,6 +58,7 @@ void ResetVehicleColourMap();
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
 
 void ViewportAddVehicles(DrawPixelInfo *dpi);
+void ViewportPrefetchVehicleSprites(const DrawPixelInfo *dpi);
 void ViewportMapDrawVehicles(DrawPixelInfo *dpi);
 
 void ShowNewGrfVehicleError(EngineID engine, StringID part1, StringID part2, GRFBugs bug_type, bool critical);
@@ -12,6 +12,10 @@
 #include "../stdafx.h"
 #include "../gfx_func.h"
 #include "../blitter/factory.hpp"
+#include "../framerate_type.h"
+#include "../openttd.h"
+#include "../debug.h"
+#include "../string_func.h"
 #include "null_v.h"
 
 #include "../safeguards.h"
@@ -27,6 +31,11 @@ const char *VideoDriver_Null::Start(const char * const *parm)
 #endif
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
+	const char *benchmark = GetDriverParam(parm, "benchmark");
+	if (benchmark != NULL) {
+		if (StrEmpty(benchmark)) return "benchmark requires a report file name";
+		this->benchmark_report = benchmark;
+	}
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = NULL;
@@ -44,6 +53,11 @@ void VideoDriver_Null::MakeDirty(int left, int top, int width, int height) {}
 
 void VideoDriver_Null::MainLoop()
 {
+	if (!this->benchmark_report.empty()) {
+		this->RunBenchmark();
+		return;
+	}
+
 	uint i;
 
 	for (i = 0; i < this->ticks; i++) {
@@ -52,6 +66,38 @@ void VideoDriver_Null::MainLoop()
 	}
 }
 
+/**
+ * Run the configured number of ticks as fast as possible while recording
+ * all performance measurements, and write a report of them afterwards.
+ * Loading the game is done before the recording starts.
+ */
+void VideoDriver_Null::RunBenchmark()
+{
+	while (_switch_mode != SM_NONE) {
+		GameLoop();
+		UpdateWindows();
+	}
+
+	if (_pause_mode != PM_UNPAUSED) {
+		DEBUG(misc, 0, "Game is paused, unpausing it for the benchmark");
+		_pause_mode = PM_UNPAUSED;
+	}
+
+	DEBUG(misc, 0, "Running benchmark for %u ticks", this->ticks);
+	StartPerformanceRecording();
+	for (uint i = 0; i < this->ticks; i++) {
+		GameLoop();
+		UpdateWindows();
+	}
+	StopPerformanceRecording();
+
+	if (WritePerformanceReport(this->benchmark_report.c_str(), this->ticks)) {
+		DEBUG(misc, 0, "Benchmark report written to %s", this->benchmark_report.c_str());
+	} else {
+		DEBUG(misc, 0, "Failed to write benchmark report to %s", this->benchmark_report.c_str());
+	}
+}
+
 bool VideoDriver_Null::ChangeResolution(int w, int h) { return false; }
 
 bool VideoDriver_Null::ToggleFullscreen(bool fs) { return false; }
@@ -13,11 +13,15 @@
 #define VIDEO_NULL_H
 
 #include "video_driver.hpp"
+#include <string>
 
 /** The null video driver. */
 class VideoDriver_Null : public VideoDriver {
 private:
-	uint ticks; ///< Amount of ticks to run.
+	uint ticks;                   ///< Amount of ticks to run.
+	std::string benchmark_report; ///< File to write a benchmark report to, empty if not benchmarking.
+
+	void RunBenchmark();
 
 public:
 	/* virtual */ const char *Start(const char * const *param);
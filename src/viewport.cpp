@@ -67,6 +67,7 @@
 #include "tree_map.h"
 #include "industry.h"
 #include "smallmap_gui.h"
+#include "screenshot.h"
 #include "smallmap_colours.h"
 #include "table/tree_land.h"
 #include "blitter/32bpp_base.hpp"
@@ -105,12 +106,20 @@
 #include "gui.h"
 #include "core/container_func.hpp"
 #include "tunnelbridge_map.h"
+#include "newgrf_debug.h"
+#include "thread/thread_pool.h"
+#include "core/random_func.hpp"
+#include "string_func.h"
 
 #include <map>
 #include <vector>
+#include <stack>
+#include <forward_list>
 #include <math.h>
 #include <algorithm>
 #include <tuple>
+#include <memory>
+#include <chrono>
 
 #include "table/strings.h"
 #include "table/string_colours.h"
@@ -208,6 +217,7 @@ struct ViewportDrawer {
 	ParentSpriteToDrawVector parent_sprites_to_draw;
 	ParentSpriteToSortVector parent_sprites_to_sort; ///< Parent sprite pointer array used for sorting
 	ChildScreenSpriteToDrawVector child_screen_sprites_to_draw;
+	std::vector<ResolvedViewportSprite> resolved_sprites; ///< Sprites in drawing order, looked up for drawing by multiple threads.
 	TunnelBridgeToMapVector tunnel_to_map;
 	TunnelBridgeToMapVector bridge_to_map;
 
@@ -219,6 +229,8 @@ struct ViewportDrawer {
 	FoundationPart foundation_part;                  ///< Currently active foundation for ground sprite drawing.
 	int *last_foundation_child[FOUNDATION_PART_END]; ///< Tail of ChildSprite list of the foundations. (index into child_screen_sprites_to_draw)
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
+
+	bool prefetch;                                   ///< Only request the sprites to be decoded in the background instead of adding them. @see ViewportPrefetchArea
 };
 
 static void MarkViewportDirty(const ViewPort * const vp, int left, int top, int right, int bottom);
@@ -640,6 +652,11 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (_vd.prefetch) {
+		PrefetchSprite(image & SPRITE_MASK);
+		return;
+	}
+
 	TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Append();
 	ts->image = image;
 	ts->pal = pal;
@@ -816,6 +833,11 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	_vd.last_child = NULL;
 
+	if (_vd.prefetch) {
+		if (image != SPR_EMPTY_BOUNDING_BOX) PrefetchSprite(image & SPRITE_MASK);
+		return;
+	}
+
 	Point pt = RemapCoords(x, y, z);
 	int tmp_left, tmp_top, tmp_x = pt.x, tmp_y = pt.y;
 
@@ -868,7 +890,6 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 	ps->zmin = z + bb_offset_z;
 	ps->zmax = z + max(bb_offset_z, dz) - 1;
 
-	ps->comparison_done = false;
 	ps->first_child = -1;
 
 	_vd.last_child = &ps->first_child;
@@ -960,6 +981,11 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (_vd.prefetch) {
+		PrefetchSprite(image & SPRITE_MASK);
+		return;
+	}
+
 	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
 	if (_vd.last_child == NULL) return;
 
@@ -1525,53 +1551,164 @@ static bool ViewportSortParentSpritesChecker()
 	return true;
 }
 
-/** Sort parent sprites pointer array */
+/**
+ * Check whether sprite \a p has to be drawn before sprite \a s.
+ * @param p The sprite that might be behind.
+ * @param s The sprite that might be in front.
+ * @return True iff \a p is behind \a s.
+ */
+static inline bool ViewportSpriteIsBehind(const ParentSpriteToDraw *p, const ParentSpriteToDraw *s)
+{
+	/* We only change the order, if it is definite.
+	 * I.e. every single order of X, Y, Z says p is behind s or they overlap.
+	 * That is: If one partial order says s behind p, do not change the order.
+	 */
+	if (s->xmax < p->xmin || s->ymax < p->ymin || s->zmax < p->zmin) return false;
+
+	/* Decide which comparator to use, based on whether the bounding boxes overlap. */
+	if (s->xmin <= p->xmax && // overlap in X?
+			s->ymin <= p->ymax && // overlap in Y?
+			s->zmin <= p->zmax) { // overlap in Z?
+		/* Use X+Y+Z as the sorting order, so sprites closer to the bottom of
+		 * the screen and with higher Z elevation, are drawn in front.
+		 * Here X,Y,Z are the coordinates of the "center of mass" of the sprite,
+		 * i.e. X=(left+right)/2, etc.
+		 * However, since we only care about order, don't actually divide / 2
+		 */
+		return s->xmin + s->xmax + s->ymin + s->ymax + s->zmin + s->zmax >
+				p->xmin + p->xmax + p->ymin + p->ymax + p->zmin + p->zmax;
+	}
+	return true;
+}
+
+/**
+ * Sort parent sprites pointer array, in exactly the same order as #ViewportSortParentSpritesReference.
+ * Every sprite is moved in front of the sprites that have to be drawn before it,
+ * but instead of comparing every pair of sprites only the sprites whose bounding
+ * box starts before the end of the current one are considered. To find those fast
+ * the sprites are kept in a list sorted by xmin + ymin.
+ * The sprites are mostly in the right order already, so only few of them need to
+ * be moved; the pending ones are kept on a stack.
+ */
 static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
+{
+	if (psdv->Length() < 2) return;
+
+	/* Special values of ParentSpriteToDraw::order for the sorting state. */
+	const uint32 ORDER_COMPARED = UINT32_MAX;     // Sprite was compared, but the sprites preceding it still need to be handled.
+	const uint32 ORDER_RETURNED = UINT32_MAX - 1; // Sprite is sorted; it may still be in the stack more than once.
+	std::stack<ParentSpriteToDraw *> sprite_order;
+	uint32 next_order = 0;
+
+	/* Sprites not yet compared, ordered by xmin + ymin. */
+	std::forward_list<std::pair<int64, ParentSpriteToDraw *>> sprite_list;
+
+	for (ParentSpriteToDraw **p = psdv->End(); p != psdv->Begin();) {
+		p--;
+		sprite_list.emplace_front((int64)(*p)->xmin + (*p)->ymin, *p);
+		sprite_order.push(*p);
+		(*p)->order = next_order++;
+	}
+	sprite_list.sort();
+
+	std::vector<ParentSpriteToDraw *> preceding; // Sprites that have to be drawn before the current one.
+	ParentSpriteToDraw **out = psdv->Begin();
+
+	while (!sprite_order.empty()) {
+		ParentSpriteToDraw *s = sprite_order.top();
+		sprite_order.pop();
+
+		/* Sprite is already sorted, ignore it. */
+		if (s->order == ORDER_RETURNED) continue;
+
+		/* Sprite was already compared, just need to output it. */
+		if (s->order == ORDER_COMPARED) {
+			*(out++) = s;
+			s->order = ORDER_RETURNED;
+			continue;
+		}
+
+		preceding.clear();
+
+		/* Only sprites with xmin <= s->xmax && ymin <= s->ymax can be behind s,
+		 * so iterate the sprites with xmin + ymin <= s->xmax + s->ymax and filter
+		 * the others out later. The minimum coordinates can be larger than the
+		 * maximum ones, so also make sure s itself is found to remove it from the list. */
+		const int64 ssum = (int64)max(s->xmax, s->xmin) + max(s->ymax, s->ymin);
+		std::forward_list<std::pair<int64, ParentSpriteToDraw *>>::iterator prev = sprite_list.before_begin();
+		std::forward_list<std::pair<int64, ParentSpriteToDraw *>>::iterator x = sprite_list.begin();
+		while (x != sprite_list.end() && x->first <= ssum) {
+			ParentSpriteToDraw *p = x->second;
+			if (p == s) {
+				/* We found the current sprite, remove it and move on. */
+				x = sprite_list.erase_after(prev);
+				continue;
+			}
+
+			prev = x++;
+
+			if (ViewportSpriteIsBehind(p, s)) preceding.push_back(p);
+		}
+
+		if (preceding.empty()) {
+			/* No preceding sprites, add current one to the output. */
+			*(out++) = s;
+			s->order = ORDER_RETURNED;
+			continue;
+		}
+
+		/* The original sorter moves the preceding sprites in front of s one by one, in the order
+		 * they have in the array, so the last one ends up first. The order of a sprite is higher
+		 * when it is nearer to the front of the array, so push them in descending order. Sprites
+		 * are never skipped here, even when none of the other sprites can be behind them: they
+		 * still have to be compared with the other sprites, to keep exactly the original order. */
+		std::sort(preceding.begin(), preceding.end(), [](const ParentSpriteToDraw *a, const ParentSpriteToDraw *b) {
+			return a->order > b->order;
+		});
+
+		s->order = ORDER_COMPARED;
+		sprite_order.push(s); // Still needs to be output, after the preceding ones.
+
+		for (ParentSpriteToDraw *p : preceding) {
+			p->order = next_order++;
+			sprite_order.push(p);
+		}
+	}
+}
+
+/**
+ * Number of sprites from which #ViewportSortParentSprites is faster than the sorters that compare every pair
+ * of sprites, including the SSE4.1 one. Below it the sorter chosen by #InitializeSpriteSorter is used.
+ * All sorters give the same order, so they can be mixed; see #CheckViewportSpriteSorters.
+ */
+static const uint VP_BUCKETED_SORTER_MIN_SPRITES = 1000;
+
+/**
+ * The original parent sprite sorter, which compares every pair of sprites.
+ * It is the fallback when the SSE4.1 sorter is not available. The other sorters have to
+ * sort the sprites in exactly the same order, see #CheckViewportSpriteSorters.
+ */
+static void ViewportSortParentSpritesReference(ParentSpriteToSortVector *psdv)
 {
 	ParentSpriteToDraw **psdvend = psdv->End();
 	ParentSpriteToDraw **psd = psdv->Begin();
+	for (ParentSpriteToDraw **it = psd; it != psdvend; it++) (*it)->order = 0;
+
 	while (psd != psdvend) {
 		ParentSpriteToDraw *ps = *psd;
 
-		if (ps->comparison_done) {
+		if (ps->order != 0) {
 			psd++;
 			continue;
 		}
 
-		ps->comparison_done = true;
+		ps->order = 1;
 
 		for (ParentSpriteToDraw **psd2 = psd + 1; psd2 != psdvend; psd2++) {
 			ParentSpriteToDraw *ps2 = *psd2;
 
-			if (ps2->comparison_done) continue;
-
-			/* Decide which comparator to use, based on whether the bounding
-			 * boxes overlap
-			 */
-			if (ps->xmax >= ps2->xmin && ps->xmin <= ps2->xmax && // overlap in X?
-					ps->ymax >= ps2->ymin && ps->ymin <= ps2->ymax && // overlap in Y?
-					ps->zmax >= ps2->zmin && ps->zmin <= ps2->zmax) { // overlap in Z?
-				/* Use X+Y+Z as the sorting order, so sprites closer to the bottom of
-				 * the screen and with higher Z elevation, are drawn in front.
-				 * Here X,Y,Z are the coordinates of the "center of mass" of the sprite,
-				 * i.e. X=(left+right)/2, etc.
-				 * However, since we only care about order, don't actually divide / 2
-				 */
-				if (ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax <=
-						ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax) {
-					continue;
-				}
-			} else {
-				/* We only change the order, if it is definite.
-				 * I.e. every single order of X, Y, Z says ps2 is behind ps or they overlap.
-				 * That is: If one partial order says ps behind ps2, do not change the order.
-				 */
-				if (ps->xmax < ps2->xmin ||
-						ps->ymax < ps2->ymin ||
-						ps->zmax < ps2->zmin) {
-					continue;
-				}
-			}
+			if (ps2->order != 0) continue;
+			if (!ViewportSpriteIsBehind(ps2, ps)) continue;
 
 			/* Move ps2 in front of ps */
 			ParentSpriteToDraw *temp = ps2;
@@ -1599,6 +1736,93 @@ static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const
 	}
 }
 
+static ThreadPool _viewport_draw_pool("ottd:viewport"); ///< Threads for drawing viewport sprites.
+static const int VIEWPORT_DRAW_MIN_BAND_HEIGHT = 32;       ///< Minimum height in pixels of the band drawn by a single thread.
+static const uint VIEWPORT_DRAW_MIN_PARALLEL_SPRITES = 256; ///< Minimum number of sprites before drawing them is split over multiple threads.
+
+/** Horizontal bands of a viewport area in which the resolved sprites are drawn in parallel. */
+struct ViewportDrawBands {
+	const DrawPixelInfo *dpi;                             ///< The whole area to draw in.
+	const std::vector<ResolvedViewportSprite> *sprites;  ///< The sprites to draw.
+	int height;                                           ///< Height of the area in pixels.
+	uint count;                                           ///< Number of bands.
+};
+
+/**
+ * Draw all resolved sprites which overlap a single band.
+ * @param data The ViewportDrawBands.
+ * @param index Index of the band to draw.
+ */
+static void ViewportDrawBand(void *data, uint index)
+{
+	const ViewportDrawBands *bands = (const ViewportDrawBands *)data;
+	int first = bands->height * index / bands->count;
+	int last = bands->height * (index + 1) / bands->count;
+
+	DrawPixelInfo dpi = *bands->dpi;
+	dpi.top += ScaleByZoom(first, dpi.zoom);
+	dpi.height = ScaleByZoom(last - first, dpi.zoom);
+	dpi.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(dpi.dst_ptr, 0, first);
+
+	for (const ResolvedViewportSprite &rs : *bands->sprites) {
+		int top = rs.y + rs.sprite->y_offs;
+		if (top >= dpi.top + dpi.height || top + rs.sprite->height <= dpi.top) continue;
+		DrawResolvedSpriteViewport(&dpi, &rs);
+	}
+}
+
+/**
+ * Draw the tile sprites and the sorted parent sprites with their child sprites.
+ * When there is enough to draw, the sprites are looked up on the main thread, after which
+ * the worker threads each draw all of them clipped to their own horizontal band of the area.
+ */
+static void ViewportDrawSprites()
+{
+	uint sprites = _vd.tile_sprites_to_draw.Length() + _vd.parent_sprites_to_sort.Length() + _vd.child_screen_sprites_to_draw.Length();
+	int height = UnScaleByZoom(_vd.dpi.height, _vd.dpi.zoom);
+	uint threads = _viewport_draw_pool.GetThreadCount();
+	uint bands = min<uint>(threads * 2, height / VIEWPORT_DRAW_MIN_BAND_HEIGHT);
+
+	/* The sprite picker is not thread safe. */
+	if (threads < 2 || bands < 2 || sprites < VIEWPORT_DRAW_MIN_PARALLEL_SPRITES || _newgrf_debug_sprite_picker.mode == SPM_REDRAW) {
+		if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		return;
+	}
+
+	/* Looking up sprites may load them into the sprite cache, so do it all before starting the threads. */
+	std::vector<ResolvedViewportSprite> &resolved = _vd.resolved_sprites;
+	resolved.reserve(sprites);
+
+	const TileSpriteToDraw *tsend = _vd.tile_sprites_to_draw.End();
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != tsend; ++ts) {
+		resolved.emplace_back();
+		ResolveSpriteViewport(&resolved.back(), ts->image, ts->pal, ts->x, ts->y, ts->sub);
+	}
+
+	const ParentSpriteToDraw * const *psd_end = _vd.parent_sprites_to_sort.End();
+	for (const ParentSpriteToDraw * const *it = _vd.parent_sprites_to_sort.Begin(); it != psd_end; it++) {
+		const ParentSpriteToDraw *ps = *it;
+		if (ps->image != SPR_EMPTY_BOUNDING_BOX) {
+			resolved.emplace_back();
+			ResolveSpriteViewport(&resolved.back(), ps->image, ps->pal, ps->x, ps->y, ps->sub);
+		}
+
+		int child_idx = ps->first_child;
+		while (child_idx >= 0) {
+			const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Get(child_idx);
+			child_idx = cs->next;
+			resolved.emplace_back();
+			ResolveSpriteViewport(&resolved.back(), cs->image, cs->pal, ps->left + cs->x, ps->top + cs->y, cs->sub);
+		}
+	}
+
+	ViewportDrawBands data = { &_vd.dpi, &resolved, height, bands };
+	_viewport_draw_pool.Run(&ViewportDrawBand, &data, bands);
+
+	resolved.clear();
+}
+
 /**
  * Draws the bounding boxes of all ParentSprites
  * @param psd Array of ParentSprites
@@ -1620,11 +1844,50 @@ static void ViewportDrawBoundingBoxes(const ParentSpriteToSortVector *psd)
 	}
 }
 
+static const int VIEWPORT_MAP_CACHE_BLOCK_BITS = 6;                                 ///< Number of bits of the width and height of a block of a cached viewport map.
+static const int VIEWPORT_MAP_CACHE_BLOCK_SIZE = 1 << VIEWPORT_MAP_CACHE_BLOCK_BITS; ///< Width and height in pixels of a block of a cached viewport map.
+static const uint VIEWPORT_MAP_CACHE_MAX_BLOCKS = 4096;                             ///< Maximum number of cached blocks, each taking 16 KiB.
+
+/** A block of pixels of a rendered viewport map, with the tunnels and bridges found while rendering it. */
+struct ViewportMapCacheBlock {
+	uint32 pixels[VIEWPORT_MAP_CACHE_BLOCK_SIZE * VIEWPORT_MAP_CACHE_BLOCK_SIZE]; ///< Colours if 32bpp, palette indices if 8bpp.
+	std::vector<TileIndex> tunnel_bridge_tiles; ///< Tunnel and bridge tiles found while rendering the block.
+	std::vector<TileIndex> below_bridge_tiles;  ///< Tiles below a bridge found while rendering the block.
+};
+
+/** Rendered map of the viewports with a given zoom level and map type, in blocks at absolute pixel positions. */
+struct ViewportMapCache {
+	ZoomLevel zoom;                ///< Zoom level of the map.
+	ViewportMapType map_type;      ///< Type of the map.
+	std::map<uint64, std::unique_ptr<ViewportMapCacheBlock>> blocks; ///< Rendered blocks, by block X in the upper and block Y in the lower 32 bits.
+};
+
+static std::vector<ViewportMapCache> _vp_map_caches;                  ///< Cached maps, one for each zoom level and map type in use.
+static uint32 _vp_map_cache_state = 0;                                ///< Settings and legends the cached maps were rendered with, see #GetViewportMapCacheState.
+static uint _vp_map_cache_blocks = 0;                                 ///< Number of cached blocks of all maps.
+static ViewportMapCacheBlock *_vp_map_cache_rendering_block = NULL;   ///< Block being rendered, which records the tunnels and bridges found.
+
+/**
+ * Record a tile in the block of the map being rendered, skipping it when it was the previous tile recorded.
+ * @param tiles The tiles of the block.
+ * @param tile The tile to record.
+ */
+static inline void ViewportMapCacheRecordTile(std::vector<TileIndex> &tiles, TileIndex tile)
+{
+	if (tiles.empty() || tiles.back() != tile) tiles.push_back(tile);
+}
+
 static void ViewportMapStoreBridgeTunnel(const ViewPort * const vp, const TileIndex tile)
 {
 	extern LegendAndColour _legend_land_owners[NUM_NO_COMPANY_ENTRIES + MAX_COMPANIES + 1];
 	extern uint _company_to_list_pos[MAX_COMPANIES];
 
+	/* Rendering a cached block; the tile is stored each time the block is drawn. */
+	if (_vp_map_cache_rendering_block != NULL) {
+		ViewportMapCacheRecordTile(_vp_map_cache_rendering_block->tunnel_bridge_tiles, tile);
+		return;
+	}
+
 	/* No need to bother for hidden things */
 	const bool tile_is_tunnel = IsTunnel(tile);
 	if (tile_is_tunnel) {
@@ -2255,6 +2518,12 @@ static inline uint32 ViewportMapGetColourOwner(const TileIndex tile, TileType t,
 
 static inline void ViewportMapStoreBridgeAboveTile(const ViewPort * const vp, const TileIndex tile)
 {
+	/* Rendering a cached block; the tile is stored each time the block is drawn. */
+	if (_vp_map_cache_rendering_block != NULL) {
+		ViewportMapCacheRecordTile(_vp_map_cache_rendering_block->below_bridge_tiles, tile);
+		return;
+	}
+
 	/* No need to bother for hidden things */
 	if (!_settings_client.gui.show_bridges_on_map) return;
 
@@ -2436,8 +2705,6 @@ static void ViewportMapDrawScrollingViewportBox(const ViewPort * const vp)
 	}
 }
 
-uint32 *_vp_map_line; ///< Buffer for drawing the map of a viewport.
-
 static void ViewportMapDrawBridgeTunnel(const ViewPort * const vp, const TunnelBridgeToMap * const tbtm, const int z,
 		const bool is_tunnel, const int w, const int h, Blitter * const blitter)
 {
@@ -2467,63 +2734,202 @@ static void ViewportMapDrawBridgeTunnel(const ViewPort * const vp, const TunnelB
 	}
 }
 
-/** Draw the map on a viewport. */
-template <bool is_32bpp, bool show_slope>
-void ViewportMapDraw(const ViewPort * const vp)
+/**
+ * Get the state of the settings and legends which influence the colours of the viewport map.
+ * @param is_32bpp Whether the map is rendered in 32bpp.
+ * @param show_slope Whether slopes are shown.
+ * @return Hash of the state.
+ */
+static uint32 GetViewportMapCacheState(bool is_32bpp, bool show_slope)
 {
-	assert(vp != NULL);
-	Blitter * const blitter = BlitterFactory::GetCurrentBlitter();
+	extern LegendAndColour _legend_land_owners[NUM_NO_COMPANY_ENTRIES + MAX_COMPANIES + 1];
+	extern LegendAndColour _legend_from_industries[NUM_INDUSTRYTYPES + 1];
+	extern bool _smallmap_show_heightmap;
 
-	SmallMapWindow::RebuildColourIndexIfNecessary();
+	uint32 state = (is_32bpp ? 1 : 0) | (show_slope ? 2 : 0) | (_smallmap_show_heightmap ? 4 : 0) |
+			(_settings_client.gui.viewport_map_scan_surroundings ? 8 : 0) |
+			(IsTransparencySet(TO_TREES) ? 16 : 0) | (IsInvisibilitySet(TO_TREES) ? 32 : 0) |
+			(_settings_client.gui.smallmap_land_colour << 8) | (_settings_game.construction.max_heightlevel << 16);
+	for (const LegendAndColour &lc : _legend_land_owners) state = state * 31 + (lc.colour << 1 | lc.show_on_map);
+	for (const LegendAndColour &lc : _legend_from_industries) state = state * 31 + lc.show_on_map;
+	return state * 31 + MapSize();
+}
+
+/** Discard all cached viewport maps. */
+void ViewportMapClearCache()
+{
+	_vp_map_caches.clear();
+	_vp_map_cache_blocks = 0;
+}
 
+/**
+ * Discard the blocks of the cached viewport maps which may show a tile.
+ * @param tile The tile that changed.
+ */
+static void ViewportMapInvalidateCacheByTile(const TileIndex tile)
+{
+	for (ViewportMapCache &cache : _vp_map_caches) {
+		if (cache.blocks.empty()) continue;
+
+		/* The tile shown by a pixel is found using an approximated height, and
+		 * when scanning the surroundings it is the most important tile of an area
+		 * starting at that tile. So be generous about the pixels which may show it. */
+		const int area = (cache.zoom > ZOOM_LVL_OUT_128X) ? (cache.zoom - ZOOM_LVL_OUT_128X) * 2 : 0;
+		const Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, 0);
+		const int left   = pt.x - (area + 1) * TILE_SIZE * 2 * ZOOM_LVL_BASE;
+		const int right  = pt.x + (area + 1) * TILE_SIZE * 2 * ZOOM_LVL_BASE;
+		const int top    = pt.y - ((area + 1) * TILE_SIZE * 2 + _settings_game.construction.max_heightlevel * TILE_HEIGHT) * ZOOM_LVL_BASE;
+		const int bottom = pt.y + TILE_SIZE * 2 * ZOOM_LVL_BASE;
+
+		const int bx_end = UnScaleByZoom(right, cache.zoom) >> VIEWPORT_MAP_CACHE_BLOCK_BITS;
+		const int by_end = UnScaleByZoom(bottom, cache.zoom) >> VIEWPORT_MAP_CACHE_BLOCK_BITS;
+		for (int bx = UnScaleByZoomLower(left, cache.zoom) >> VIEWPORT_MAP_CACHE_BLOCK_BITS; bx <= bx_end; bx++) {
+			for (int by = UnScaleByZoomLower(top, cache.zoom) >> VIEWPORT_MAP_CACHE_BLOCK_BITS; by <= by_end; by++) {
+				_vp_map_cache_blocks -= (uint)cache.blocks.erase((uint64)(uint32)bx << 32 | (uint32)by);
+			}
+		}
+	}
+}
+
+/**
+ * Render a block of the map of a viewport for the cache.
+ * @param vp The viewport.
+ * @param bx X position of the block, in blocks.
+ * @param by Y position of the block, in blocks.
+ * @param block The block to render into.
+ */
+template <bool is_32bpp, bool show_slope>
+static void ViewportMapRenderBlock(const ViewPort * const vp, int bx, int by, ViewportMapCacheBlock *block)
+{
 	/* Index of colour: _green_map_heights[] contains blocks of 4 colours, say ABCD
 	 * For a XXXY colour block to render nicely, follow the model:
 	 *   line 1: ABCDABCDABCD
 	 *   line 2: CDABCDABCDAB
 	 *   line 3: ABCDABCDABCD
 	 * => colour_index_base's second bit is changed every new line.
+	 * The pixel positions are absolute, so the result does not depend on which part of the viewport is drawn.
 	 */
-	const  int sx = UnScaleByZoomLower(_vd.dpi.left, _vd.dpi.zoom);
-	const  int sy = UnScaleByZoomLower(_vd.dpi.top, _vd.dpi.zoom);
-	const uint line_padding = 2 * (sy & 1);
-	uint       colour_index_base = (sx + line_padding) & 3;
-
-	const  int incr_a = (1 << (vp->zoom - 2)) / ZOOM_LVL_BASE;
-	const  int incr_b = (1 << (vp->zoom - 1)) / ZOOM_LVL_BASE;
-	const  int a = (_vd.dpi.left >> 2) / ZOOM_LVL_BASE;
-	int        b = (_vd.dpi.top >> 1) / ZOOM_LVL_BASE;
-	const  int w = UnScaleByZoom(_vd.dpi.width, vp->zoom);
-	const  int h = UnScaleByZoom(_vd.dpi.height, vp->zoom);
-	int        j = 0;
-
-	/* Render base map. */
-	do { // For each line
-		int i = w;
+	const int px = bx * VIEWPORT_MAP_CACHE_BLOCK_SIZE;
+	const int py = by * VIEWPORT_MAP_CACHE_BLOCK_SIZE;
+	uint colour_index_base = (px + 2 * (py & 1)) & 3;
+
+	const int incr_a = (1 << (vp->zoom - 2)) / ZOOM_LVL_BASE;
+	const int incr_b = (1 << (vp->zoom - 1)) / ZOOM_LVL_BASE;
+	const int a = (ScaleByZoom(px, vp->zoom) >> 2) / ZOOM_LVL_BASE;
+	int       b = (ScaleByZoom(py, vp->zoom) >> 1) / ZOOM_LVL_BASE;
+
+	_vp_map_cache_rendering_block = block;
+	uint32 *pixel = block->pixels;
+	for (int j = 0; j < VIEWPORT_MAP_CACHE_BLOCK_SIZE; j++) {
 		uint colour_index = colour_index_base;
 		colour_index_base ^= 2;
-		uint32 *vp_map_line_ptr32 = _vp_map_line;
-		uint8 *vp_map_line_ptr8 = (uint8*) _vp_map_line;
 		int c = b - a;
 		int d = b + a;
-		do { // For each pixel of a line
-			if (is_32bpp) {
-				*vp_map_line_ptr32 = ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
-				vp_map_line_ptr32++;
-			} else {
-				*vp_map_line_ptr8 = (uint8) ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
-				vp_map_line_ptr8++;
-			}
+		for (int i = 0; i < VIEWPORT_MAP_CACHE_BLOCK_SIZE; i++) {
+			*pixel++ = ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
 			colour_index = (colour_index + 1) & 3;
 			c -= incr_a;
 			d += incr_a;
-		} while (--i);
-		if (is_32bpp) {
-			blitter->SetLine32(_vd.dpi.dst_ptr, 0, j, _vp_map_line, w);
-		} else {
-			blitter->SetLine(_vd.dpi.dst_ptr, 0, j, (uint8*) _vp_map_line, w);
 		}
 		b += incr_b;
-	} while (++j < h);
+	}
+	_vp_map_cache_rendering_block = NULL;
+
+	for (std::vector<TileIndex> *tiles : { &block->tunnel_bridge_tiles, &block->below_bridge_tiles }) {
+		std::sort(tiles->begin(), tiles->end());
+		tiles->erase(std::unique(tiles->begin(), tiles->end()), tiles->end());
+		tiles->shrink_to_fit();
+	}
+}
+
+/**
+ * Draw the map on a viewport from the cached blocks, rendering the missing blocks.
+ * @param vp The viewport.
+ * @param w Width of the area to draw in pixels.
+ * @param h Height of the area to draw in pixels.
+ * @param blitter The blitter to draw with.
+ */
+template <bool is_32bpp, bool show_slope>
+static void ViewportMapDrawCached(const ViewPort * const vp, const int w, const int h, Blitter * const blitter)
+{
+	const uint32 state = GetViewportMapCacheState(is_32bpp, show_slope);
+	if (state != _vp_map_cache_state) {
+		ViewportMapClearCache();
+		_vp_map_cache_state = state;
+	}
+
+	ViewportMapCache *cache = NULL;
+	for (ViewportMapCache &it : _vp_map_caches) {
+		if (it.zoom == vp->zoom && it.map_type == vp->map_type) cache = &it;
+	}
+	if (cache == NULL) {
+		_vp_map_caches.emplace_back();
+		cache = &_vp_map_caches.back();
+		cache->zoom = vp->zoom;
+		cache->map_type = vp->map_type;
+	}
+
+	const int sx = UnScaleByZoomLower(_vd.dpi.left, _vd.dpi.zoom);
+	const int sy = UnScaleByZoomLower(_vd.dpi.top, _vd.dpi.zoom);
+	for (int by = sy >> VIEWPORT_MAP_CACHE_BLOCK_BITS; by <= (sy + h - 1) >> VIEWPORT_MAP_CACHE_BLOCK_BITS; by++) {
+		for (int bx = sx >> VIEWPORT_MAP_CACHE_BLOCK_BITS; bx <= (sx + w - 1) >> VIEWPORT_MAP_CACHE_BLOCK_BITS; bx++) {
+			const uint64 key = (uint64)(uint32)bx << 32 | (uint32)by;
+			auto it = cache->blocks.find(key);
+			if (it == cache->blocks.end()) {
+				if (_vp_map_cache_blocks >= VIEWPORT_MAP_CACHE_MAX_BLOCKS) {
+					/* Start over rather than keeping track of which blocks were used last; this
+					 * only happens with many map viewports, or after scrolling around a lot. */
+					for (ViewportMapCache &other : _vp_map_caches) other.blocks.clear();
+					_vp_map_cache_blocks = 0;
+				}
+				ViewportMapCacheBlock *new_block = new ViewportMapCacheBlock();
+				ViewportMapRenderBlock<is_32bpp, show_slope>(vp, bx, by, new_block);
+				it = cache->blocks.emplace(key, std::unique_ptr<ViewportMapCacheBlock>(new_block)).first;
+				_vp_map_cache_blocks++;
+			}
+			const ViewportMapCacheBlock *cached = it->second.get();
+
+			/* Copy the part of the block inside the drawing area. */
+			const int left   = max(sx, bx * VIEWPORT_MAP_CACHE_BLOCK_SIZE);
+			const int right  = min(sx + w, (bx + 1) * VIEWPORT_MAP_CACHE_BLOCK_SIZE);
+			const int top    = max(sy, by * VIEWPORT_MAP_CACHE_BLOCK_SIZE);
+			const int bottom = min(sy + h, (by + 1) * VIEWPORT_MAP_CACHE_BLOCK_SIZE);
+			for (int y = top; y < bottom; y++) {
+				const uint32 *src = cached->pixels + (y - by * VIEWPORT_MAP_CACHE_BLOCK_SIZE) * VIEWPORT_MAP_CACHE_BLOCK_SIZE + (left - bx * VIEWPORT_MAP_CACHE_BLOCK_SIZE);
+				if (is_32bpp) {
+					blitter->SetLine32(_vd.dpi.dst_ptr, left - sx, y - sy, const_cast<uint32 *>(src), right - left);
+				} else {
+					uint8 line[VIEWPORT_MAP_CACHE_BLOCK_SIZE];
+					for (int i = 0; i < right - left; i++) line[i] = (uint8)src[i];
+					blitter->SetLine(_vd.dpi.dst_ptr, left - sx, y - sy, line, right - left);
+				}
+			}
+
+			/* Store the tunnels and bridges, as when rendering. */
+			for (TileIndex tile : cached->tunnel_bridge_tiles) {
+				if (IsTileType(tile, MP_TUNNELBRIDGE)) ViewportMapStoreBridgeTunnel(vp, tile);
+			}
+			for (TileIndex tile : cached->below_bridge_tiles) {
+				if (!IsTileType(tile, MP_TUNNELBRIDGE) && IsBridgeAbove(tile)) ViewportMapStoreBridgeAboveTile(vp, tile);
+			}
+		}
+	}
+}
+
+/** Draw the map on a viewport. */
+template <bool is_32bpp, bool show_slope>
+void ViewportMapDraw(const ViewPort * const vp)
+{
+	assert(vp != NULL);
+	Blitter * const blitter = BlitterFactory::GetCurrentBlitter();
+
+	SmallMapWindow::RebuildColourIndexIfNecessary();
+
+	const int w = UnScaleByZoom(_vd.dpi.width, vp->zoom);
+	const int h = UnScaleByZoom(_vd.dpi.height, vp->zoom);
+
+	/* Render base map. */
+	ViewportMapDrawCached<is_32bpp, show_slope>(vp, w, h, blitter);
 
 	/* Render tunnels */
 	if (_settings_client.gui.show_tunnels_on_map && _vd.tunnel_to_map.Length() != 0) {
@@ -2607,15 +3013,17 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 		DrawTextEffects(&_vd.dpi);
 
-		if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
-
 		ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
 		for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
 			*_vd.parent_sprites_to_sort.Append() = it;
 		}
 
-		_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		if (_vd.parent_sprites_to_sort.Length() >= VP_BUCKETED_SORTER_MIN_SPRITES) {
+			ViewportSortParentSprites(&_vd.parent_sprites_to_sort);
+		} else {
+			_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+		}
+		ViewportDrawSprites();
 
 		if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
 	}
@@ -2834,6 +3242,133 @@ static inline void ClampViewportToMap(const ViewPort *vp, int &x, int &y)
 	y -= vp->virtual_height / 2;
 }
 
+/** Steps of prefetching the sprites around a viewport, one is done per call of #ViewportPrefetchSprites. */
+enum ViewportPrefetchStage {
+	VPS_BORDER,   ///< Tiles and vehicles just outside the viewport.
+	VPS_VEHICLES, ///< Visible vehicles when they turn.
+	VPS_ZOOM_OUT, ///< Area which becomes visible when zooming out.
+	VPS_DONE,     ///< Everything has been prefetched.
+};
+
+/** Width of the border around a viewport of which the sprites are prefetched, in pixels. */
+static const int VIEWPORT_PREFETCH_BORDER = 4 * TILE_PIXELS;
+
+/**
+ * Request the sprites of the tiles and vehicles in a part of a viewport to be decoded in the background, without drawing anything.
+ * @param vp The viewport.
+ * @param left Left edge of the area (virtual screen coordinates).
+ * @param top Top edge of the area (virtual screen coordinates).
+ * @param right Right edge of the area (virtual screen coordinates).
+ * @param bottom Bottom edge of the area (virtual screen coordinates).
+ */
+static void ViewportPrefetchArea(const ViewPort *vp, int left, int top, int right, int bottom)
+{
+	int mask = ScaleByZoom(-1, vp->zoom);
+	if (((right - left) & mask) <= 0 || ((bottom - top) & mask) <= 0) return;
+
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	_vd.dpi.zoom = vp->zoom;
+	_vd.dpi.width = (right - left) & mask;
+	_vd.dpi.height = (bottom - top) & mask;
+	_vd.dpi.left = left & mask;
+	_vd.dpi.top = top & mask;
+	_vd.dpi.dst_ptr = NULL;
+	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	_vd.last_child = NULL;
+	_vd.prefetch = true;
+
+	ViewportAddLandscape();
+	ViewportAddVehicles(&_vd.dpi);
+
+	_vd.prefetch = false;
+	_cur_dpi = old_dpi;
+
+	_vd.tunnel_to_map.Clear();
+	_vd.bridge_to_map.Clear();
+	_vd.string_sprites_to_draw.Clear();
+}
+
+/**
+ * Prefetch the sprites in the area between two nested rectangles.
+ * @param vp The viewport.
+ * @param inner The inner rectangle, which is skipped.
+ * @param outer The outer rectangle.
+ */
+static void ViewportPrefetchRing(const ViewPort *vp, const Rect &inner, const Rect &outer)
+{
+	ViewportPrefetchArea(vp, outer.left, outer.top, outer.right, inner.top);
+	ViewportPrefetchArea(vp, outer.left, inner.bottom, outer.right, outer.bottom);
+	ViewportPrefetchArea(vp, outer.left, inner.top, inner.left, inner.bottom);
+	ViewportPrefetchArea(vp, inner.right, inner.top, outer.right, inner.bottom);
+}
+
+/**
+ * Request the sprites which are likely to be drawn soon in a viewport to be decoded in the background,
+ * so scrolling, zooming out and turning vehicles do not have to wait for the sprites to be decoded.
+ * The border around the viewport is snapped to a grid, so the work is only redone after scrolling some distance.
+ * @param vp The viewport.
+ */
+static void ViewportPrefetchSprites(ViewportData *vp)
+{
+	if (vp->zoom >= ZOOM_LVL_DRAW_MAP) return;
+
+	const int grid = ScaleByZoom(VIEWPORT_PREFETCH_BORDER, vp->zoom);
+	auto snap = [grid](int v) { return v - (v % grid + grid) % grid; };
+
+	Rect visible;
+	visible.left   = vp->virtual_left;
+	visible.top    = vp->virtual_top;
+	visible.right  = vp->virtual_left + vp->virtual_width;
+	visible.bottom = vp->virtual_top + vp->virtual_height;
+
+	Rect area;
+	area.left   = snap(visible.left) - grid;
+	area.top    = snap(visible.top) - grid;
+	area.right  = snap(visible.right) + 2 * grid;
+	area.bottom = snap(visible.bottom) + 2 * grid;
+
+	if (area.left != vp->prefetch_area.left || area.top != vp->prefetch_area.top ||
+			area.right != vp->prefetch_area.right || area.bottom != vp->prefetch_area.bottom) {
+		vp->prefetch_area = area;
+		vp->prefetch_stage = VPS_BORDER;
+	}
+
+	switch (vp->prefetch_stage) {
+		case VPS_BORDER:
+			ViewportPrefetchRing(vp, visible, area);
+			break;
+
+		case VPS_VEHICLES: {
+			DrawPixelInfo dpi;
+			dpi.left = visible.left;
+			dpi.top = visible.top;
+			dpi.width = vp->virtual_width;
+			dpi.height = vp->virtual_height;
+			ViewportPrefetchVehicleSprites(&dpi);
+			break;
+		}
+
+		case VPS_ZOOM_OUT: {
+			if (vp->zoom + 1 >= ZOOM_LVL_DRAW_MAP || vp->zoom >= _settings_client.gui.zoom_max) break;
+
+			/* Zooming out keeps the centre of the viewport and doubles its virtual size. */
+			Rect outer;
+			outer.left   = min(area.left, visible.left - vp->virtual_width / 2);
+			outer.top    = min(area.top, visible.top - vp->virtual_height / 2);
+			outer.right  = max(area.right, visible.right + vp->virtual_width / 2);
+			outer.bottom = max(area.bottom, visible.bottom + vp->virtual_height / 2);
+			ViewportPrefetchRing(vp, area, outer);
+			break;
+		}
+
+		default:
+			return;
+	}
+	vp->prefetch_stage++;
+}
+
 /**
  * Update the viewport position being displayed.
  * @param w %Window owning the viewport.
@@ -2877,6 +3412,8 @@ void UpdateViewportPosition(Window *w)
 
 		SetViewportPosition(w, w->viewport->scrollpos_x, w->viewport->scrollpos_y, update_overlay);
 	}
+
+	ViewportPrefetchSprites(w->viewport);
 }
 
 void UpdateActiveScrollingViewport(Window *w)
@@ -3050,6 +3587,10 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below, int bridge_level_offset)
 {
+	if (mark_dirty_if_zoomlevel_is_below > ZOOM_LVL_DRAW_MAP && !_vp_map_caches.empty()) ViewportMapInvalidateCacheByTile(tile);
+	InvalidateSmallMapCacheTile(tile);
+	InvalidateMapTileExportTile(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, TilePixelHeight(tile));
 	MarkAllViewportsDirty(
 			pt.x - 31  * ZOOM_LVL_BASE,
@@ -4858,6 +5399,7 @@ Point GetViewportStationMiddle(const ViewPort *vp, const Station *st)
 
 /** Helper class for getting the best sprite sorter. */
 struct ViewportSSCSS {
+	const char *name;            ///< Name of the sorter, for #CheckViewportSpriteSorters.
 	VpSorterChecker fct_checker; ///< The check function.
 	VpSpriteSorter fct_sorter;   ///< The sorting function.
 };
@@ -4865,9 +5407,9 @@ struct ViewportSSCSS {
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
 #ifdef WITH_SSE
-	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
+	{ "sse4.1",   &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
 #endif
-	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSprites }
+	{ "original", &ViewportSortParentSpritesChecker, &ViewportSortParentSpritesReference },
 };
 
 /** Choose the "best" sprite sorter and set _vp_sprite_sorter. */
@@ -4882,6 +5424,322 @@ void InitializeSpriteSorter()
 	assert(_vp_sprite_sorter != NULL);
 }
 
+/** Sprite sets to check the sprite sorters with, see #CheckViewportSpriteSorters. */
+enum SpriteSorterCheckScene {
+	SSCS_DENSE_CITY,    ///< Houses, buildings in several parts, trees and road vehicles on two height levels.
+	SSCS_LARGE_STATION, ///< Station platforms with roofs, catenary and trains.
+	SSCS_BRIDGES,       ///< Hills with foundations, crossed by bridges with trains.
+	SSCS_END,           ///< End marker.
+};
+
+/**
+ * Add a sprite to a sprite sorter check scene, with the bounding box #AddSortableSpriteToDraw would give it.
+ * @param sprites The sprites of the scene.
+ * @param x, y, w, h, dz, z, bb_offset_x, bb_offset_y, bb_offset_z The bounding box, see #AddSortableSpriteToDraw.
+ */
+static void AddSpriteSorterCheckSprite(std::vector<ParentSpriteToDraw> &sprites, int x, int y, int w, int h, int dz, int z, int bb_offset_x = 0, int bb_offset_y = 0, int bb_offset_z = 0)
+{
+	sprites.emplace_back();
+	ParentSpriteToDraw &ps = sprites.back();
+	ps.xmin = x + bb_offset_x;
+	ps.xmax = x + max(bb_offset_x, w) - 1;
+	ps.ymin = y + bb_offset_y;
+	ps.ymax = y + max(bb_offset_y, h) - 1;
+	ps.zmin = z + bb_offset_z;
+	ps.zmax = z + max(bb_offset_z, dz) - 1;
+}
+
+/**
+ * Add a vehicle to a sprite sorter check scene, with the bounding box of a wagon or road vehicle.
+ * @param vehicles The vehicles of the scene.
+ * @param x X position of the vehicle.
+ * @param y Y position of the vehicle.
+ * @param z Z position of the vehicle.
+ * @param axis Direction the vehicle drives in.
+ * @param length Length of the vehicle.
+ */
+static void AddSpriteSorterCheckVehicle(std::vector<ParentSpriteToDraw> &vehicles, int x, int y, int z, Axis axis, int length = VEHICLE_LENGTH)
+{
+	if (axis == AXIS_X) {
+		AddSpriteSorterCheckSprite(vehicles, x - length / 2, y - 1, length, 3, 6, z);
+	} else {
+		AddSpriteSorterCheckSprite(vehicles, x - 1, y - length / 2, 3, length, 6, z);
+	}
+}
+
+/**
+ * Add a building drawn in several parts to a sprite sorter check scene, like the tile layouts
+ * of industries and NewGRF houses or stations often are. The bounding boxes of the parts overlap.
+ * @param sprites The sprites of the scene.
+ * @param r The randomizer of the scene.
+ * @param x X position of the tile.
+ * @param y Y position of the tile.
+ * @param z Height of the tile.
+ */
+static void AddSpriteSorterCheckBuilding(std::vector<ParentSpriteToDraw> &sprites, Randomizer &r, int x, int y, int z)
+{
+	for (uint i = r.Next(4) + 2; i > 0; i--) {
+		const int dx = r.Next(10);
+		const int dy = r.Next(10);
+		AddSpriteSorterCheckSprite(sprites, x + dx, y + dy, 3 + r.Next(TILE_SIZE - 2 - dx), 3 + r.Next(TILE_SIZE - 2 - dy), 5 + r.Next(30), z + r.Next(8));
+	}
+}
+
+/**
+ * Add the middle part of a bridge to a sprite sorter check scene, like DrawBridgeMiddle does.
+ * @param sprites The sprites of the scene.
+ * @param x X position of the tile.
+ * @param y Y position of the tile.
+ * @param z Height of the ground below the bridge.
+ * @param bridge_z Height of the bridge.
+ * @param axis Direction of the bridge.
+ * @param pillar Whether the bridge has a pillar on this tile.
+ */
+static void AddSpriteSorterCheckBridge(std::vector<ParentSpriteToDraw> &sprites, int x, int y, int z, int bridge_z, Axis axis, bool pillar)
+{
+	const int start_z = 3; // BRIDGE_Z_START
+	const bool ax = axis == AXIS_X;
+	AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 1, bridge_z - TILE_HEIGHT + BB_Z_SEPARATOR);
+	AddSpriteSorterCheckSprite(sprites, x, y, ax ? 16 : 1, ax ? 1 : 16, 0x28, bridge_z - start_z, 0, 0, start_z);
+	AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 0, bridge_z);
+	AddSpriteSorterCheckSprite(sprites, x, y, ax ? 16 : 4, ax ? 4 : 16, 0x28, bridge_z - start_z, ax ? 0 : 3, ax ? 3 : 0, start_z);
+	if (!pillar) return;
+
+	const int pillar_z_offset = TILE_HEIGHT - start_z;
+	for (int pz = bridge_z - TILE_HEIGHT; pz >= z; pz -= TILE_HEIGHT) {
+		AddSpriteSorterCheckSprite(sprites, x + (ax ? 0 : 6), y + (ax ? 6 : 0), ax ? 16 : 4, ax ? 4 : 16, BB_HEIGHT_UNDER_BRIDGE - pillar_z_offset, pz, 0, 0, -pillar_z_offset);
+	}
+}
+
+/**
+ * Build one of the sprite sets for checking the sprite sorters.
+ * The sprites are added in the order of a viewport: first the tiles by row and column
+ * like #ViewportAddLandscape does, then the vehicles.
+ * @param scene The sprite set to build.
+ * @param[out] sprites The sprites.
+ */
+static void BuildSpriteSorterCheckScene(SpriteSorterCheckScene scene, std::vector<ParentSpriteToDraw> &sprites)
+{
+	static const int SIZE = 32; ///< Width and height of the scenes in tiles.
+
+	/* Height of the ground in the bridges scene. */
+	auto hill_z = [](int tx, int ty) -> int { return ((tx / 3 + ty / 4) % 4) * TILE_HEIGHT; };
+
+	std::vector<ParentSpriteToDraw> vehicles;
+	Randomizer r;
+	r.SetSeed(scene + 1);
+
+	for (int row = 0; row <= 2 * (SIZE - 1); row++) {
+		for (int tx = min(row, SIZE - 1); tx >= 0 && row - tx < SIZE; tx--) {
+			const int ty = row - tx;
+			const int x = tx * TILE_SIZE;
+			const int y = ty * TILE_SIZE;
+
+			switch (scene) {
+				case SSCS_DENSE_CITY: {
+					const int z = tx < SIZE / 2 ? TILE_HEIGHT : 0;
+					if (tx % 4 == 0 || ty % 4 == 0) {
+						/* Roads, with traffic jams in both lanes; the vehicles in a jam overlap each other. */
+						for (uint i = r.Next(8); i > 0; i--) {
+							const int pos = r.Next(TILE_SIZE);
+							const int lane = r.Next(2) == 0 ? 4 : 12;
+							const int length = 4 + r.Next(5);
+							if (ty % 4 == 0) {
+								/* The road descends to the lower level on the tile after the step. */
+								const int vz = tx == SIZE / 2 ? TILE_HEIGHT - pos / 2 : z;
+								AddSpriteSorterCheckVehicle(vehicles, x + pos, y + lane, vz, AXIS_X, length);
+							} else {
+								AddSpriteSorterCheckVehicle(vehicles, x + lane, y + pos, z, AXIS_Y, length);
+							}
+						}
+						break;
+					}
+
+					/* Foundations at the step between both height levels. */
+					if (tx == SIZE / 2 - 1) AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 7, z - TILE_HEIGHT);
+
+					if (r.Next(5) == 0) {
+						/* A park with some trees. */
+						for (uint i = r.Next(4) + 1; i > 0; i--) {
+							const int dx = r.Next(12) + 2;
+							const int dy = r.Next(12) + 2;
+							AddSpriteSorterCheckSprite(sprites, x + dx, y + dy, TILE_SIZE - dx, TILE_SIZE - dy, 0x30, z, -dx, -dy);
+						}
+					} else if (r.Next(2) == 0) {
+						AddSpriteSorterCheckBuilding(sprites, r, x, y, z);
+					} else if (r.Next(3) == 0) {
+						/* Two small houses. */
+						AddSpriteSorterCheckSprite(sprites, x + 1, y + 1, 7, 14, 10 + r.Next(30), z);
+						AddSpriteSorterCheckSprite(sprites, x + 9, y + 1, 6, 14, 10 + r.Next(30), z);
+					} else {
+						/* A building covering (nearly) the whole tile. */
+						const int border = r.Next(3);
+						AddSpriteSorterCheckSprite(sprites, x + border, y + border, TILE_SIZE - 2 * border, TILE_SIZE - 2 * border, 20 + r.Next(70), z);
+					}
+					break;
+				}
+
+				case SSCS_LARGE_STATION: {
+					/* Twelve platforms along the X axis, surrounded by plain electrified tracks. */
+					const int z = TILE_HEIGHT;
+					if (tx >= 4 && tx < SIZE - 4 && ty >= 4 && ty < 16) {
+						if (tx == SIZE / 2) {
+							/* Station buildings. */
+							AddSpriteSorterCheckSprite(sprites, x, y, 16, 5, 2, z);
+							AddSpriteSorterCheckBuilding(sprites, r, x, y, z);
+						} else {
+							AddSpriteSorterCheckSprite(sprites, x, y, 16, 5, ty % 2 == 0 ? 7 : 2, z);
+						}
+						AddSpriteSorterCheckSprite(sprites, x, y + 11, 16, 5, 2, z);
+						if (ty % 2 == 0) AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 10, z + 16);
+					}
+					/* Catenary wire, with a pylon on every other tile. */
+					AddSpriteSorterCheckSprite(sprites, x, y + 7, 16, 1, 1, z + 10);
+					if (tx % 2 == 0) AddSpriteSorterCheckSprite(sprites, x, y + 15, 1, 1, BB_HEIGHT_UNDER_BRIDGE, z);
+					break;
+				}
+
+				case SSCS_BRIDGES: {
+					const int z = hill_z(tx, ty);
+					if (hill_z(tx + 1, ty) != z || hill_z(tx, ty + 1) != z) {
+						/* Foundation with a small building or trees on top. */
+						AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 7, z);
+						if (r.Next(2) == 0) {
+							AddSpriteSorterCheckSprite(sprites, x + 2, y + 2, 12, 12, 10 + r.Next(20), z + TILE_HEIGHT);
+						} else {
+							AddSpriteSorterCheckSprite(sprites, x + 4, y + 4, 12, 12, 0x30, z + TILE_HEIGHT, -4, -4);
+						}
+					} else if (r.Next(4) == 0) {
+						AddSpriteSorterCheckBuilding(sprites, r, x, y, z);
+					} else if (r.Next(3) == 0) {
+						const int d = r.Next(12) + 2;
+						AddSpriteSorterCheckSprite(sprites, x + d, y + d, TILE_SIZE - d, TILE_SIZE - d, 0x30, z, -d, -d);
+					}
+
+					/* Low bridges along the X axis, and higher ones along the Y axis. */
+					if (ty % 8 == 3 && tx >= 2 && tx < SIZE - 2) {
+						if (tx == 2 || tx == SIZE - 3) {
+							AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 8, z);
+						} else {
+							AddSpriteSorterCheckBridge(sprites, x, y, z, 5 * TILE_HEIGHT, AXIS_X, tx % 3 == 0);
+						}
+					}
+					if (tx % 10 == 6 && ty >= 1 && ty < SIZE - 1) {
+						if (ty == 1 || ty == SIZE - 2) {
+							AddSpriteSorterCheckSprite(sprites, x, y, 16, 16, 8, z);
+						} else {
+							AddSpriteSorterCheckBridge(sprites, x, y, z, 8 * TILE_HEIGHT, AXIS_Y, ty % 4 == 0);
+						}
+					}
+					break;
+				}
+
+				default: NOT_REACHED();
+			}
+		}
+	}
+
+	/* Trains, in the order of their wagons. */
+	switch (scene) {
+		case SSCS_LARGE_STATION:
+			for (int ty = 4; ty < 16; ty++) {
+				if (r.Next(4) == 0) continue;
+				const int start = (4 + r.Next(8)) * TILE_SIZE;
+				for (int i = 8 + r.Next(24); i > 0; i--) {
+					AddSpriteSorterCheckVehicle(vehicles, start + i * 8, ty * TILE_SIZE + 8, TILE_HEIGHT, AXIS_X);
+				}
+			}
+			break;
+
+		case SSCS_BRIDGES:
+			for (int ty = 3; ty < SIZE; ty += 8) {
+				const int start = (3 + r.Next(8)) * TILE_SIZE;
+				for (int i = 8 + r.Next(24); i > 0; i--) {
+					AddSpriteSorterCheckVehicle(vehicles, start + i * 8, ty * TILE_SIZE + 8, 5 * TILE_HEIGHT, AXIS_X);
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	sprites.insert(sprites.end(), vehicles.begin(), vehicles.end());
+}
+
+/**
+ * Check that a sprite sorter sorts the sprites in the same order as #ViewportSortParentSpritesReference, and measure how long it takes.
+ * @param name Name of the sorter.
+ * @param sorter The sorter.
+ * @param input The sprites to sort.
+ * @param reference The sprites sorted by the reference sorter.
+ * @param[in,out] buffer Buffer for the results; it is advanced past the written text.
+ * @param last Last character of the buffer.
+ * @return True iff the sorter sorts the sprites in the same order as the reference.
+ */
+static bool CheckViewportSpriteSorter(const char *name, VpSpriteSorter sorter, const ParentSpriteToSortVector &input, const ParentSpriteToSortVector &reference, char *&buffer, const char *last)
+{
+	static const uint RUNS = 20; ///< Number of times the sprites are sorted, for the timing.
+
+	ParentSpriteToSortVector result;
+	uint64 total = 0;
+	for (uint run = 0; run < RUNS; run++) {
+		result = input;
+		auto start = std::chrono::high_resolution_clock::now();
+		sorter(&result);
+		total += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	uint same = 0;
+	while (same < result.Length() && *result.Get(same) == *reference.Get(same)) same++;
+	if (same == result.Length()) {
+		buffer += seprintf(buffer, last, "  %-8s  %6u us, same order\n", name, (uint)(total / RUNS));
+		return true;
+	}
+	buffer += seprintf(buffer, last, "  %-8s  %6u us, DIFFERENT ORDER from sprite %u\n", name, (uint)(total / RUNS), same);
+	return false;
+}
+
+/**
+ * Check that all available sprite sorters sort the sprite sets of #SpriteSorterCheckScene in exactly
+ * the same order as #ViewportSortParentSpritesReference, and measure how long they take.
+ * Besides the whole sets, a part of #VP_BUCKETED_SORTER_MIN_SPRITES sprites of each set is checked,
+ * which shows whether that threshold still fits.
+ * @param buffer Buffer for the results.
+ * @param last Last character of the buffer.
+ * @return True iff all sorters sort all sprite sets in the same order as the reference.
+ */
+bool CheckViewportSpriteSorters(char *buffer, const char *last)
+{
+	static const char * const scene_names[] = { "dense city", "large station", "bridges and foundations" };
+	assert_compile(lengthof(scene_names) == SSCS_END);
+
+	bool same_order = true;
+	for (uint scene = 0; scene < SSCS_END; scene++) {
+		std::vector<ParentSpriteToDraw> sprites;
+		BuildSpriteSorterCheckScene((SpriteSorterCheckScene)scene, sprites);
+
+		for (uint part = 0; part < 2; part++) {
+			/* The part is taken from the middle of the set, like one band of a viewport. */
+			const uint count = part == 0 ? (uint)sprites.size() : min<uint>(VP_BUCKETED_SORTER_MIN_SPRITES, (uint)sprites.size());
+			const uint first = ((uint)sprites.size() - count) / 2;
+
+			ParentSpriteToSortVector input;
+			for (uint i = first; i < first + count; i++) *input.Append() = &sprites[i];
+			ParentSpriteToSortVector reference = input;
+			ViewportSortParentSpritesReference(&reference);
+
+			buffer += seprintf(buffer, last, "%s, %u sprites:\n", scene_names[scene], count);
+			if (!CheckViewportSpriteSorter("bucketed", &ViewportSortParentSprites, input, reference, buffer, last)) same_order = false;
+			for (const ViewportSSCSS &sorter : _vp_sprite_sorters) {
+				if (!sorter.fct_checker()) continue;
+				if (!CheckViewportSpriteSorter(sorter.name, sorter.fct_sorter, input, reference, buffer, last)) same_order = false;
+			}
+		}
+	}
+	return same_order;
+}
+
 /**
  * Scroll players main viewport.
  * @param tile tile to center viewport on
@@ -38,7 +38,7 @@ struct ParentSpriteToDraw {
 	int32 top;                      ///< minimal screen Y coordinate of sprite (= y + sprite->y_offs), reference point for child sprites
 
 	int32 first_child;              ///< the first child to draw.
-	bool comparison_done;           ///< Used during sprite sorting: true if sprite has been compared with all other sprites
+	uint32 order;                   ///< Used during sprite sorting: position of the sprite in the sorting stack, or the sorting state of the sprite
 };
 
 typedef SmallVector<ParentSpriteToDraw*, 64> ParentSpriteToSortVector;
@@ -25,26 +25,28 @@
 	#define LOAD_128 _mm_loadu_si128
 #endif
 
-/** Sort parent sprites pointer array using SSE4.1 optimizations. */
+/** Sort parent sprites pointer array like ViewportSortParentSpritesReference, using SSE4.1 optimizations. */
 void ViewportSortParentSpritesSSE41(ParentSpriteToSortVector *psdv)
 {
 	const __m128i mask_ptest = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  0,  0,  0);
 	ParentSpriteToDraw ** const psdvend = psdv->End();
 	ParentSpriteToDraw **psd = psdv->Begin();
+	for (ParentSpriteToDraw **it = psd; it != psdvend; it++) (*it)->order = 0;
+
 	while (psd != psdvend) {
 		ParentSpriteToDraw * const ps = *psd;
 
-		if (ps->comparison_done) {
+		if (ps->order != 0) {
 			psd++;
 			continue;
 		}
 
-		ps->comparison_done = true;
+		ps->order = 1;
 
 		for (ParentSpriteToDraw **psd2 = psd + 1; psd2 != psdvend; psd2++) {
 			ParentSpriteToDraw * const ps2 = *psd2;
 
-			if (ps2->comparison_done) continue;
+			if (ps2->order != 0) continue;
 
 			/*
 			 * Decide which comparator to use, based on whether the bounding boxes overlap
@@ -22,6 +22,7 @@ enum FramerateWindowWidgets {
 	WID_FRW_TIMES_NAMES,
 	WID_FRW_TIMES_CURRENT,
 	WID_FRW_TIMES_AVERAGE,
+	WID_FRW_ZONES,
 };
 
 /** Widgets of the #FrametimeGraphWindow class. */
@@ -30,4 +31,13 @@ enum FrametimeGraphWindowWidgets {
 	WID_FGW_GRAPH,
 };
 
+/** Widgets of the #FrameZonesWindow class. */
+enum FrameZonesWindowWidgets {
+	WID_FZW_NAMES,
+	WID_FZW_CALLS,
+	WID_FZW_TOTAL,
+	WID_FZW_SELF,
+	WID_FZW_INFO_DATA_POINTS,
+};
+
 #endif /* WIDGETS_FRAMERATE_WIDGET_H */
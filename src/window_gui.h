@@ -273,6 +273,8 @@ struct ViewportData : ViewPort {
 	int32 scrollpos_y;        ///< Currently shown y coordinate (virtual screen coordinate of topleft corner of the viewport).
 	int32 dest_scrollpos_x;   ///< Current destination x coordinate to display (virtual screen coordinate of topleft corner of the viewport).
 	int32 dest_scrollpos_y;   ///< Current destination y coordinate to display (virtual screen coordinate of topleft corner of the viewport).
+	Rect prefetch_area;       ///< Area around the viewport of which the sprites are being prefetched (virtual screen coordinates).
+	byte prefetch_stage;      ///< Next step of prefetching the sprites of #prefetch_area, see #ViewportPrefetchStage.
 };
 
 struct QueryString;
@@ -718,6 +718,12 @@ enum WindowClass {
 	 */
 	WC_FRAMETIME_GRAPH,
 
+	/**
+	 * Profiling zones; %Window numbers:
+	 *   - 0 = #FrameZonesWindowWidgets
+	 */
+	WC_FRAME_ZONES,
+
 	/**
 	 * Trace restrict programme window; %Window numbers:
 	 *   - #TileIndex << 3 | #Track = #TraceRestrictWindow